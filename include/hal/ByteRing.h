@@ -0,0 +1,129 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+namespace ssr {
+
+  /***************************************************
+   * ByteRing
+   *
+   * @brief Bounded lock-free byte ring for one producer thread and one consumer thread.
+   *
+   * push(), prepare() / commit() and getFreeSize() are called only by the producer,
+   * pop(), peek() / consume() and clear() only by the consumer.
+   * The capacity is rounded up to a power of two and allocated once in the constructor.
+   ***************************************************/
+  class ByteRing {
+  private:
+    std::vector<uint8_t> m_Buffer;
+    size_t m_Mask;
+    alignas(64) std::atomic<size_t> m_Head; // next byte to pop (consumer)
+    alignas(64) std::atomic<size_t> m_Tail; // next byte to push (producer)
+
+  public:
+    ByteRing(const size_t capacity) : m_Head(0), m_Tail(0) {
+      size_t size = 1;
+      while (size < capacity) {
+        size <<= 1;
+      }
+      m_Buffer.resize(size);
+      m_Mask = size - 1;
+    }
+
+    ByteRing(const ByteRing &) = delete;
+    ByteRing &operator=(const ByteRing &) = delete;
+
+  public:
+    /**
+     * @brief Append up to size bytes.
+     * @return number of bytes appended, less than size if the ring is full.
+     */
+    size_t push(const uint8_t *src, const size_t size) {
+      const size_t tail = m_Tail.load(std::memory_order_relaxed);
+      const size_t n = std::min(size, capacity() - (tail - m_Head.load(std::memory_order_acquire)));
+      const size_t offset = tail & m_Mask;
+      const size_t first = std::min(n, capacity() - offset);
+      memcpy(m_Buffer.data() + offset, src, first);
+      memcpy(m_Buffer.data(), src + first, n - first);
+      m_Tail.store(tail + n, std::memory_order_release);
+      return n;
+    }
+
+    /**
+     * @brief Contiguous free space to fill in place (e.g. by recv()), up to the end of the storage.
+     * @param writable receives the number of bytes that may be written at the returned pointer.
+     */
+    uint8_t *prepare(size_t &writable) {
+      const size_t tail = m_Tail.load(std::memory_order_relaxed);
+      const size_t offset = tail & m_Mask;
+      writable = std::min(capacity() - (tail - m_Head.load(std::memory_order_acquire)), capacity() - offset);
+      return m_Buffer.data() + offset;
+    }
+
+    /**
+     * @brief Publish size bytes written at the pointer returned by prepare().
+     */
+    void commit(const size_t size) {
+      m_Tail.store(m_Tail.load(std::memory_order_relaxed) + size, std::memory_order_release);
+    }
+
+    /**
+     * @brief Remove up to size bytes into dst.
+     * @return number of bytes removed.
+     */
+    size_t pop(uint8_t *dst, const size_t size) {
+      const size_t head = m_Head.load(std::memory_order_relaxed);
+      const size_t n = std::min(size, m_Tail.load(std::memory_order_acquire) - head);
+      const size_t offset = head & m_Mask;
+      const size_t first = std::min(n, capacity() - offset);
+      memcpy(dst, m_Buffer.data() + offset, first);
+      memcpy(dst + first, m_Buffer.data(), n - first);
+      m_Head.store(head + n, std::memory_order_release);
+      return n;
+    }
+
+    /**
+     * @brief Contiguous bytes to send in place (e.g. by send()), up to the end of the storage.
+     * @param readable receives the number of bytes at the returned pointer.
+     */
+    const uint8_t *peek(size_t &readable) const {
+      const size_t head = m_Head.load(std::memory_order_relaxed);
+      const size_t offset = head & m_Mask;
+      readable = std::min(m_Tail.load(std::memory_order_acquire) - head, capacity() - offset);
+      return m_Buffer.data() + offset;
+    }
+
+    /**
+     * @brief Remove size bytes returned by peek().
+     */
+    void consume(const size_t size) {
+      m_Head.store(m_Head.load(std::memory_order_relaxed) + size, std::memory_order_release);
+    }
+
+    /**
+     * @brief Discard every byte pushed so far.
+     */
+    void clear() {
+      m_Head.store(m_Tail.load(std::memory_order_acquire), std::memory_order_release);
+    }
+
+    size_t getSize() const {
+      // Head first: the tail read afterwards is never behind it.
+      const size_t head = m_Head.load(std::memory_order_acquire);
+      return std::min(m_Tail.load(std::memory_order_acquire) - head, capacity());
+    }
+
+    size_t getFreeSize() const {
+      return capacity() - (m_Tail.load(std::memory_order_relaxed) - m_Head.load(std::memory_order_acquire));
+    }
+
+    size_t capacity() const {
+      return m_Mask + 1;
+    }
+  };
+
+};//namespace ssr
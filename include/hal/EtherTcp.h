@@ -2,8 +2,12 @@
 
 #include <exception>
 #include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
 #include "SerialDevice.h"
 #include "Socket.h"
+#include "ByteRing.h"
 
 
 namespace ssr {
@@ -14,10 +18,37 @@ namespace ssr {
    * @brief Portable Serial Port Class
    ***************************************************/
   class EtherTcp : public SerialDevice {
+  public:
+    /**
+     * @brief Who moves bytes from the socket into Rx Buffer.
+     */
+    enum ReceiveMode {
+      RECEIVE_THREAD,  // a thread per instance polls the socket
+      RECEIVE_ON_READ, // getSizeInRxBuffer() / read() recv() without blocking; waitRxReady() sleeps on the socket fd
+    };
+
+    /**
+     * @brief What the receive thread does when the Rx buffer is full.
+     * RECEIVE_ON_READ never overflows: bytes which do not fit stay in the socket.
+     */
+    enum OverflowPolicy {
+      OVERFLOW_BACKPRESSURE, // stop reading the socket until the buffer drains (TCP flow control slows the sender)
+      OVERFLOW_DROP,         // keep reading and discard what does not fit (counted in getDroppedSize())
+    };
+
+    static const size_t DEFAULT_RX_BUFFER_SIZE = 4096;
+
   private:
-    int m_Endflag;
+    ReceiveMode m_ReceiveMode;
+    std::atomic<int> m_Endflag;
+    bool m_Closed; // RECEIVE_ON_READ: the peer closed the connection
     ssr::Socket *m_pSocket;
     std::thread m_thread;
+    ByteRing m_RxBuffer; // receive thread -> reader, one per instance
+    OverflowPolicy m_OverflowPolicy;
+    std::atomic<uint64_t> m_DroppedSize;
+    std::mutex m_RxMutex; // only to sleep on m_RxReady
+    std::condition_variable m_RxReady;
     
   public:
     /**
@@ -25,8 +56,11 @@ namespace ssr {
      * 
      * @param ipaddress Ip Address of target device
      * @param port port number.
+     * @param receiveMode RECEIVE_ON_READ to receive on the calling thread, without a thread per instance.
+     * @param rxBufferSize capacity of Rx Buffer (rounded up to a power of two).
+     * @param overflowPolicy what to do with received bytes when Rx Buffer is full.
      */
-    EtherTcp(const char* ipadderss, int port);
+    EtherTcp(const char* ipadderss, int port, const ReceiveMode receiveMode = RECEIVE_THREAD, const size_t rxBufferSize = DEFAULT_RX_BUFFER_SIZE, const OverflowPolicy overflowPolicy = OVERFLOW_BACKPRESSURE);
     
     /**
      * @brief Destructor
@@ -59,15 +93,51 @@ namespace ssr {
      */
     RETVAL write(const uint8_t* src, const uint8_t size);
 
+    /**
+     * @brief write data to Tx Buffer, held until the next write() (MSG_MORE).
+     */
+    RETVAL writeMore(const uint8_t* src, const uint8_t size);
+
     /**
      * @brief read data from RxBuffer of Serial Port 
      */
     RETVAL read(uint8_t *dst, const uint8_t size);
 
     RETVAL getSenderInfo(uint8_t *buffer);
+
+    /**
+     * @brief Socket descriptor in RECEIVE_ON_READ mode, -1 with the receive thread.
+     */
+    int getFileDescriptor();
+
+    /**
+     * @brief Sleep until Rx Buffer has data or timeout expires.
+     * @return negative once the connection is closed and Rx Buffer is empty.
+     */
+    RETVAL waitRxReady(const uint32_t timeout_usec);
+
+    /**
+     * @brief Socket, to tune keepalive and buffer sizes. TCP_NODELAY and quick-ack are set by the constructor.
+     */
+    ssr::Socket &getSocket() {
+      return *m_pSocket;
+    }
+
+    /**
+     * @brief Number of received bytes discarded by OVERFLOW_DROP.
+     */
+    uint64_t getDroppedSize() const {
+      return m_DroppedSize.load(std::memory_order_relaxed);
+    }
     
   public:
     virtual int svc(void);
+
+  private:
+    /**
+     * @brief RECEIVE_ON_READ: move what has arrived in the socket into Rx Buffer.
+     */
+    void receive();
   };
   
 };//namespace ssr
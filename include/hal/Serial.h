@@ -65,6 +65,11 @@ namespace ssr
                   buffer[0] = 'U', buffer[1] = 'A', buffer[2] = 'R', buffer[3] = 'T';
                   return 0;
             }
+
+            virtual int getFileDescriptor()
+            {
+                  return m_pSerialPort->getFileDescriptor();
+            }
       };
 
 }
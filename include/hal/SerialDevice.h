@@ -2,6 +2,13 @@
 
 
 #include <stdint.h>
+#include <thread>
+#include <chrono>
+
+#ifndef WIN32
+#include <sys/select.h>
+#include <errno.h>
+#endif
 
 namespace ssr {
   
@@ -42,6 +49,16 @@ namespace ssr {
      */
     virtual RETVAL write(const uint8_t* src, const uint8_t size)  = 0;
     
+    /**
+     * @brief write data which the rest of the same frame follows in the next write.
+     *
+     * Stream devices hold it back so that the whole frame leaves at once (e.g. one TCP segment).
+     * Others just write it.
+     */
+    virtual RETVAL writeMore(const uint8_t* src, const uint8_t size) {
+      return write(src, size);
+    }
+    
     /**
      * @brief read data from RxBuffer of Serial Port 
      */
@@ -50,5 +67,50 @@ namespace ssr {
     /**
      */
     virtual RETVAL getSenderInfo(uint8_t* buffer) = 0;
+
+  public:
+    /**
+     * @brief Get file descriptor which becomes readable when data arrives.
+     * @return file descriptor, or -1 if the device does not have one.
+     */
+    virtual int getFileDescriptor() {
+      return -1;
+    }
+
+    /**
+     * @brief Sleep until Rx Buffer has data or timeout expires.
+     * @param timeout_usec timeout in micro seconds.
+     * @return positive if data is available, zero if timeout, negative if error.
+     */
+    virtual RETVAL waitRxReady(const uint32_t timeout_usec) {
+#ifndef WIN32
+      const int fd = getFileDescriptor();
+      if (fd >= 0) {
+        fd_set fds;
+        FD_ZERO(&fds);
+        FD_SET(fd, &fds);
+        struct timeval timeout;
+        timeout.tv_sec = timeout_usec / 1000000;
+        timeout.tv_usec = timeout_usec % 1000000;
+        int res = select(fd + 1, &fds, NULL, NULL, &timeout);
+        if (res < 0) {
+          return errno == EINTR ? 0 : -1;
+        }
+        return res;
+      }
+#endif
+      // No descriptor to sleep on. Fall back to coarse polling.
+      const uint32_t POLLING_INTERVAL_USEC = 100;
+      auto start = std::chrono::steady_clock::now();
+      while (getSizeInRxBuffer() <= 0) {
+        auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+        if (elapsed >= timeout_usec) {
+          return 0;
+        }
+        auto rest = timeout_usec - elapsed;
+        std::this_thread::sleep_for(std::chrono::microseconds(rest < POLLING_INTERVAL_USEC ? rest : POLLING_INTERVAL_USEC));
+      }
+      return 1;
+    }
   };
 };
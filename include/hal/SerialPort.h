@@ -130,6 +130,12 @@ namespace net {
 			 			 */
 			int read(void *dst, const unsigned int size);
 
+			/**
+			 * @brief file descriptor of the port for readiness waiting.
+			 * @return -1 if the platform does not use file descriptor (Windows).
+			 */
+			int getFileDescriptor();
+
 		};
 
 	};//namespace ysuga
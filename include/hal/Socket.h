@@ -17,6 +17,7 @@
 #include <string.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <netdb.h>
 #include <sys/ioctl.h>
 #include <poll.h>
@@ -102,6 +103,7 @@ namespace ssr
       {
       private:
             bool okay_;
+            bool quickAck_; // re-armed after every recv, since the kernel leaves quick-ack mode on its own
 
 #ifdef WIN32
 
@@ -189,19 +191,19 @@ namespace ssr
             }
 
       public:
-            Socket()
+            Socket() : quickAck_(false)
             {
             }
 
             /**
              * Constructor
              */
-            Socket(const char *address, const uint32_t port) : okay_(false)
+            Socket(const char *address, const uint32_t port) : okay_(false), quickAck_(false)
             {
                   connect(address, port);
             }
 
-            Socket(const Socket &socket) : okay_(false)
+            Socket(const Socket &socket) : okay_(false), quickAck_(false)
             {
                   copyFrom(socket);
             }
@@ -272,24 +274,26 @@ namespace ssr
             {
 #ifdef WIN32
                   okay_ = socket.okay_;
+                  quickAck_ = socket.quickAck_;
                   m_SockAddr = socket.m_SockAddr;
                   m_Socket = socket.m_Socket;
 
 #else // WIN32
                   okay_ = socket.okay_;
+                  quickAck_ = socket.quickAck_;
                   m_SockAddr = socket.m_SockAddr;
                   m_Socket = socket.m_Socket;
 #endif
             }
 
 #ifdef WIN32
-            Socket(SOCKET hsocket, struct sockaddr_in sockaddr_) : okay_(true)
+            Socket(SOCKET hsocket, struct sockaddr_in sockaddr_) : okay_(true), quickAck_(false)
             {
                   m_Socket = hsocket;
                   m_SockAddr = sockaddr_;
             }
 #else // WIN32
-            Socket(int hsocket, struct sockaddr_in &sockaddr_) : okay_(true)
+            Socket(int hsocket, struct sockaddr_in &sockaddr_) : okay_(true), quickAck_(false)
             {
                   m_Socket = hsocket;
                   m_SockAddr = sockaddr_;
@@ -325,6 +329,71 @@ namespace ssr
 #endif
             }
 
+            /**
+             * Send small writes at once instead of holding them until the previous segment is acknowledged (Nagle).
+             */
+            int setNoDelay(const bool enable)
+            {
+                  const int value = enable ? 1 : 0;
+                  return setsockopt(m_Socket, IPPROTO_TCP, TCP_NODELAY, (const char *)&value, sizeof(value));
+            }
+
+            /**
+             * Acknowledge received segments at once instead of delaying the ACK (Linux only, no-op elsewhere).
+             */
+            int setQuickAck(const bool enable)
+            {
+                  quickAck_ = enable;
+                  return armQuickAck();
+            }
+
+            /**
+             * Probe an idle connection so that a vanished peer is noticed. Zero leaves the system default.
+             */
+            int setKeepAlive(const bool enable, const int idleSec = 0, const int intervalSec = 0, const int count = 0)
+            {
+                  const int value = enable ? 1 : 0;
+                  int ret = setsockopt(m_Socket, SOL_SOCKET, SO_KEEPALIVE, (const char *)&value, sizeof(value));
+#ifdef __linux__
+                  if (ret == 0 && enable && idleSec > 0)
+                  {
+                        ret = setsockopt(m_Socket, IPPROTO_TCP, TCP_KEEPIDLE, &idleSec, sizeof(idleSec));
+                  }
+                  if (ret == 0 && enable && intervalSec > 0)
+                  {
+                        ret = setsockopt(m_Socket, IPPROTO_TCP, TCP_KEEPINTVL, &intervalSec, sizeof(intervalSec));
+                  }
+                  if (ret == 0 && enable && count > 0)
+                  {
+                        ret = setsockopt(m_Socket, IPPROTO_TCP, TCP_KEEPCNT, &count, sizeof(count));
+                  }
+#endif
+                  return ret;
+            }
+
+            int setSendBufferSize(const int size)
+            {
+                  return setsockopt(m_Socket, SOL_SOCKET, SO_SNDBUF, (const char *)&size, sizeof(size));
+            }
+
+            int setReceiveBufferSize(const int size)
+            {
+                  return setsockopt(m_Socket, SOL_SOCKET, SO_RCVBUF, (const char *)&size, sizeof(size));
+            }
+
+            /**
+             * Hold partial segments until uncorked (Linux only, no-op elsewhere). Uncorking sends what is held.
+             */
+            int setCork(const bool enable)
+            {
+#ifdef __linux__
+                  const int value = enable ? 1 : 0;
+                  return setsockopt(m_Socket, IPPROTO_TCP, TCP_CORK, &value, sizeof(value));
+#else
+                  return 0;
+#endif
+            }
+
             int getSizeInRxBuffer()
             {
 #ifdef WIN32
@@ -354,15 +423,75 @@ namespace ssr
 #endif
             }
 
+            /**
+             * Write bytes which more bytes of the same frame will follow, so that they leave in one segment
+             * with the next write() (MSG_MORE on Linux, a plain write elsewhere).
+             */
+            int writeMore(const void *src, const unsigned int size)
+            {
+#ifdef MSG_MORE
+                  return send(m_Socket, src, size, MSG_MORE);
+#else
+                  return write(src, size);
+#endif
+            }
+
             int read(void *dst, const unsigned int size)
             {
 #ifdef WIN32
                   return ::recv(m_Socket, (char *)dst, size, 0);
 #else
-                  return recv(m_Socket, dst, size, 0);
+                  const int ret = recv(m_Socket, dst, size, 0);
+                  armQuickAck();
+                  return ret;
 #endif
             }
 
+            /**
+             * Read what has arrived without blocking.
+             * @return number of bytes read, 0 if the peer closed the connection, -1 if nothing arrived (or on error).
+             */
+            int readNonBlocking(void *dst, const unsigned int size)
+            {
+#ifdef WIN32
+                  unsigned long count;
+                  if (::ioctlsocket(m_Socket, FIONREAD, &count) != 0 || count == 0)
+                  {
+                        return -1;
+                  }
+                  return ::recv(m_Socket, (char *)dst, size < count ? size : count, 0);
+#else
+                  const int ret = recv(m_Socket, dst, size, MSG_DONTWAIT);
+                  if (ret > 0)
+                  {
+                        armQuickAck();
+                  }
+                  return ret;
+#endif
+            }
+
+            /**
+             * Descriptor to wait for readiness with select() / poll().
+             */
+            int getFileDescriptor() const
+            {
+                  return (int)m_Socket;
+            }
+
+      private:
+            int armQuickAck()
+            {
+#ifdef TCP_QUICKACK
+                  if (quickAck_)
+                  {
+                        const int value = 1;
+                        return setsockopt(m_Socket, IPPROTO_TCP, TCP_QUICKACK, &value, sizeof(value));
+                  }
+#endif
+                  return 0;
+            }
+
+      public:
             int close()
             {
 #ifdef WIN32
@@ -0,0 +1,274 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <vector>
+#include <type_traits>
+
+#include "result.h"
+#include "profile.h"
+#include "type_code.h"
+
+namespace ssr::rtno2
+{
+
+    /**
+     * Bulk conversion kernels. SSE2 / NEON where available, plain loops otherwise.
+     * dst / src need no alignment.
+     */
+    void codec_narrow_double(uint8_t *dst, const double *src, const size_t count); // double -> 4-byte float
+    void codec_widen_float(double *dst, const uint8_t *src, const size_t count);   // 4-byte float -> double
+    void codec_octet_to_bool(bool *dst, const uint8_t *src, const size_t count);   // any non-zero octet -> true
+    void codec_pack_bool(uint8_t *dst, const bool *src, const size_t count);       // 8 bools per byte, LSB first
+    void codec_unpack_bool(bool *dst, const uint8_t *src, const size_t count);
+
+    /**
+     * @brief Wire width of one element of typecode sent to / received from a board of arch.
+     *
+     * This is the wire_width of the TYPECODE table, except that AVR exchanges TimedDouble(Seq) as 4-byte float.
+     * @return 0 if typecode is unknown.
+     */
+    inline uint8_t wire_width(const TYPECODE typecode, const Architecture arch)
+    {
+        uint8_t width = 0;
+        visit_port(typecode, [&](auto traits)
+                   {
+            using traits_type = decltype(traits);
+            width = (arch == Architecture::AVR && std::is_same_v<typename traits_type::element_type, double>) ? sizeof(float) : traits_type::wire_width; });
+        return width;
+    }
+
+    /**
+     * Conversion of elements between the host type E and their bytes on the wire.
+     *
+     * width is the wire width of one element (see wire_width()). Elements whose wire width equals sizeof(E)
+     * are copied as is; double narrows to / widens from float, and octets decode to bool.
+     */
+    template <typename E>
+    struct element_codec
+    {
+        static uint8_t wire_width(const Architecture) { return sizeof(E); }
+        static void encode(uint8_t *dst, const E *src, const size_t count, const uint8_t) { memcpy(dst, src, count * sizeof(E)); }
+        static void decode(E *dst, const uint8_t *src, const size_t count, const uint8_t) { memcpy(dst, src, count * sizeof(E)); }
+    };
+
+    template <>
+    struct element_codec<bool>
+    {
+        static uint8_t wire_width(const Architecture) { return typecode_traits<TYPECODE::TIMED_BOOLEAN>::wire_width; }
+        static void encode(uint8_t *dst, const bool *src, const size_t count, const uint8_t)
+        {
+            static_assert(sizeof(bool) == 1, "bool is sent as one octet");
+            memcpy(dst, src, count);
+        }
+        static void decode(bool *dst, const uint8_t *src, const size_t count, const uint8_t) { codec_octet_to_bool(dst, src, count); }
+    };
+
+    template <>
+    struct element_codec<double>
+    {
+        static uint8_t wire_width(const Architecture arch) { return ssr::rtno2::wire_width(TYPECODE::TIMED_DOUBLE, arch); }
+        static void encode(uint8_t *dst, const double *src, const size_t count, const uint8_t width)
+        {
+            if (width == sizeof(float))
+            {
+                codec_narrow_double(dst, src, count);
+                return;
+            }
+            memcpy(dst, src, count * sizeof(double));
+        }
+        static void decode(double *dst, const uint8_t *src, const size_t count, const uint8_t width)
+        {
+            if (width == sizeof(float))
+            {
+                codec_widen_float(dst, src, count);
+                return;
+            }
+            memcpy(dst, src, count * sizeof(double));
+        }
+    };
+
+    /**
+     * Payload layout of port values exchanged with one board.
+     *
+     * A sequence is count * width bytes. With packed_bool, TimedBooleanSeq is count | bits[(count + 7) / 8]
+     * instead, element i in bit i % 8 of byte i / 8 (see CAPABILITY_PACKED_BOOLEAN_SEQ), so it holds at most 255 elements.
+     */
+    struct wire_format_t
+    {
+        uint8_t width;
+        bool packed_bool;
+    };
+
+    static const size_t PACKED_BOOL_MAX_COUNT = 255;
+
+    template <typename T>
+    struct value_element
+    {
+        typedef T type;
+    };
+
+    template <typename E>
+    struct value_element<std::vector<E>>
+    {
+        typedef E type;
+    };
+
+    /**
+     * @brief Payload size of count elements, or SIZE_MAX if count cannot be encoded.
+     */
+    inline size_t sequence_size(const size_t count, const wire_format_t &format)
+    {
+        if (format.packed_bool)
+        {
+            return count <= PACKED_BOOL_MAX_COUNT ? 1 + (count + 7) / 8 : SIZE_MAX;
+        }
+        return count * format.width;
+    }
+
+    /**
+     * @brief Number of elements in a sequence payload, or -1 if the payload is malformed.
+     */
+    inline int sequence_count(const uint8_t *src, const size_t size, const wire_format_t &format)
+    {
+        if (format.packed_bool)
+        {
+            return (size >= 1 && size == sequence_size(src[0], format)) ? src[0] : -1;
+        }
+        return (format.width > 0 && size % format.width == 0) ? static_cast<int>(size / format.width) : -1;
+    }
+
+    /**
+     * @brief Encode count elements. dst must hold sequence_size(count, format) bytes.
+     */
+    template <typename E>
+    inline void encode_sequence(uint8_t *dst, const E *src, const size_t count, const wire_format_t &format)
+    {
+        if constexpr (std::is_same_v<E, bool>)
+        {
+            if (format.packed_bool)
+            {
+                dst[0] = static_cast<uint8_t>(count);
+                codec_pack_bool(dst + 1, src, count);
+                return;
+            }
+        }
+        element_codec<E>::encode(dst, src, count, format.width);
+    }
+
+    template <typename E>
+    inline void encode_sequence(uint8_t *dst, const std::vector<E> &src, const size_t count, const wire_format_t &format)
+    {
+        encode_sequence(dst, src.data(), count, format);
+    }
+
+    inline void encode_sequence(uint8_t *dst, const std::vector<bool> &src, const size_t count, const wire_format_t &format)
+    {
+        if (format.packed_bool)
+        {
+            dst[0] = static_cast<uint8_t>(count);
+            memset(dst + 1, 0, (count + 7) / 8);
+            for (size_t i = 0; i < count; i++)
+            {
+                dst[1 + i / 8] |= (src[i] ? 1 : 0) << (i % 8);
+            }
+            return;
+        }
+        for (size_t i = 0; i < count; i++)
+        {
+            dst[i] = src[i] ? 1 : 0;
+        }
+    }
+
+    /**
+     * @brief Decode count elements (from sequence_count()) of a sequence payload.
+     */
+    template <typename E>
+    inline void decode_sequence(E *dst, const uint8_t *src, const size_t count, const wire_format_t &format)
+    {
+        if constexpr (std::is_same_v<E, bool>)
+        {
+            if (format.packed_bool)
+            {
+                codec_unpack_bool(dst, src + 1, count);
+                return;
+            }
+        }
+        element_codec<E>::decode(dst, src, count, format.width);
+    }
+
+    /**
+     * Conversion of a whole port value (scalar or std::vector) to / from its payload bytes.
+     */
+    template <typename T>
+    struct value_codec
+    {
+        /**
+         * @return number of bytes written, or -1 if the value does not fit in max_size.
+         */
+        static int encode(uint8_t *dst, const size_t max_size, const T &value, const wire_format_t &format)
+        {
+            if (format.width > max_size)
+            {
+                return -1;
+            }
+            element_codec<T>::encode(dst, &value, 1, format.width);
+            return format.width;
+        }
+
+        static result_t<T> decode(const uint8_t *src, const size_t size, const wire_format_t &format)
+        {
+            if (size != format.width)
+            {
+                return RESULT::ERR;
+            }
+            T value;
+            element_codec<T>::decode(&value, src, 1, format.width);
+            return value;
+        }
+    };
+
+    template <typename E>
+    struct value_codec<std::vector<E>>
+    {
+        static int encode(uint8_t *dst, const size_t max_size, const std::vector<E> &value, const wire_format_t &format)
+        {
+            const size_t size = sequence_size(value.size(), format);
+            if (size > max_size)
+            {
+                return -1;
+            }
+            encode_sequence(dst, value, value.size(), format);
+            return static_cast<int>(size);
+        }
+
+        static result_t<std::vector<E>> decode(const uint8_t *src, const size_t size, const wire_format_t &format)
+        {
+            const int count = sequence_count(src, size, format);
+            if (count < 0)
+            {
+                return RESULT::ERR;
+            }
+            std::vector<E> value(count);
+            decode_sequence(value.data(), src, count, format);
+            return value;
+        }
+    };
+
+    template <>
+    inline result_t<std::vector<bool>> value_codec<std::vector<bool>>::decode(const uint8_t *src, const size_t size, const wire_format_t &format)
+    {
+        const int count = sequence_count(src, size, format);
+        if (count < 0)
+        {
+            return RESULT::ERR;
+        }
+        std::vector<bool> value(count);
+        for (int i = 0; i < count; i++)
+        {
+            value[i] = format.packed_bool ? ((src[1 + i / 8] >> (i % 8)) & 1) != 0 : src[i] != 0;
+        }
+        return value;
+    }
+}
@@ -25,6 +25,9 @@ namespace ssr::rtno2
 
         SEND_DATA = 'S',
         RECEIVE_DATA = 'G',
+        SEND_DATA_FRAGMENT = 's',
+        RECEIVE_DATA_FRAGMENT = 'g',
+        BATCH_CYCLE = 'Y',
 
         RECEIVE_LOG = 'L',
 
@@ -70,6 +73,12 @@ namespace ssr::rtno2
             return "COMMAND::SEND_DATA";
         case COMMAND::RECEIVE_DATA:
             return "COMMAND::RECEIVE_DATA";
+        case COMMAND::SEND_DATA_FRAGMENT:
+            return "COMMAND::SEND_DATA_FRAGMENT";
+        case COMMAND::RECEIVE_DATA_FRAGMENT:
+            return "COMMAND::RECEIVE_DATA_FRAGMENT";
+        case COMMAND::BATCH_CYCLE:
+            return "COMMAND::BATCH_CYCLE";
 
         case COMMAND::RECEIVE_LOG:
             return "COMMAND::RECEIVE_LOG";
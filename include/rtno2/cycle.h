@@ -0,0 +1,145 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include <span>
+
+#include "packet.h"
+#include "result.h"
+#include "profile.h"
+
+namespace ssr::rtno2
+{
+
+	static const uint8_t BATCH_EXECUTE = 0x01; // flags of BATCH_CYCLE request
+
+	/**
+	 * One control cycle (inport writes, EXECUTE, outport reads) for protocol_t::run_cycle().
+	 *
+	 * With CAPABILITY_BATCH_CYCLE the whole cycle is a single BATCH_CYCLE round trip. Ports are addressed
+	 * by their index in the profile (port_id_t::index), which is the order RTno reported them in:
+	 *
+	 * BATCH_CYCLE request : flags | write_count | { inport_id | data_len | data[data_len] }* | read_count | { outport_id }*
+	 * BATCH_CYCLE reply   : write_count | { RESULT }* | RESULT of EXECUTE | read_count | { outport_id | RESULT | data_len | data[data_len] }*
+	 *
+	 * flags is BATCH_EXECUTE or 0 (RESULT of EXECUTE is then RESULT::NONE). An outport value which does not fit
+	 * in the reply is answered with RESULT::NONE, and run_cycle() reads it with RECEIVE_DATA afterwards.
+	 * Without the capability, or if the request does not fit in one packet, the cycle runs as a pipeline_t.
+	 *
+	 * ex:
+	 *   cycle_t c;
+	 *   c.send_inport_data(in0, data, 4).execute().receive_all_outports(profile);
+	 *   protocol.run_cycle(c, deadline_after(20 * 1000));
+	 *   auto value = c.value(0);
+	 */
+	class cycle_t
+	{
+	public:
+		struct write_t
+		{
+			port_id_t port;
+			size_t offset; // in values_
+			uint8_t length;
+			RESULT result;
+		};
+
+		struct read_t
+		{
+			port_id_t port;
+			uint8_t size;
+			RESULT result;
+		};
+
+	private:
+		std::vector<write_t> writes_;
+		std::vector<uint8_t> values_;
+		bool execute_;
+		RESULT execute_result_;
+		std::vector<read_t> reads_;
+		std::vector<uint8_t> read_values_; // PACKET_MAX_DATA_SIZE bytes per read
+
+	public:
+		cycle_t() : execute_(false), execute_result_(RESULT::UNINITIALIZED) {}
+
+	public:
+		/**
+		 * @brief Add a write to inport. data is copied.
+		 */
+		cycle_t &send_inport_data(const port_id_t port, const uint8_t *data, const uint8_t length);
+		cycle_t &execute();
+		cycle_t &receive_outport_data(const port_id_t port);
+
+		/**
+		 * @brief Add a read of every outport in profile, in profile order.
+		 *
+		 * profile must be the one run_cycle() will use (protocol_t::get_profile()), or the ids are rejected as stale.
+		 */
+		cycle_t &receive_all_outports(const profile_t &profile);
+
+	public:
+		/**
+		 * @brief Keep the capacity, so a cycle rebuilt every period does not allocate.
+		 */
+		void clear();
+
+		size_t write_count() const { return writes_.size(); }
+		size_t read_count() const { return reads_.size(); }
+		bool executes() const { return execute_; }
+		const std::vector<write_t> &writes() const { return writes_; }
+		const std::vector<read_t> &reads() const { return reads_; }
+
+		/**
+		 * @brief Results after run_cycle(). RESULT::UNINITIALIZED before.
+		 */
+		RESULT write_result(const size_t index) const { return writes_[index].result; }
+		RESULT execute_result() const { return execute_result_; }
+		RESULT read_result(const size_t index) const { return reads_[index].result; }
+
+		/**
+		 * @brief Value read by index-th read. Valid until the cycle is modified.
+		 */
+		std::span<const uint8_t> value(const size_t index) const
+		{
+			return std::span<const uint8_t>(read_values_.data() + index * PACKET_MAX_DATA_SIZE, reads_[index].size);
+		}
+
+		std::span<const uint8_t> write_value(const size_t index) const
+		{
+			return std::span<const uint8_t>(values_.data() + writes_[index].offset, writes_[index].length);
+		}
+
+		/**
+		 * @brief First result other than RESULT::OK, in request order.
+		 */
+		RESULT result() const;
+
+	public:
+		/**
+		 * @brief Encode BATCH_CYCLE request.
+		 * @return false if a port id exceeds 255 or the request does not fit in one packet.
+		 */
+		bool encode(packet_t &packet) const;
+
+		/**
+		 * @brief Parse BATCH_CYCLE reply and store the results and values.
+		 * @return RESULT::OK, or RESULT::ERR if the reply is malformed or does not answer this cycle.
+		 */
+		RESULT decode(const packet_t &reply);
+
+		/**
+		 * @brief Store the result of a cycle run by other means (pipeline, individual requests).
+		 */
+		void set_write_result(const size_t index, const RESULT result) { writes_[index].result = result; }
+		void set_execute_result(const RESULT result) { execute_result_ = result; }
+		void set_read_result(const size_t index, const RESULT result, const uint8_t size)
+		{
+			reads_[index].result = result;
+			reads_[index].size = size;
+		}
+
+		/**
+		 * @brief Buffer (PACKET_MAX_DATA_SIZE bytes) receiving the value of index-th read.
+		 */
+		uint8_t *read_buffer(const size_t index) { return read_values_.data() + index * PACKET_MAX_DATA_SIZE; }
+	};
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+namespace ssr::rtno2
+{
+
+    /**
+     * All timeouts in rtno2 are measured with a monotonic clock, so that
+     * wall clock adjustment (NTP, manual setting) never shortens or extends a wait.
+     */
+    using monotonic_clock = std::chrono::steady_clock;
+    using deadline_t = monotonic_clock::time_point;
+
+    static const uint32_t WAIT_INFINITE = UINT32_MAX;
+
+    /**
+     * @brief Convert relative wait time into absolute deadline.
+     * @param wait_usec wait time in micro seconds. WAIT_INFINITE means no deadline.
+     */
+    inline deadline_t deadline_after(const uint32_t wait_usec)
+    {
+        if (wait_usec == WAIT_INFINITE)
+        {
+            return deadline_t::max();
+        }
+        return monotonic_clock::now() + std::chrono::microseconds(wait_usec);
+    }
+
+    /**
+     * @brief Remaining time until deadline in micro seconds. Zero if expired.
+     */
+    inline uint32_t remaining_usec(const deadline_t deadline)
+    {
+        if (deadline == deadline_t::max())
+        {
+            return WAIT_INFINITE;
+        }
+        auto now = monotonic_clock::now();
+        if (now >= deadline)
+        {
+            return 0;
+        }
+        auto usec = std::chrono::duration_cast<std::chrono::microseconds>(deadline - now).count();
+        return usec >= WAIT_INFINITE ? WAIT_INFINITE - 1 : static_cast<uint32_t>(usec);
+    }
+
+    inline bool is_expired(const deadline_t deadline)
+    {
+        return deadline != deadline_t::max() && monotonic_clock::now() >= deadline;
+    }
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+
+#include "packet.h"
+#include "result.h"
+
+#define PACKET_START_BYTE 0x0a
+#define FRAME_V2_MARK 0xa5
+#define FRAME_V2_HEADER_SIZE 6 // frame id, COMMAND, RESULT, length (2)
+#define FRAME_V2_CRC_SIZE 2
+
+namespace ssr::rtno2
+{
+
+	/**
+	 * Frame formats.
+	 *
+	 * V1: 0x0a 0x0a | COMMAND | RESULT | length | data[length] | checksum (8-bit sum of COMMAND..data)
+	 * V2: 0x0a 0xa5 | frame id | COMMAND | RESULT | length (16-bit LE) | data[length] | CRC-16 (LE)
+	 *
+	 * V2 is used only after RTno accepted CAPABILITY_FRAMING_V2. The frame id of a request is echoed in its replies,
+	 * and the CRC (CRC-16/CCITT-FALSE over frame id..data) detects all 1-2 bit errors, odd bit counts and bursts up to 16 bits
+	 * (a flipped length field can still shift the CRC window, so a rare corrupted frame gets through).
+	 * The length is 16-bit on the wire, but a packet still carries at most PACKET_MAX_DATA_SIZE bytes;
+	 * longer values are fragmented (see request.h).
+	 */
+	enum class FRAMING : uint8_t
+	{
+		V1 = 1,
+		V2 = 2,
+	};
+
+	static const size_t FRAME_MAX_SIZE = 2 + FRAME_V2_HEADER_SIZE + PACKET_MAX_DATA_SIZE + FRAME_V2_CRC_SIZE;
+
+	uint16_t crc16_ccitt(const uint8_t *data, const size_t size, uint16_t crc = 0xFFFF);
+
+	/**
+	 * @brief Write the frame of packet to dst, which must hold FRAME_MAX_SIZE bytes.
+	 * @param sum checksum of the packet (V1 only).
+	 * @param frame_id ignored for V1.
+	 * @return size of the frame.
+	 */
+	size_t encode_frame(uint8_t *dst, const packet_t &packet, const uint8_t sum, const FRAMING framing, const uint8_t frame_id);
+
+	/**
+	 * Resumable decoder of RTno frames, both V1 and V2 (see FRAMING).
+	 *
+	 * Bytes are appended in whatever chunk size the device returns (prepare() / commit()),
+	 * and decode() pops complete packets. Bytes following a decoded frame stay in the buffer,
+	 * so nothing is dropped between frames.
+	 *
+	 * Once the negotiated framing is V2, 0x0a 0x0a is not a start any more: a V1 frame found by resynchronizing
+	 * inside a corrupted V2 payload would otherwise be delivered with only its 8-bit sum checked. A V2 frame
+	 * failing its CRC is then resynchronized right after its start bytes, since its length may be the broken field.
+	 */
+	class frame_decoder_t
+	{
+	public:
+		static const size_t BUFFER_SIZE = 1024;
+
+		enum class STATE : uint8_t
+		{
+			SYNC,	  // Searching 0x0a 0x0a
+			HEADER,	  // Waiting COMMAND, RESULT, length
+			BODY,	  // Waiting data
+			CHECKSUM, // Waiting checksum
+		};
+
+	private:
+		uint8_t buffer_[BUFFER_SIZE];
+		size_t begin_;
+		size_t end_;
+		STATE state_;
+		FRAMING framing_;
+		uint8_t frame_id_;
+		FRAMING negotiated_;
+
+	public:
+		frame_decoder_t() : begin_(0), end_(0), state_(STATE::SYNC), framing_(FRAMING::V1), frame_id_(0), negotiated_(FRAMING::V1) {}
+
+	public:
+		/**
+		 * @brief Get write region for incoming bytes.
+		 * @param writable [out] size of the region.
+		 */
+		uint8_t *prepare(size_t &writable);
+
+		/**
+		 * @brief Notify that size bytes are written to the region returned by prepare().
+		 */
+		void commit(const size_t size) { end_ += size; }
+
+		/**
+		 * @brief Pop one frame from buffered bytes.
+		 * @return RESULT::OK with packet, RESULT::CHECKSUM_ERROR if the frame is broken (frame is dropped),
+		 *         or RESULT::NOT_AVAILABLE if more bytes are needed.
+		 */
+		result_t<packet_t> decode();
+
+		void clear()
+		{
+			begin_ = end_ = 0;
+			state_ = STATE::SYNC;
+		}
+
+		size_t size() const { return end_ - begin_; }
+
+		STATE state() const { return state_; }
+
+		/**
+		 * @brief Framing in use on the link. V1 (the default, and during the profile exchange) decodes both formats, V2 only V2.
+		 */
+		void set_negotiated(const FRAMING framing) { negotiated_ = framing; }
+		FRAMING negotiated() const { return negotiated_; }
+
+		/**
+		 * @brief Format and frame id (V2 only) of the frame last returned by decode(), checksum errors included.
+		 */
+		FRAMING framing() const { return framing_; }
+		uint8_t frame_id() const { return frame_id_; }
+	};
+}
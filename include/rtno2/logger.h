@@ -21,9 +21,17 @@ namespace ssr::rtno2 {
 
 }
 
-#define RTNO_TRACE(logger, ...) (logger).trace(__VA_ARGS__)
-#define RTNO_DEBUG(logger, ...) (logger).debug(__VA_ARGS__)
-#define RTNO_INFO(logger, ...) (logger).info(__VA_ARGS__)
-#define RTNO_WARN(logger, ...) (logger).warn(__VA_ARGS__)
-#define RTNO_ERROR(logger, ...) (logger).error(__VA_ARGS__)
-#define RTNO_CRITICAL(logger, ...) (logger).critical(__VA_ARGS__)
\ No newline at end of file
+// Arguments (to_string() etc.) are evaluated only when the level is enabled.
+#define RTNO_LOG(logger, level, ...)                   \
+    do                                                 \
+    {                                                  \
+        if ((logger).should_log(level))                \
+            (logger).log(level, __VA_ARGS__);          \
+    } while (0)
+
+#define RTNO_TRACE(logger, ...) RTNO_LOG(logger, spdlog::level::trace, __VA_ARGS__)
+#define RTNO_DEBUG(logger, ...) RTNO_LOG(logger, spdlog::level::debug, __VA_ARGS__)
+#define RTNO_INFO(logger, ...) RTNO_LOG(logger, spdlog::level::info, __VA_ARGS__)
+#define RTNO_WARN(logger, ...) RTNO_LOG(logger, spdlog::level::warn, __VA_ARGS__)
+#define RTNO_ERROR(logger, ...) RTNO_LOG(logger, spdlog::level::err, __VA_ARGS__)
+#define RTNO_CRITICAL(logger, ...) RTNO_LOG(logger, spdlog::level::critical, __VA_ARGS__)
\ No newline at end of file
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <stdint.h>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <random>
+#include <thread>
+#include <atomic>
+
+#include "SerialDevice.h"
+
+namespace ssr::rtno2
+{
+
+    /**
+     * Conditions of one direction of an emulated serial link.
+     *
+     * Impairments are drawn from an RNG seeded with seed, as distances to the next event, so the same byte stream
+     * meets the same errors on every run (arrival times follow the clock, the errors do not).
+     */
+    struct link_config_t
+    {
+        uint32_t baudrate = 0;        // bytes leave one after another at bits_per_byte / baudrate. 0 disables pacing.
+        uint32_t bits_per_byte = 10;  // 8N1
+        uint32_t latency_usec = 0;    // added to every byte
+        uint32_t jitter_usec = 0;     // uniform 0..jitter_usec more per write(), never reordering bytes
+        double drop_rate = 0;         // probability that a byte is lost
+        double bit_error_rate = 0;    // probability that a bit is flipped
+        double burst_rate = 0;        // probability that a burst loss starts at a byte
+        uint32_t burst_length = 16;   // bytes lost in a burst
+        uint32_t seed = 1;
+    };
+
+    /**
+     * Pair of in-memory SerialDevice endpoints connected by an emulated link.
+     *
+     * Bytes written to a() arrive at b() (and the other way round) after their byte time, latency and jitter,
+     * with drops, bit flips and burst losses as configured per direction. Writes never block; the line queues
+     * bytes like an unbounded transmit buffer. Put a simulator_t behind b() with bridge_t.
+     *
+     * ex:
+     *   loopback_t link(config);
+     *   simulator_t firmware;
+     *   bridge_t bridge(link.b(), firmware);
+     *   protocol_t protocol(&link.a());
+     */
+    class loopback_t
+    {
+    public:
+        struct statistics_t
+        {
+            uint64_t bytes = 0;   // written
+            uint64_t dropped = 0; // lost by drops and bursts
+            uint64_t flipped = 0; // bits flipped
+        };
+
+    private:
+        class channel_t
+        {
+        private:
+            link_config_t config_;
+            std::mt19937 rng_;         // impairments, advanced per byte so they depend on the byte stream only
+            std::mt19937 jitter_rng_;  // jitter, advanced per write()
+            int64_t byte_nsec_;
+            int64_t line_free_nsec_;   // when the last queued byte has left
+            int64_t last_arrival_nsec_;
+            uint64_t bytes_to_drop_;   // bytes passing before the next drop
+            uint64_t bytes_to_burst_;  // bytes passing before the next burst
+            uint64_t bits_to_flip_;    // bits passing before the next flip
+            uint32_t burst_left_;
+            std::deque<std::pair<int64_t, uint8_t>> queue_; // (arrival time, byte), in arrival order
+            statistics_t statistics_;
+            std::mutex mutex_;
+            std::condition_variable cond_;
+
+        public:
+            channel_t(const link_config_t &config);
+
+        public:
+            void write(const uint8_t *src, const size_t size);
+            size_t available();
+            size_t read(uint8_t *dst, const size_t size);
+            bool wait(const uint32_t timeout_usec);
+
+            /**
+             * @brief Discard the bytes which have arrived. Bytes still on the line arrive later, as on a real port.
+             */
+            void flush();
+            statistics_t statistics();
+
+        private:
+            uint64_t next_distance(const double rate);
+            size_t arrived(const int64_t now) const;
+        };
+
+        class endpoint_t : public ssr::SerialDevice
+        {
+        private:
+            channel_t &rx_;
+            channel_t &tx_;
+
+        public:
+            endpoint_t(channel_t &rx, channel_t &tx) : rx_(rx), tx_(tx) {}
+            virtual ~endpoint_t() {}
+
+        public:
+            void flushRxBuffer();
+            void flushTxBuffer() {}
+            ssr::RETVAL getSizeInRxBuffer();
+            ssr::RETVAL write(const uint8_t *src, const uint8_t size);
+            ssr::RETVAL read(uint8_t *dst, const uint8_t size);
+            ssr::RETVAL getSenderInfo(uint8_t *) { return 0; }
+            ssr::RETVAL waitRxReady(const uint32_t timeout_usec);
+        };
+
+        channel_t a_to_b_;
+        channel_t b_to_a_;
+        endpoint_t a_;
+        endpoint_t b_;
+
+    public:
+        /**
+         * @brief Same conditions both ways. b() to a() draws its impairments from seed + 1.
+         */
+        loopback_t(const link_config_t &config);
+        loopback_t(const link_config_t &a_to_b, const link_config_t &b_to_a);
+
+    public:
+        ssr::SerialDevice &a() { return a_; }
+        ssr::SerialDevice &b() { return b_; }
+
+        statistics_t a_to_b_statistics() { return a_to_b_.statistics(); }
+        statistics_t b_to_a_statistics() { return b_to_a_.statistics(); }
+    };
+
+    /**
+     * Two threads copying bytes between two SerialDevices (e.g. loopback_t::b() and a simulator_t) until destroyed.
+     */
+    class bridge_t
+    {
+    private:
+        std::atomic<bool> running_;
+        std::thread forward_;
+        std::thread backward_;
+
+    public:
+        bridge_t(ssr::SerialDevice &a, ssr::SerialDevice &b);
+        ~bridge_t();
+
+    private:
+        void copy(ssr::SerialDevice &from, ssr::SerialDevice &to);
+    };
+}
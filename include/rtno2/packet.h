@@ -12,73 +12,124 @@
 #define PACKET_HEADER_SIZE 3
 #define PACKET_RECEIVE_HEADER_SIZE 3
 #define PACKET_SENDER_INFO_LENGTH 4
+#define PACKET_MAX_DATA_SIZE 255
+#define PACKET_MAX_SIZE (PACKET_HEADER_SIZE + PACKET_MAX_DATA_SIZE)
 
 namespace ssr::rtno2
 {
 
+  /**
+   * Non-owning view of a serialized packet (COMMAND | RESULT | length | data[length]).
+   * The viewed bytes must outlive the view.
+   */
+  class packet_view
+  {
+  private:
+    const uint8_t *m_pData;
+
+  public:
+    explicit packet_view(const uint8_t *serialized) : m_pData(serialized) {}
+
+  public:
+    COMMAND get_command() const { return (COMMAND)m_pData[0]; }
+    RESULT get_result() const { return (RESULT)m_pData[1]; }
+    uint8_t getDataLength() const { return m_pData[2]; }
+    uint16_t getPacketLength() const { return PACKET_HEADER_SIZE + m_pData[2]; } // up to PACKET_MAX_SIZE, which exceeds uint8_t
+    const uint8_t *getData() const { return m_pData + PACKET_HEADER_SIZE; }
+    const uint8_t *serialize() const { return m_pData; }
+    uint8_t getSum() const
+    {
+      uint8_t sum = 0;
+      for (uint32_t i = 0; i < getPacketLength(); i++)
+        sum += m_pData[i];
+      return sum;
+    }
+
+    std::string to_string() const
+    {
+      std::stringstream ss;
+      ss << "packet_t(CMD=" << command_to_string(get_command()) << ",RES=" << result_to_string(get_result()) << ",DATASIZE=" << (int)this->getDataLength() << ")";
+      return ss.str();
+    }
+  };
+
+  /**
+   * Packet with inline storage large enough for any packet, so it never allocates.
+   * Copy and move transfer only the used bytes.
+   */
   class packet_t
   {
   private:
-    uint8_t *m_pData;
+    uint8_t m_Data[PACKET_MAX_SIZE];
 
   public:
-    packet_t(const COMMAND command, const RESULT result, const uint8_t *data = NULL, const uint8_t size = 0) : m_pData(NULL)
+    packet_t(const COMMAND command, const RESULT result, const uint8_t *data = NULL, const uint8_t size = 0)
     {
       initialize(command, result, data, size);
     }
 
-    packet_t(const packet_t &p) : m_pData(NULL)
+    explicit packet_t(const packet_view &view)
     {
-      initialize(p.get_command(), p.get_result(), p.getData(), p.getDataLength());
+      memcpy(m_Data, view.serialize(), view.getPacketLength());
     }
 
-    ~packet_t()
+    packet_t(const packet_t &p) noexcept
     {
-      delete m_pData;
+      memcpy(m_Data, p.m_Data, p.getPacketLength());
     }
 
-  public:
-    void operator=(const packet_t &p)
+    packet_t(packet_t &&p) noexcept
     {
-      initialize(p.get_command(), p.get_result(), p.getData(), p.getDataLength());
+      memcpy(m_Data, p.m_Data, p.getPacketLength());
     }
 
   public:
-    COMMAND get_command() const { return (COMMAND)m_pData[0]; }
-    RESULT get_result() const { return (RESULT)m_pData[1]; }
-    uint8_t getDataLength() const { return m_pData[2]; }
-    // uint8_t *getSenderInfo() {return m_pData + PACKET_HEADER_SIZE;}
-    uint8_t getPacketLength() const { return PACKET_HEADER_SIZE + m_pData[2]; }
-    const uint8_t *getData() const { return m_pData + PACKET_HEADER_SIZE; }
-    const uint8_t *serialize() const { return m_pData; }
-    uint8_t getSum() const
+    packet_t &operator=(const packet_t &p) noexcept
     {
-      uint8_t sum = 0;
-      for (uint32_t i = 0; i < getPacketLength(); i++)
-        sum += m_pData[i];
-      return sum;
+      if (this != &p)
+      {
+        memcpy(m_Data, p.m_Data, p.getPacketLength());
+      }
+      return *this;
     }
 
+    packet_t &operator=(packet_t &&p) noexcept
+    {
+      return operator=(static_cast<const packet_t &>(p));
+    }
+
+  public:
+    packet_view view() const { return packet_view(m_Data); }
+    operator packet_view() const { return view(); }
+
+    COMMAND get_command() const { return (COMMAND)m_Data[0]; }
+    RESULT get_result() const { return (RESULT)m_Data[1]; }
+    uint8_t getDataLength() const { return m_Data[2]; }
+    // uint8_t *getSenderInfo() {return m_Data + PACKET_HEADER_SIZE;}
+    uint16_t getPacketLength() const { return PACKET_HEADER_SIZE + m_Data[2]; }
+    const uint8_t *getData() const { return m_Data + PACKET_HEADER_SIZE; }
+    const uint8_t *serialize() const { return m_Data; }
+    uint8_t getSum() const { return view().getSum(); }
+
+    /**
+     * @brief Writable data area, for request templates which patch their payload in place.
+     */
+    uint8_t *getWritableData() { return m_Data + PACKET_HEADER_SIZE; }
+    void setDataLength(const uint8_t size) { m_Data[2] = size; }
+
   private:
     void initialize(const COMMAND command, const RESULT result, const uint8_t *data = NULL, const uint8_t size = 0)
     {
-      delete m_pData;
-      m_pData = new uint8_t[size + PACKET_HEADER_SIZE];
-      m_pData[0] = (uint8_t)command;
-      m_pData[1] = (uint8_t)result;
-      m_pData[2] = size;
+      m_Data[0] = (uint8_t)command;
+      m_Data[1] = (uint8_t)result;
+      m_Data[2] = size;
       if (size > 0)
       {
-        memcpy(m_pData + PACKET_HEADER_SIZE, data, size);
+        memcpy(m_Data + PACKET_HEADER_SIZE, data, size);
       }
     }
 
   public:
-    std::string to_string() const
-    {
-      std::stringstream ss;
-      ss << "packet_t(CMD=" << command_to_string(get_command()) << ",RES=" << result_to_string(get_result()) << ",DATASIZE=" << (int)this->getDataLength() << ")";
-      return ss.str();
-    }
+    std::string to_string() const { return view().to_string(); }
   };
 }
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "packet.h"
+#include "result.h"
+#include "command.h"
+
+namespace ssr::rtno2
+{
+
+	/**
+	 * Batch of requests for protocol_t::run_pipeline().
+	 *
+	 * All request frames are written back-to-back and the replies, which the firmware returns in order,
+	 * are matched to the requests by COMMAND and port name.
+	 *
+	 * ex:
+	 *   pipeline_t p;
+	 *   p.send_inport_data("in0", data, 4).execute().receive_outport_data("out0", buf, sizeof(buf), &size);
+	 *   protocol.run_pipeline(p, deadline_after(20 * 1000));
+	 */
+	class pipeline_t
+	{
+	public:
+		struct request_t
+		{
+			packet_t packet;
+			COMMAND reply_command;
+			std::string port_name;
+			uint8_t *data;
+			uint8_t max_size;
+			uint8_t *size_read;
+			RESULT result;
+		};
+
+	private:
+		std::vector<request_t> requests_;
+		RESULT error_; // RESULT::ERR once a request was rejected
+
+	public:
+		pipeline_t() : error_(RESULT::OK) {}
+
+	public:
+		/**
+		 * @brief Add a write to inport. data is copied.
+		 *
+		 * The pipeline does not fragment. If name and data do not fit in one packet, the request is rejected:
+		 * its result is RESULT::ERR, error() returns RESULT::ERR and run_pipeline() sends nothing.
+		 * receive_outport_data() rejects a name which does not fit the same way.
+		 */
+		pipeline_t &send_inport_data(const std::string &portName, const uint8_t *data, const uint8_t length);
+		pipeline_t &execute();
+		pipeline_t &receive_outport_data(const std::string &portName, uint8_t *data, const uint8_t max_size, uint8_t *size_read);
+
+	private:
+		void add(result_t<packet_t> &&packet, const COMMAND reply_command, const std::string &portName, uint8_t *data, const uint8_t max_size, uint8_t *size_read);
+
+	public:
+		size_t size() const { return requests_.size(); }
+		void clear()
+		{
+			requests_.clear();
+			error_ = RESULT::OK;
+		}
+
+		/**
+		 * @brief RESULT::ERR if a request was rejected when it was added, RESULT::OK otherwise.
+		 */
+		RESULT error() const { return error_; }
+
+		/**
+		 * @brief Result of index-th request after run_pipeline(). RESULT::UNINITIALIZED before.
+		 */
+		RESULT result(const size_t index) const { return requests_[index].result; }
+
+		std::vector<request_t> &requests() { return requests_; }
+		const std::vector<request_t> &requests() const { return requests_; }
+	};
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "packet.h"
+#include "result.h"
+#include "profile.h"
+#include "type_code.h"
+#include "deadline.h"
+#include "retry_policy.h"
+#include "request.h"
+#include "codec.h"
+
+namespace ssr::rtno2
+{
+
+    class protocol_t;
+
+    /**
+     * Typed handle of an RTno inport, obtained by protocol_t::inport<T>().
+     *
+     * The SEND_DATA request (name_len | data_len | name) is encoded once when the handle is resolved,
+     * together with its partial checksum. write() only copies the value bytes behind the name and
+     * adds their sum, so no per-call string handling or checksum pass over the name is needed.
+     *
+     * T is checked against the TYPECODE of the port when the handle is resolved.
+     * The handle refers to its protocol_t, which must outlive it.
+     * Values must fit in one packet; larger sequences go through protocol_t::send_seq(), which can fragment them.
+     */
+    template <typename T>
+    class inport_t
+    {
+        friend class protocol_t;
+
+    private:
+        protocol_t *protocol_;
+        packet_t request_;
+        uint8_t prefix_size_;
+        uint8_t prefix_sum_;
+        wire_format_t format_;
+
+    private:
+        inport_t(protocol_t *protocol, const std::string &portName, const wire_format_t &format)
+            : protocol_(protocol), request_(COMMAND::SEND_DATA, RESULT::OK), prefix_size_(static_cast<uint8_t>(2 + portName.length())), format_(format)
+        {
+            uint8_t *payload = request_.getWritableData();
+            payload[0] = static_cast<uint8_t>(portName.length());
+            payload[1] = 0;
+            memcpy(payload + 2, portName.c_str(), portName.length());
+            request_.setDataLength(prefix_size_);
+            // Sum of everything except data_len and the value bytes. length contributes prefix_size_ here, the rest in write().
+            prefix_sum_ = request_.getSum();
+        }
+
+    public:
+        std::string name() const { return std::string((const char *)request_.getData() + 2, prefix_size_ - 2); }
+        const wire_format_t &format() const { return format_; }
+        TYPECODE typecode() const { return value_typecode<T>::value; }
+
+        RESULT write(const T &value, const deadline_t deadline, const retry_policy_t &policy = retry_policy_t());
+        RESULT write(const T &value, uint32_t wait_usec = 20 * 1000, int32_t try_count = 15)
+        {
+            const retry_policy_t policy(try_count, wait_usec);
+            return write(value, policy.deadline(), policy);
+        }
+    };
+
+    /**
+     * Typed handle of an RTno outport, obtained by protocol_t::outport<T>().
+     *
+     * The RECEIVE_DATA request never changes, so it is encoded and summed once.
+     * read() decodes the value straight from the reply packet, so the value must fit in one packet
+     * (see protocol_t::receive_seq_into() for fragmented values).
+     */
+    template <typename T>
+    class outport_t
+    {
+        friend class protocol_t;
+
+    private:
+        protocol_t *protocol_;
+        packet_t request_;
+        uint8_t sum_;
+        wire_format_t format_;
+
+    private:
+        outport_t(protocol_t *protocol, const packet_t &request, const wire_format_t &format)
+            : protocol_(protocol), request_(request), sum_(request_.getSum()), format_(format)
+        {
+        }
+
+    public:
+        std::string name() const { return std::string((const char *)request_.getData() + 2, request_.getData()[0]); }
+        const wire_format_t &format() const { return format_; }
+        TYPECODE typecode() const { return value_typecode<T>::value; }
+
+        result_t<T> read(const deadline_t deadline, const retry_policy_t &policy = retry_policy_t());
+        result_t<T> read(uint32_t wait_usec = 20 * 1000, int32_t try_count = 15)
+        {
+            const retry_policy_t policy(try_count, wait_usec);
+            return read(policy.deadline(), policy);
+        }
+    };
+}
@@ -2,7 +2,9 @@
 
 #include <string.h>
 #include <sstream>
-#include <list>
+#include <string>
+#include <string_view>
+#include <vector>
 
 #include "type_code.h"
 
@@ -45,11 +47,10 @@ namespace ssr::rtno2
       name_ = portName;
     }
 
-    port_profile_t(const port_profile_t &p)
-    {
-      typecode_ = p.typecode_;
-      name_ = p.name_;
-    }
+    port_profile_t(const port_profile_t &p) = default;
+    port_profile_t(port_profile_t &&p) = default;
+    port_profile_t &operator=(const port_profile_t &p) = default;
+    port_profile_t &operator=(port_profile_t &&p) = default;
 
     std::string to_string() const
     {
@@ -77,36 +78,207 @@ namespace ssr::rtno2
     }
   };
 
+  /**
+   * Optional protocol extensions, as bit flags.
+   *
+   * The host offers them in the data of the GET_PROFILE request (one byte), and RTno answers
+   * the ones it accepted in the second byte of PLATFORM_PROFILE. Firmware without extensions
+   * ignores the offer and sends no second byte, so both sides keep the original encoding.
+   */
+  static const uint8_t CAPABILITY_PACKED_BOOLEAN_SEQ = 0x01; // TimedBooleanSeq as count | bits (see wire_format_t)
+  static const uint8_t CAPABILITY_FRAGMENTED_DATA = 0x02;    // values larger than a packet as SEND_DATA_FRAGMENT / RECEIVE_DATA_FRAGMENT (see request.h)
+  static const uint8_t CAPABILITY_FRAMING_V2 = 0x04;         // frame id, 16-bit length and CRC-16 after the profile exchange (see FRAMING)
+  static const uint8_t CAPABILITY_BATCH_CYCLE = 0x08;        // a whole control cycle in one BATCH_CYCLE round trip (see cycle_t)
+
   struct platform_profile_t
   {
   public:
-    Architecture architecture_;
+    Architecture architecture_ = Architecture::UNKNOWN;
+    uint8_t capabilities_ = 0;
 
   public:
     std::string to_string() const
     {
       std::stringstream ss;
-      ss << "platform_profile_t(architecture=" << architecture_to_string(architecture_) << ")";
+      ss << "platform_profile_t(architecture=" << architecture_to_string(architecture_) << ", capabilities=" << (int)capabilities_ << ")";
       return ss.str();
     }
   };
 
+  typedef uint16_t port_index_t;
+  static const port_index_t INVALID_PORT_INDEX = 0xFFFF;
+
+  /**
+   * Id of a port: its index in the profile and the generation of the profile it was resolved from.
+   *
+   * protocol_t gives every profile it fetches a new generation, so an id kept across a refresh
+   * is rejected rather than addressing whichever port now has its index.
+   */
+  struct port_id_t
+  {
+    port_index_t index = INVALID_PORT_INDEX;
+    uint32_t generation = 0;
+
+    bool valid() const { return index != INVALID_PORT_INDEX; }
+    bool operator==(const port_id_t &id) const = default;
+  };
+  static const port_id_t INVALID_PORT_ID = port_id_t();
+
+  /**
+   * Flat table of port profiles.
+   *
+   * Ports are stored contiguously in the order they were added, and the position is the port index.
+   * Each name is stored once in the table, and an open-addressing hash index maps names to indices,
+   * so lookup by name is O(1) without copying strings and lookup by index is a direct access.
+   */
+  class port_table_t
+  {
+  private:
+    std::vector<port_profile_t> ports_;
+    std::vector<port_index_t> index_; // INVALID_PORT_INDEX marks an empty slot. Size is a power of two.
+
+  public:
+    typedef std::vector<port_profile_t>::const_iterator const_iterator;
+
+  public:
+    /**
+     * @brief Add a port. A port with the same name is replaced and keeps its index.
+     * @return index of the port.
+     */
+    port_index_t add(port_profile_t &&port)
+    {
+      port_index_t id = find(port.name());
+      if (id != INVALID_PORT_INDEX)
+      {
+        ports_[id] = std::move(port);
+        return id;
+      }
+      id = static_cast<port_index_t>(ports_.size());
+      ports_.push_back(std::move(port));
+      if (ports_.size() * 2 > index_.size())
+      {
+        rehash(index_.empty() ? 16 : index_.size() * 2);
+      }
+      else
+      {
+        insert_index(id);
+      }
+      return id;
+    }
+
+    port_index_t add(const port_profile_t &port)
+    {
+      return add(port_profile_t(port));
+    }
+
+    /**
+     * @brief Remove a port. Indices of the ports added after it are decremented.
+     */
+    bool remove(const std::string_view name)
+    {
+      const port_index_t id = find(name);
+      if (id == INVALID_PORT_INDEX)
+      {
+        return false;
+      }
+      ports_.erase(ports_.begin() + id);
+      rehash(index_.size());
+      return true;
+    }
+
+    /**
+     * @brief Index of the port, or INVALID_PORT_INDEX.
+     */
+    port_index_t find(const std::string_view name) const
+    {
+      if (index_.empty())
+      {
+        return INVALID_PORT_INDEX;
+      }
+      const size_t mask = index_.size() - 1;
+      for (size_t slot = hash(name) & mask;; slot = (slot + 1) & mask)
+      {
+        const port_index_t id = index_[slot];
+        if (id == INVALID_PORT_INDEX)
+        {
+          return INVALID_PORT_INDEX;
+        }
+        if (ports_[id].name() == name)
+        {
+          return id;
+        }
+      }
+    }
+
+    /**
+     * @brief Port at index, or NULL if index is out of range.
+     */
+    const port_profile_t *at(const port_index_t id) const
+    {
+      return id < ports_.size() ? &ports_[id] : NULL;
+    }
+
+    const port_profile_t &operator[](const port_index_t id) const { return ports_[id]; }
+
+    size_t size() const { return ports_.size(); }
+    bool empty() const { return ports_.empty(); }
+    const_iterator begin() const { return ports_.begin(); }
+    const_iterator end() const { return ports_.end(); }
+
+    void clear()
+    {
+      ports_.clear();
+      index_.clear();
+    }
+
+  private:
+    static size_t hash(const std::string_view name)
+    {
+      // FNV-1a
+      uint32_t h = 2166136261u;
+      for (const char c : name)
+      {
+        h = (h ^ (uint8_t)c) * 16777619u;
+      }
+      return h;
+    }
+
+    void insert_index(const port_index_t id)
+    {
+      const size_t mask = index_.size() - 1;
+      size_t slot = hash(ports_[id].name()) & mask;
+      while (index_[slot] != INVALID_PORT_INDEX)
+      {
+        slot = (slot + 1) & mask;
+      }
+      index_[slot] = id;
+    }
+
+    void rehash(const size_t size)
+    {
+      index_.assign(size, INVALID_PORT_INDEX);
+      for (size_t id = 0; id < ports_.size(); id++)
+      {
+        insert_index(static_cast<port_index_t>(id));
+      }
+    }
+  };
+
   class profile_t
   {
   public:
     platform_profile_t platform_profile_;
-    std::list<port_profile_t> inports_;
-    std::list<port_profile_t> outports_;
+    port_table_t inports_;
+    port_table_t outports_;
+    uint32_t generation_ = 0; // set by protocol_t when the profile is fetched
 
   public:
     profile_t(void) {}
 
-    profile_t(const profile_t &p)
-    {
-      platform_profile_ = p.platform_profile_;
-      inports_ = p.inports_;
-      outports_ = p.outports_;
-    }
+    profile_t(const profile_t &p) = default;
+    profile_t(profile_t &&p) = default;
+    profile_t &operator=(const profile_t &p) = default;
+    profile_t &operator=(profile_t &&p) = default;
 
     virtual ~profile_t(void) {}
 
@@ -116,12 +288,12 @@ namespace ssr::rtno2
       std::stringstream ss;
       ss << "rtno2::profile_t(architecture=" << architecture_to_string(platform_profile_.architecture_)
          << ", inports=[";
-      for (auto port : inports_)
+      for (const auto &port : inports_)
       {
         ss << port.to_string() << ",";
       }
       ss << "], outports=[";
-      for (auto port : outports_)
+      for (const auto &port : outports_)
       {
         ss << port.to_string() << ",";
       }
@@ -138,61 +310,68 @@ namespace ssr::rtno2
 
     void append_in_port(const port_profile_t &p)
     {
-      inports_.push_back(p);
+      inports_.add(p);
+    }
+
+    void append_in_port(port_profile_t &&p)
+    {
+      inports_.add(std::move(p));
     }
 
     void append_out_port(const port_profile_t &p)
     {
-      outports_.push_back(p);
+      outports_.add(p);
+    }
+
+    void append_out_port(port_profile_t &&p)
+    {
+      outports_.add(std::move(p));
     }
 
     void remove_in_port(const char *portName)
     {
-      for (std::list<port_profile_t>::iterator it = inports_.begin(); it != inports_.end(); ++it)
-      {
-        if ((*it).name() == portName)
-        {
-          inports_.remove((*it));
-          return;
-        }
-      }
+      inports_.remove(portName);
     }
 
     void remove_out_port(const char *portName)
     {
-      for (std::list<port_profile_t>::iterator it = outports_.begin(); it != outports_.end(); ++it)
-      {
-        if ((*it).name() == portName)
-        {
-          outports_.remove((*it));
-          return;
-        }
-      }
+      outports_.remove(portName);
     }
 
   public:
-    result_t<port_profile_t> inport(const std::string &portName) const
+    result_t<port_profile_t> inport(const std::string_view portName) const
     {
-      for (auto port : inports_)
+      auto port = inports_.at(inports_.find(portName));
+      if (port == NULL)
       {
-        if (port.name() == portName)
-        {
-          return port;
-        }
+        return RESULT::INPORT_NOT_FOUND;
       }
-      return RESULT::INPORT_NOT_FOUND;
+      return port_profile_t(*port);
     }
 
-    result_t<port_profile_t> outport(const std::string &portName) const
+    result_t<port_profile_t> outport(const std::string_view portName) const
     {
-      for (auto port : outports_)
+      auto port = outports_.at(outports_.find(portName));
+      if (port == NULL)
       {
-        if (port.name() == portName)
-        {
-          return port;
-        }
+        return RESULT::OUTPORT_NOT_FOUND;
       }
-      return RESULT::OUTPORT_NOT_FOUND;
+      return port_profile_t(*port);
+    }
+
+    port_id_t inport_id(const std::string_view portName) const { return id_of(inports_.find(portName)); }
+    port_id_t outport_id(const std::string_view portName) const { return id_of(outports_.find(portName)); }
+
+    /**
+     * @brief Port of id, or NULL if id is out of range or was resolved from another generation of the profile.
+     */
+    const port_profile_t *inport_at(const port_id_t id) const { return id.generation == generation_ ? inports_.at(id.index) : NULL; }
+    const port_profile_t *outport_at(const port_id_t id) const { return id.generation == generation_ ? outports_.at(id.index) : NULL; }
+
+  private:
+    port_id_t id_of(const port_index_t index) const
+    {
+      return index == INVALID_PORT_INDEX ? INVALID_PORT_ID : port_id_t{index, generation_};
     }
   };
 };
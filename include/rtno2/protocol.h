@@ -3,6 +3,7 @@
 #include <stdint.h>
 #include <string>
 #include <vector>
+#include <span>
 
 #include "transport.h"
 #include "profile.h"
@@ -10,174 +11,636 @@
 #include "result.h"
 #include "state.h"
 #include "ec_type.h"
+#include "deadline.h"
+#include "retry_policy.h"
+#include "request.h"
+#include "pipeline.h"
+#include "cycle.h"
+#include "port_handle.h"
 #include "SerialDevice.h"
 
 namespace ssr::rtno2
 {
 
 	static const size_t MAX_PACKET_SIZE = 255;
-	template <typename T>
-	inline T into(const uint8_t *buf, const uint8_t size)
-	{
-		return *(T *)buf;
-	}
-
-	template <typename T>
-	inline std::vector<T> into_vec(const uint8_t *buf, const uint8_t size)
-	{
-		int length = size / sizeof(T);
-		std::vector<T> val;
-		for (int i = 0; i < length; i++)
-		{
-			val.push_back(into<T>(buf + i * sizeof(T), sizeof(T)));
-		}
-		return val;
-	}
-
-	union intermediate_float_uint8
-	{
-		uint8_t uint8_value[4];
-		float float_value;
-	};
-
-	template <>
-	inline float into<float>(const uint8_t *buf, const uint8_t size)
-	{
-		intermediate_float_uint8 i;
-		memcpy(i.uint8_value, buf, size);
-		return i.float_value;
-	}
-
-	union intermediate_double_uint8
-	{
-		uint8_t uint8_value[8];
-		double double_value;
-	};
-
-	template <>
-	inline double into<double>(const uint8_t *buf, const uint8_t size)
-	{
-		if (size == 4)
-		{
-			return into<float>(buf, size);
-		}
-		intermediate_double_uint8 i;
-		memcpy(i.uint8_value, buf, size);
-		return i.double_value;
-	}
 
 	class RTnoRTObjectWrapper;
 
+	/**
+	 * Every request comes in two forms.
+	 *  - f(..., deadline, policy): the call returns no later than deadline. policy controls attempts, per-attempt timeout and backoff.
+	 *    Use deadline_after(usec) to give a total time budget instead of an absolute deadline.
+	 *  - f(..., wait_usec, retry_count): legacy form. retry_count attempts of wait_usec each, bounded by wait_usec * retry_count in total.
+	 */
 	class protocol_t
 	{
+		template <typename T>
+		friend class inport_t;
+		template <typename T>
+		friend class outport_t;
+
 	private:
 		transport_t transport_;
+		std::vector<const packet_t *> pipeline_packets_;
 		logger_t logger_;
 		Architecture architecture_;
+		uint8_t capabilities_;			// accepted by RTno in the last PLATFORM_PROFILE
+		uint8_t offered_capabilities_;	// offered in GET_PROFILE
+		profile_t profile_;
+		bool profile_valid_;
+		uint32_t profile_generation_;					// of the last fetched profile, see port_id_t
+		std::vector<uint8_t> fragment_buffer_;			// whole payload of a fragmented transfer
+		std::vector<packet_t> fragment_packets_;
+		std::vector<const packet_t *> fragment_frames_;
+		pipeline_t cycle_pipeline_;						// run_cycle() without CAPABILITY_BATCH_CYCLE
+		std::vector<uint8_t> cycle_sizes_;
 
-	public:
 	public:
 		protocol_t(ssr::SerialDevice *serial_device, LOGLEVEL loglevel = LOGLEVEL::WARN, LOGLEVEL transport_loglevel = LOGLEVEL::WARN);
 		virtual ~protocol_t(void);
 
+	public:
+		void set_wait_policy(const wait_policy_t &wait_policy) { transport_.set_wait_policy(wait_policy); }
+		void set_send_pacing(const uint32_t interbyte_delay_usec) { transport_.set_send_pacing(interbyte_delay_usec); }
+
+		/**
+		 * @brief Decode frames on a background thread. See transport_t::start_receiver().
+		 */
+		RESULT start_receiver() { return transport_.start_receiver(); }
+		void stop_receiver() { transport_.stop_receiver(); }
+		uint64_t heartbeat_count() const { return transport_.heartbeat_count(); }
+		monotonic_clock::time_point last_heartbeat() const { return transport_.last_heartbeat(); }
+
 	private:
-		result_t<packet_t> wait_and_receive_command(const COMMAND command, const uint32_t wait_usec, const uint32_t retry_counts = 5);
+		result_t<packet_t> wait_and_receive_command(const COMMAND command, const deadline_t deadline, const int frame_id = transport_t::ANY_FRAME_ID);
+		result_t<packet_t> transact(const packet_t &request, const COMMAND reply_command, const deadline_t deadline, const retry_policy_t &policy);
+		result_t<packet_t> transact(const packet_t &request, const uint8_t sum, const COMMAND reply_command, const deadline_t deadline, const retry_policy_t &policy);
+		/**
+		 * @brief Send request once and wait one attempt_timeout_usec for its reply, for requests which must not run twice.
+		 * @return RESULT::TIMEOUT (no reply) or RESULT::CHECKSUM_ERROR (broken reply) when request may have run.
+		 */
+		result_t<packet_t> transact_once(const packet_t &request, const COMMAND reply_command, const deadline_t deadline, const retry_policy_t &policy);
+		template <typename SEND>
+		result_t<packet_t> transact_with(const SEND &send, const COMMAND reply_command, const deadline_t deadline, const retry_policy_t &policy);
+		RESULT send_prepared(const packet_t &request, const uint8_t sum, const deadline_t deadline, const retry_policy_t &policy);
+
+		/**
+		 * @brief Send fragment_buffer_ to portName as SEND_DATA_FRAGMENTs in one write. A lost fragment retries the whole value.
+		 */
+		RESULT send_fragmented(const std::string &portName, const deadline_t deadline, const retry_policy_t &policy);
+
+		/**
+		 * @brief Receive the value of portName as RECEIVE_DATA_FRAGMENTs and reassemble it in fragment_buffer_.
+		 */
+		RESULT receive_fragmented(const std::string &portName, const deadline_t deadline, const retry_policy_t &policy);
+
+		/**
+		 * @brief Run cycle as a pipeline_t, for RTno without CAPABILITY_BATCH_CYCLE.
+		 */
+		void run_cycle_as_pipeline(cycle_t &cycle, const deadline_t deadline, const retry_policy_t &policy);
+		result_t<packet_t> receive_prepared(const packet_t &request, const uint8_t sum, const deadline_t deadline, const retry_policy_t &policy);
+		bool wait_backoff(const int attempt, const deadline_t deadline, const retry_policy_t &policy);
+
+		/**
+		 * @brief Deadline after wait_usec times count, computed in 64 bits. No deadline if that does not fit in wait_usec.
+		 */
+		static deadline_t deadline_after_each(const uint32_t wait_usec, const uint64_t count)
+		{
+			const uint64_t budget = (uint64_t)wait_usec * count;
+			return budget >= WAIT_INFINITE ? deadline_t::max() : deadline_after(static_cast<uint32_t>(budget));
+		}
+		result_t<profile_t> fetch_profile(const deadline_t deadline, const retry_policy_t &policy);
+		void invalidate_profile_on(const RESULT result);
+
+		/**
+		 * @brief Payload layout of T (a port value_type) for the connected board.
+		 */
+		template <typename T>
+		wire_format_t wire_format() const
+		{
+			const bool packed = std::is_same_v<T, std::vector<bool>> && (capabilities_ & CAPABILITY_PACKED_BOOLEAN_SEQ) != 0;
+			return wire_format_t{element_codec<typename value_element<T>::type>::wire_width(architecture_), packed};
+		}
+
+		/**
+		 * @brief Encode count elements of src (pointer or std::vector) straight into a SEND_DATA request and send it.
+		 *
+		 * A value larger than one packet goes out fragmented if RTno accepted CAPABILITY_FRAGMENTED_DATA, and is an error otherwise.
+		 */
+		template <typename E, typename SRC>
+		RESULT send_sequence(const char *caller, const std::string &portName, const SRC &src, const size_t count, const deadline_t deadline, const retry_policy_t &policy)
+		{
+			const wire_format_t format = wire_format<std::vector<E>>();
+			const size_t size = sequence_size(count, format);
+			if (size != SIZE_MAX && 2 + portName.length() + size <= PACKET_MAX_DATA_SIZE)
+			{
+				packet_t request(COMMAND::SEND_DATA, RESULT::OK);
+				encode_sequence(prepare_send_data_packet(request, portName, static_cast<uint8_t>(size)), src, count, format);
+				return send_prepared(request, request.getSum(), deadline, policy);
+			}
+			if (size == SIZE_MAX || (capabilities_ & CAPABILITY_FRAGMENTED_DATA) == 0)
+			{
+				RTNO_ERROR(logger_, "{}<{}>('{}') {} elements do not fit in a packet", caller, typeid(E).name(), portName, count);
+				return RESULT::ERR;
+			}
+			fragment_buffer_.resize(size);
+			encode_sequence(fragment_buffer_.data(), src, count, format);
+			return send_fragmented(portName, deadline, policy);
+		}
+
+		template <typename T>
+		result_t<size_t> decode_into(const std::string &portName, const uint8_t *data, const size_t size, std::span<T> dst)
+		{
+			const wire_format_t format = wire_format<std::vector<T>>();
+			const int count = sequence_count(data, size, format);
+			if (count < 0 || (size_t)count > dst.size())
+			{
+				RTNO_ERROR(logger_, "receive_seq_into<{}>('{}') {} bytes do not fit in {} elements", typeid(T).name(), portName, size, dst.size());
+				return RESULT::ERR;
+			}
+			decode_sequence(dst.data(), data, count, format);
+			return static_cast<size_t>(count);
+		}
 
 	public:
-		result_t<profile_t> get_profile(const uint32_t wait_usec, const int retry_count = 15);
-		result_t<std::string> get_log(const uint32_t wait_usec = 1000 * 1000, const int retry_count = 15);
+		/**
+		 * @brief Switch to a new (re-opened) device. Buffered packets and the cached profile are dropped.
+		 */
+		void reconnect(SerialDevice *serial_device);
 
-		result_t<STATE> get_state(const uint32_t wait_usec, const int retry_count = 15);
-		result_t<EC_TYPE> get_ec_type(const uint32_t wait_usec, const int retry_count = 15);
+	public:
+		/**
+		 * @brief Profile of RTno. Served from the cache when it is valid, otherwise fetched from RTno.
+		 *
+		 * The cache is invalidated by reconnect(), by RESET / INITIALIZE requests,
+		 * and when RTno answers INPORT_NOT_FOUND / OUTPORT_NOT_FOUND.
+		 */
+		result_t<profile_t> get_profile(const deadline_t deadline, const retry_policy_t &policy = retry_policy_t());
+		result_t<profile_t> get_profile(const uint32_t wait_usec, const int retry_count = 15)
+		{
+			const retry_policy_t policy(retry_count, wait_usec);
+			return get_profile(policy.deadline(), policy);
+		}
 
-		RESULT activate(const uint32_t wait_usec, const int retry_count = 15);
-		RESULT deactivate(const uint32_t wait_usec, const int retry_count = 15);
-		RESULT execute(const uint32_t wait_usec, const int retry_count = 15);
+		/**
+		 * @brief Fetch the profile from RTno and replace the cache, even if the cache is valid.
+		 */
+		RESULT refresh_profile(const deadline_t deadline, const retry_policy_t &policy = retry_policy_t());
+		RESULT refresh_profile(const uint32_t wait_usec = 1000 * 1000, const int retry_count = 15)
+		{
+			const retry_policy_t policy(retry_count, wait_usec);
+			return refresh_profile(policy.deadline(), policy);
+		}
+
+		void invalidate_profile() { profile_valid_ = false; }
+
+		/**
+		 * @brief Protocol extensions (CAPABILITY_* flags) to offer in the next GET_PROFILE. None by default.
+		 *
+		 * The profile cache is invalidated so that the next call negotiates again.
+		 * Port handles resolved before keep the encoding they were resolved with.
+		 */
+		void set_offered_capabilities(const uint8_t capabilities)
+		{
+			offered_capabilities_ = capabilities;
+			invalidate_profile();
+		}
 
-		RESULT send_inport_data(const std::string &portName, const uint8_t *data, const uint8_t length, const uint32_t wait_usec = 1000 * 1000, const int retry_count = 15);
+		/**
+		 * @brief Extensions RTno accepted in the last profile exchange.
+		 */
+		uint8_t capabilities() const { return capabilities_; }
 
+		/**
+		 * @brief Frame format in use. The profile exchange itself is always V1, and V2 follows if RTno accepted CAPABILITY_FRAMING_V2.
+		 */
+		FRAMING framing() const { return transport_.framing(); }
+
+		/**
+		 * @brief Cached profile, or NULL if the cache is invalid.
+		 */
+		const profile_t *cached_profile() const { return profile_valid_ ? &profile_ : NULL; }
+
+		/**
+		 * @brief Look up a port in the cached profile (fetched first if the cache is invalid).
+		 */
+		result_t<port_profile_t> inport_profile(const std::string &portName, const deadline_t deadline, const retry_policy_t &policy = retry_policy_t());
+		result_t<port_profile_t> inport_profile(const std::string &portName, const uint32_t wait_usec = 1000 * 1000, const int retry_count = 15)
+		{
+			const retry_policy_t policy(retry_count, wait_usec);
+			return inport_profile(portName, policy.deadline(), policy);
+		}
+
+		result_t<port_profile_t> outport_profile(const std::string &portName, const deadline_t deadline, const retry_policy_t &policy = retry_policy_t());
+		result_t<port_profile_t> outport_profile(const std::string &portName, const uint32_t wait_usec = 1000 * 1000, const int retry_count = 15)
+		{
+			const retry_policy_t policy(retry_count, wait_usec);
+			return outport_profile(portName, policy.deadline(), policy);
+		}
+
+		/**
+		 * @brief Resolve a port name to the id used by the id-based data calls.
+		 *
+		 * Ids stay valid until the profile is fetched again. Ids resolved from an earlier profile are rejected,
+		 * even if the new profile has a port at the same index.
+		 */
+		result_t<port_id_t> inport_id(const std::string &portName, const deadline_t deadline, const retry_policy_t &policy = retry_policy_t());
+		result_t<port_id_t> outport_id(const std::string &portName, const deadline_t deadline, const retry_policy_t &policy = retry_policy_t());
+
+		/**
+		 * @brief Resolve a typed handle of the inport (see inport_t).
+		 * @return RESULT::INPORT_NOT_FOUND if RTno has no such port, RESULT::ERR if T does not match the TYPECODE of the port.
+		 */
 		template <typename T>
-		RESULT send_as(const std::string &portName, const T &value, uint32_t wait_usec = 20 * 1000, int32_t try_count = 15)
+		result_t<inport_t<T>> inport(const std::string &portName, const deadline_t deadline, const retry_policy_t &policy = retry_policy_t())
 		{
-			RTNO_DEBUG(logger_, "send_as<{}>('{}') sending value: {}", typeid(T).name(), portName, value);
-			return send_inport_data(portName, (uint8_t *)&value, sizeof(T), wait_usec, try_count);
-			return RESULT::OK;
+			auto profile = inport_profile(portName, deadline, policy);
+			if (!profile)
+			{
+				return profile.error();
+			}
+			if (profile->typecode() != value_typecode<T>::value)
+			{
+				RTNO_ERROR(logger_, "inport('{}') is {}, which does not match requested {}", portName, typecode_to_str(profile->typecode()), typecode_to_str(value_typecode<T>::value));
+				return RESULT::ERR;
+			}
+			return inport_t<T>(this, portName, wire_format<T>());
+		}
+
+		template <typename T>
+		result_t<inport_t<T>> inport(const std::string &portName, const uint32_t wait_usec = 1000 * 1000, const int retry_count = 15)
+		{
+			const retry_policy_t policy(retry_count, wait_usec);
+			return inport<T>(portName, policy.deadline(), policy);
+		}
+
+		/**
+		 * @brief Resolve a typed handle of the outport (see outport_t).
+		 * @return RESULT::OUTPORT_NOT_FOUND if RTno has no such port, RESULT::ERR if T does not match the TYPECODE of the port.
+		 */
+		template <typename T>
+		result_t<outport_t<T>> outport(const std::string &portName, const deadline_t deadline, const retry_policy_t &policy = retry_policy_t())
+		{
+			auto profile = outport_profile(portName, deadline, policy);
+			if (!profile)
+			{
+				return profile.error();
+			}
+			if (profile->typecode() != value_typecode<T>::value)
+			{
+				RTNO_ERROR(logger_, "outport('{}') is {}, which does not match requested {}", portName, typecode_to_str(profile->typecode()), typecode_to_str(value_typecode<T>::value));
+				return RESULT::ERR;
+			}
+			auto request = make_receive_data_packet(portName);
+			if (!request)
+			{
+				return request.error();
+			}
+			return outport_t<T>(this, *request, wire_format<T>());
+		}
+
+		template <typename T>
+		result_t<outport_t<T>> outport(const std::string &portName, const uint32_t wait_usec = 1000 * 1000, const int retry_count = 15)
+		{
+			const retry_policy_t policy(retry_count, wait_usec);
+			return outport<T>(portName, policy.deadline(), policy);
+		}
+
+		result_t<std::string> get_log(const deadline_t deadline, const retry_policy_t &policy = retry_policy_t());
+		result_t<std::string> get_log(const uint32_t wait_usec = 1000 * 1000, const int retry_count = 15)
+		{
+			const retry_policy_t policy(retry_count, wait_usec);
+			return get_log(policy.deadline(), policy);
 		}
 
-		template <>
-		RESULT send_as<double>(const std::string &portName, const double &value, uint32_t wait_usec, int32_t try_count)
+		result_t<STATE> get_state(const deadline_t deadline, const retry_policy_t &policy = retry_policy_t());
+		result_t<STATE> get_state(const uint32_t wait_usec, const int retry_count = 15)
 		{
-			RTNO_DEBUG(logger_, "send_as<{}>('{}') sending value: {}", typeid(double).name(), portName, value);
-			if (this->architecture_ == Architecture::UNKNOWN)
+			const retry_policy_t policy(retry_count, wait_usec);
+			return get_state(policy.deadline(), policy);
+		}
+
+		result_t<EC_TYPE> get_ec_type(const deadline_t deadline, const retry_policy_t &policy = retry_policy_t());
+		result_t<EC_TYPE> get_ec_type(const uint32_t wait_usec, const int retry_count = 15)
+		{
+			const retry_policy_t policy(retry_count, wait_usec);
+			return get_ec_type(policy.deadline(), policy);
+		}
+
+		RESULT activate(const deadline_t deadline, const retry_policy_t &policy = retry_policy_t());
+		RESULT activate(const uint32_t wait_usec, const int retry_count = 15)
+		{
+			const retry_policy_t policy(retry_count, wait_usec);
+			return activate(policy.deadline(), policy);
+		}
+
+		RESULT deactivate(const deadline_t deadline, const retry_policy_t &policy = retry_policy_t());
+		RESULT deactivate(const uint32_t wait_usec, const int retry_count = 15)
+		{
+			const retry_policy_t policy(retry_count, wait_usec);
+			return deactivate(policy.deadline(), policy);
+		}
+
+		RESULT execute(const deadline_t deadline, const retry_policy_t &policy = retry_policy_t());
+		RESULT execute(const uint32_t wait_usec, const int retry_count = 15)
+		{
+			const retry_policy_t policy(retry_count, wait_usec);
+			return execute(policy.deadline(), policy);
+		}
+
+		/**
+		 * @brief Send raw value bytes to the inport.
+		 * @return RESULT::ERR if name and data do not fit in a packet and RTno did not accept CAPABILITY_FRAGMENTED_DATA.
+		 */
+		RESULT send_inport_data(const std::string &portName, const uint8_t *data, const uint8_t length, const deadline_t deadline, const retry_policy_t &policy = retry_policy_t());
+		RESULT send_inport_data(const std::string &portName, const uint8_t *data, const uint8_t length, const uint32_t wait_usec = 1000 * 1000, const int retry_count = 15)
+		{
+			const retry_policy_t policy(retry_count, wait_usec);
+			return send_inport_data(portName, data, length, policy.deadline(), policy);
+		}
+
+		/**
+		 * @brief Same as above, addressing the port by the id from inport_id(). The name is taken from the cached profile.
+		 * @return RESULT::INPORT_NOT_FOUND if the profile was invalidated or fetched again since the id was resolved.
+		 */
+		RESULT send_inport_data(const port_id_t port, const uint8_t *data, const uint8_t length, const deadline_t deadline, const retry_policy_t &policy = retry_policy_t());
+
+		/**
+		 * @brief Send a scalar value, converted to the width of the board like inport_t<T> (e.g. double as float on AVR).
+		 */
+		template <typename T>
+		RESULT send_as(const std::string &portName, const T &value, const deadline_t deadline, const retry_policy_t &policy = retry_policy_t())
+		{
+			RTNO_DEBUG(logger_, "send_as<{}>('{}') sending value: {}", typeid(T).name(), portName, value);
+			if (std::is_same_v<T, double> && architecture_ == Architecture::UNKNOWN)
 			{
 				RTNO_WARN(logger_, "send_as<double> detected UNKNOWN architecture, sending as 8-byte double");
 			}
-			if (this->architecture_ == Architecture::AVR)
+			uint8_t buffer[sizeof(T)];
+			const int size = value_codec<T>::encode(buffer, sizeof(buffer), value, wire_format<T>());
+			return send_inport_data(portName, buffer, static_cast<uint8_t>(size), deadline, policy);
+		}
+
+		template <typename T>
+		RESULT send_as(const std::string &portName, const T &value, uint32_t wait_usec = 20 * 1000, int32_t try_count = 15)
+		{
+			const retry_policy_t policy(try_count, wait_usec);
+			return send_as<T>(portName, value, policy.deadline(), policy);
+		}
+
+		/**
+		 * @brief Send the first length elements of value, converted to the element width of the board (e.g. double as float on AVR).
+		 *
+		 * Values larger than one packet need CAPABILITY_FRAGMENTED_DATA (see set_offered_capabilities()).
+		 */
+		template <typename T>
+		RESULT send_seq_as(const std::string &portName, const std::vector<T> &value, const size_t length, const deadline_t deadline, const retry_policy_t &policy = retry_policy_t())
+		{
+			if (length > value.size())
 			{
-				RTNO_DEBUG(logger_, "send_as<double> detected AVR architecture, sending as 4-byte float");
-				float fvalue = static_cast<float>(value);
-				return send_inport_data(portName, (uint8_t *)&fvalue, sizeof(float), wait_usec, try_count);
+				RTNO_ERROR(logger_, "send_seq_as<{}>('{}') length {} exceeds the {} elements of value", typeid(T).name(), portName, length, value.size());
+				return RESULT::ERR;
 			}
-			return send_inport_data(portName, (uint8_t *)&value, sizeof(double), wait_usec, try_count);
+			return send_sequence<T>("send_seq_as", portName, value, length, deadline, policy);
 		}
 
 		template <typename T>
 		RESULT send_seq_as(const std::string &portName, const std::vector<T> &value, const size_t length, uint32_t wait_usec = 20 * 1000, int32_t try_count = 15)
 		{
-			// RTNO_DEBUG(logger_, "send_seq_as<{}>('{}') sending value: {}", typeid(T).name(), portName, value);
-			return send_inport_data(portName, (uint8_t *)&(value[0]), length * sizeof(T), wait_usec, try_count);
-			return RESULT::OK;
+			const retry_policy_t policy(try_count, wait_usec);
+			return send_seq_as<T>(portName, value, length, policy.deadline(), policy);
+		}
+
+		/**
+		 * @brief Send value, encoded straight into the request packet (no temporary buffer, no allocation).
+		 *
+		 * Elements are converted to the element width of the board like send_seq_as.
+		 * T is not deduced from containers; call as send_seq<float>(name, vec).
+		 */
+		template <typename T>
+		RESULT send_seq(const std::string &portName, std::span<const T> value, const deadline_t deadline, const retry_policy_t &policy = retry_policy_t())
+		{
+			return send_sequence<T>("send_seq", portName, value.data(), value.size(), deadline, policy);
+		}
+
+		template <typename T>
+		RESULT send_seq(const std::string &portName, std::span<const T> value, uint32_t wait_usec = 20 * 1000, int32_t try_count = 15)
+		{
+			const retry_policy_t policy(try_count, wait_usec);
+			return send_seq<T>(portName, value, policy.deadline(), policy);
 		}
 
-		template <>
-		RESULT send_seq_as<bool>(const std::string &portName, const std::vector<bool> &value, const size_t length, uint32_t wait_usec, int32_t try_count)
+		/**
+		 * @brief Decode the outport value straight from the reply into dst (no allocation).
+		 *
+		 * With CAPABILITY_FRAGMENTED_DATA the value is received as fragments and decoded from the reassembled payload.
+		 * @return number of elements written, or RESULT::ERR if they do not fit in dst.
+		 */
+		template <typename T>
+		result_t<size_t> receive_seq_into(const std::string &portName, std::span<T> dst, const deadline_t deadline, const retry_policy_t &policy = retry_policy_t())
 		{
-			uint8_t *buffer = new uint8_t[length];
-			for (auto i = 0; i < length; i++)
+			if (capabilities_ & CAPABILITY_FRAGMENTED_DATA)
 			{
-				buffer[i] = value[i] ? 1 : 0;
+				const RESULT result = receive_fragmented(portName, deadline, policy);
+				if (result != RESULT::OK)
+				{
+					return result;
+				}
+				return decode_into<T>(portName, fragment_buffer_.data(), fragment_buffer_.size(), dst);
 			}
-			auto result = send_inport_data(portName, buffer, length * sizeof(uint8_t), wait_usec, try_count);
-			delete[] buffer;
-			return result;
+			const auto request = make_receive_data_packet(portName);
+			if (!request)
+			{
+				return request.error();
+			}
+			auto reply = receive_prepared(*request, request->getSum(), deadline, policy);
+			if (!reply)
+			{
+				return reply.error();
+			}
+			const uint8_t *data = NULL;
+			uint8_t size = 0;
+			const RESULT result = view_receive_data_reply(*reply, &data, &size);
+			if (result != RESULT::OK)
+			{
+				invalidate_profile_on(result);
+				return result;
+			}
+			return decode_into<T>(portName, data, size, dst);
+		}
+
+		template <typename T>
+		result_t<size_t> receive_seq_into(const std::string &portName, std::span<T> dst, uint32_t wait_usec = 20 * 1000, int32_t try_count = 15)
+		{
+			const retry_policy_t policy(try_count, wait_usec);
+			return receive_seq_into<T>(portName, dst, policy.deadline(), policy);
+		}
+
+		RESULT receive_outport_data(const std::string &portName, uint8_t *data, const uint8_t max_size, uint8_t *size_read, const deadline_t deadline, const retry_policy_t &policy = retry_policy_t());
+		RESULT receive_outport_data(const std::string &portName, uint8_t *data, const uint8_t max_size, uint8_t *size_read, const uint32_t wait_usec = 1000 * 1000, const int retry_count = 15)
+		{
+			const retry_policy_t policy(retry_count, wait_usec);
+			return receive_outport_data(portName, data, max_size, size_read, policy.deadline(), policy);
 		}
 
-		RESULT receive_outport_data(const std::string &portName, uint8_t *data, const uint8_t max_size, uint8_t *size_read, const uint32_t wait_usec = 1000 * 1000, const int retry_count = 15);
+		/**
+		 * @brief Same as above, addressing the port by the id from outport_id(). The name is taken from the cached profile.
+		 * @return RESULT::OUTPORT_NOT_FOUND if the profile was invalidated or fetched again since the id was resolved.
+		 */
+		RESULT receive_outport_data(const port_id_t port, uint8_t *data, const uint8_t max_size, uint8_t *size_read, const deadline_t deadline, const retry_policy_t &policy = retry_policy_t());
 
+		/**
+		 * @brief Receive a scalar value, converted from the width of the board like outport_t<T>.
+		 * @return RESULT::ERR if the value is not as wide as T is on the board.
+		 */
 		template <typename T>
-		result_t<T> receive_as(const std::string &portName, uint32_t wait_usec = 20 * 1000, int32_t try_count = 15)
+		result_t<T> receive_as(const std::string &portName, const deadline_t deadline, const retry_policy_t &policy = retry_policy_t())
 		{
 			static const uint8_t BUFSIZE = MAX_PACKET_SIZE;
 			uint8_t size;
 			uint8_t buffer[BUFSIZE];
-			auto state = this->receive_outport_data(portName, buffer, BUFSIZE, &size, wait_usec, try_count);
-			if (state == RESULT::OK)
+			auto state = this->receive_outport_data(portName, buffer, BUFSIZE, &size, deadline, policy);
+			if (state != RESULT::OK)
 			{
-				auto v = into<T>(buffer, size);
-				RTNO_DEBUG(logger_, "receive_as<{}>('{}') received value: {}", typeid(T).name(), portName, v);
+				return state;
+			}
+			wire_format_t format = wire_format<T>();
+			if (std::is_same_v<T, double> && architecture_ == Architecture::UNKNOWN && size == sizeof(float))
+			{
+				// Without a profile the board is unknown, and a 4-byte double can only come from AVR.
+				format.width = sizeof(float);
+			}
+			auto v = value_codec<T>::decode(buffer, size, format);
+			if (!v)
+			{
+				RTNO_ERROR(logger_, "receive_as<{}>('{}') {} bytes do not make a value", typeid(T).name(), portName, size);
 				return v;
 			}
-			return state;
+			RTNO_DEBUG(logger_, "receive_as<{}>('{}') received value: {}", typeid(T).name(), portName, *v);
+			return v;
 		}
 
 		template <typename T>
-		result_t<std::vector<T>> receive_seq_as(const std::string &portName, uint32_t wait_usec = 20 * 1000, int32_t try_count = 15)
+		result_t<T> receive_as(const std::string &portName, uint32_t wait_usec = 20 * 1000, int32_t try_count = 15)
 		{
+			const retry_policy_t policy(try_count, wait_usec);
+			return receive_as<T>(portName, policy.deadline(), policy);
+		}
+
+		template <typename T>
+		result_t<std::vector<T>> receive_seq_as(const std::string &portName, const deadline_t deadline, const retry_policy_t &policy = retry_policy_t())
+		{
+			if (capabilities_ & CAPABILITY_FRAGMENTED_DATA)
+			{
+				const RESULT result = receive_fragmented(portName, deadline, policy);
+				if (result != RESULT::OK)
+				{
+					return result;
+				}
+				return value_codec<std::vector<T>>::decode(fragment_buffer_.data(), fragment_buffer_.size(), wire_format<std::vector<T>>());
+			}
 			const uint8_t BUFSIZE = MAX_PACKET_SIZE;
 			uint8_t size;
 			uint8_t buffer[BUFSIZE];
-			auto state = this->receive_outport_data(portName, buffer, BUFSIZE, &size, wait_usec, try_count);
+			auto state = this->receive_outport_data(portName, buffer, BUFSIZE, &size, deadline, policy);
 			if (state == RESULT::OK)
 			{
-				return into_vec<T>(buffer, size);
+				return value_codec<std::vector<T>>::decode(buffer, size, wire_format<std::vector<T>>());
 			}
 			return state;
 		}
 
-		RESULT receive_log_data(uint8_t *data, const uint8_t max_size, uint8_t *size_read, const uint32_t wait_usec = 1000 * 1000, const int retry_count = 15);
+		template <typename T>
+		result_t<std::vector<T>> receive_seq_as(const std::string &portName, uint32_t wait_usec = 20 * 1000, int32_t try_count = 15)
+		{
+			const retry_policy_t policy(try_count, wait_usec);
+			return receive_seq_as<T>(portName, policy.deadline(), policy);
+		}
+
+		/**
+		 * @brief Write all requests of pipeline in one go and collect the replies.
+		 *
+		 * Requests whose reply is lost (timeout, checksum error, or skipped over) are retried one by one with policy,
+		 * after the queued replies of their command are discarded. EXECUTE is the exception: RTno may have run it
+		 * although its reply is lost, so it is not retried and its result is RESULT::TIMEOUT (no reply) or
+		 * RESULT::CHECKSUM_ERROR (broken reply). Whether it ran is unknown, and the caller decides whether to execute again.
+		 * Result of each request is available through pipeline.result(index).
+		 * @return RESULT::OK if all requests succeeded, otherwise the first failure.
+		 *         pipeline.error() without sending anything if a request was rejected when it was added.
+		 */
+		RESULT run_pipeline(pipeline_t &pipeline, const deadline_t deadline, const retry_policy_t &policy = retry_policy_t());
+		RESULT run_pipeline(pipeline_t &pipeline, const uint32_t wait_usec = 20 * 1000, const int retry_count = 15)
+		{
+			const retry_policy_t policy(retry_count, wait_usec);
+			return run_pipeline(pipeline, deadline_after_each(wait_usec, pipeline.size() + retry_count), policy);
+		}
+
+		/**
+		 * @brief Run one control cycle: the writes, EXECUTE and the reads of cycle.
+		 *
+		 * With CAPABILITY_BATCH_CYCLE this is one BATCH_CYCLE round trip. A cycle which executes is sent only once, and a lost
+		 * reply returns RESULT::TIMEOUT or RESULT::CHECKSUM_ERROR as in run_pipeline() (a cycle without EXECUTE is retried). Otherwise, or if the cycle does not fit in one packet, it runs as a pipeline (see run_pipeline()
+		 * for a lost EXECUTE reply). A value which does not fit in one packet is then sent first on its own, fragmented
+		 * with CAPABILITY_FRAGMENTED_DATA. If it fails, nothing else runs and the rest of the cycle gets its result.
+		 * Port ids are those of the current profile, which is fetched first if needed.
+		 * Results and values are available through cycle.
+		 * @return RESULT::OK if every write, EXECUTE and every read succeeded, otherwise the first failure.
+		 */
+		RESULT run_cycle(cycle_t &cycle, const deadline_t deadline, const retry_policy_t &policy = retry_policy_t());
+		RESULT run_cycle(cycle_t &cycle, const uint32_t wait_usec = 20 * 1000, const int retry_count = 15)
+		{
+			const retry_policy_t policy(retry_count, wait_usec);
+			return run_cycle(cycle, deadline_after_each(wait_usec, cycle.write_count() + cycle.read_count() + 1 + retry_count), policy);
+		}
+
+		RESULT receive_log_data(uint8_t *data, const uint8_t max_size, uint8_t *size_read, const deadline_t deadline, const retry_policy_t &policy = retry_policy_t());
+		RESULT receive_log_data(uint8_t *data, const uint8_t max_size, uint8_t *size_read, const uint32_t wait_usec = 1000 * 1000, const int retry_count = 15)
+		{
+			const retry_policy_t policy(retry_count, wait_usec);
+			return receive_log_data(data, max_size, size_read, policy.deadline(), policy);
+		}
 
 	private:
 		platform_profile_t parse_platform_profile(const packet_t &packet);
 		port_profile_t parse_port_profile(const packet_t &packet);
 	};
+
+	template <typename T>
+	inline RESULT inport_t<T>::write(const T &value, const deadline_t deadline, const retry_policy_t &policy)
+	{
+		uint8_t *payload = request_.getWritableData();
+		const int size = value_codec<T>::encode(payload + prefix_size_, PACKET_MAX_DATA_SIZE - prefix_size_, value, format_);
+		if (size < 0)
+		{
+			return RESULT::ERR;
+		}
+		payload[1] = static_cast<uint8_t>(size);
+		request_.setDataLength(static_cast<uint8_t>(prefix_size_ + size));
+		// length and data_len both grow by size.
+		uint8_t sum = prefix_sum_ + 2 * static_cast<uint8_t>(size);
+		for (int i = 0; i < size; i++)
+		{
+			sum += payload[prefix_size_ + i];
+		}
+		return protocol_->send_prepared(request_, sum, deadline, policy);
+	}
+
+	template <typename T>
+	inline result_t<T> outport_t<T>::read(const deadline_t deadline, const retry_policy_t &policy)
+	{
+		auto reply = protocol_->receive_prepared(request_, sum_, deadline, policy);
+		if (!reply)
+		{
+			return reply.error();
+		}
+		const uint8_t *data = NULL;
+		uint8_t size = 0;
+		const RESULT result = view_receive_data_reply(*reply, &data, &size);
+		if (result != RESULT::OK)
+		{
+			protocol_->invalidate_profile_on(result);
+			return result;
+		}
+		return value_codec<T>::decode(data, size, format_);
+	}
 }
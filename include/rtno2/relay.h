@@ -0,0 +1,121 @@
+#pragma once
+
+#ifdef __linux__
+
+#include <stdint.h>
+#include <memory>
+#include <vector>
+
+#include "frame_decoder.h"
+#include "logger.h"
+#include "packet.h"
+#include "result.h"
+
+namespace ssr::rtno2
+{
+
+	/**
+	 * Single-threaded broker between serial devices and TCP clients, driven by epoll (the engine of com2tcp).
+	 *
+	 * Each pair owns a serial descriptor for the lifetime of the relay and listens on its own TCP port, where up to
+	 * MAX_CLIENTS clients share the device. Frames from every client are decoded and queued, and the wire carries one
+	 * transaction at a time: the complete requests a client has queued (a pipeline, or a whole run of fragments)
+	 * are written, and every reply frame goes back to that client until each request is answered. The next client
+	 * in turn then gets the line. A transaction whose replies stop for timeout_usec is abandoned.
+	 *
+	 * A read-only request (GET_STATE, GET_PROFILE) identical to the one on the wire, or queued by other clients,
+	 * is answered from the same reply, so monitoring clients do not multiply the serial traffic. Each of them gets
+	 * the reply in the framing and frame id of its own request. HEART_BEAT goes to every client.
+	 *
+	 * Clients share the capabilities RTno accepted last (see protocol_t::set_offered_capabilities()), so they should
+	 * offer the same ones. A client which does not read its replies (BUFFER_SIZE behind) is disconnected.
+	 *
+	 * ex:
+	 *   relay_t relay;
+	 *   relay.add(serial.getFileDescriptor(), 10000);
+	 *   relay.run(); // until relay.stop()
+	 */
+	class relay_t
+	{
+	public:
+		struct statistics_t
+		{
+			uint64_t serial_to_tcp = 0; // bytes
+			uint64_t tcp_to_serial = 0; // bytes
+			uint64_t transactions = 0;	// written to a serial device
+			uint64_t coalesced = 0;		// requests answered with the reply to an identical one
+			uint64_t timeouts = 0;		// transactions abandoned
+			uint64_t discarded = 0;		// broken frames, and replies nobody waits for
+			uint64_t wakeups = 0;		// returns from epoll_wait()
+			uint64_t clients = 0;		// accepted
+			uint64_t refused = 0;		// closed because the pair had MAX_CLIENTS
+		};
+
+		static const size_t BUFFER_SIZE = 64 * 1024; // serial output and client output, each
+		static const size_t MAX_CLIENTS = 16;		 // per pair
+		static const size_t MAX_QUEUED = 512;		 // requests per client, more than a run of fragments
+		static const size_t MAX_BATCH = 64;			 // requests per transaction, unless a run of fragments is longer
+
+	private:
+		struct pair_t;
+		struct client_t;
+
+		int epoll_fd_;
+		int stop_fd_; // eventfd written by stop()
+		std::vector<std::unique_ptr<pair_t>> pairs_;
+		std::vector<std::unique_ptr<client_t>> clients_; // by slot, NULL if free
+		uint32_t timeout_usec_;
+		statistics_t statistics_;
+		logger_t logger_;
+
+	public:
+		relay_t(const LOGLEVEL loglevel = LOGLEVEL::INFO, const uint32_t timeout_usec = 50 * 1000);
+		~relay_t();
+
+		relay_t(const relay_t &) = delete;
+		relay_t &operator=(const relay_t &) = delete;
+
+	public:
+		/**
+		 * @brief Broker serial_fd to the clients of port. serial_fd is made non-blocking and stays open (owned by the caller).
+		 * @return RESULT::ERR if port can not be listened on.
+		 */
+		RESULT add(const int serial_fd, const uint16_t port);
+
+		/**
+		 * @brief Relay until stop(). Call from one thread.
+		 * @return RESULT::OK after stop(), RESULT::ERR if epoll fails or every serial device is gone.
+		 */
+		RESULT run();
+
+		/**
+		 * @brief Make run() return. Safe from other threads and signal handlers.
+		 */
+		void stop();
+
+		/**
+		 * @brief Counters, consistent once run() has returned.
+		 */
+		const statistics_t &statistics() const { return statistics_; }
+
+	private:
+		void accept_client(pair_t &pair);
+		void drop_client(client_t &client, const char *reason);
+		void reap_clients();
+		void close_pair(pair_t &pair, const char *reason);
+		void receive_serial(pair_t &pair);
+		void receive_client(client_t &client);
+		void send_client(client_t &client);
+		void send_serial(pair_t &pair);
+		void on_request(client_t &client, const packet_t &request, const FRAMING framing, const uint8_t frame_id);
+		void on_reply(pair_t &pair, const packet_t &reply, const FRAMING framing, const uint8_t frame_id);
+		void deliver(client_t &client, const packet_t &reply, const FRAMING framing, const uint8_t frame_id);
+		void start_transaction(pair_t &pair);
+		void finish_transaction(pair_t &pair);
+		void update_interest(pair_t &pair);
+		int timeout_msec();
+		void expire_transactions();
+	};
+}
+
+#endif
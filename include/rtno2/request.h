@@ -0,0 +1,88 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+
+#include "packet.h"
+#include "result.h"
+
+namespace ssr::rtno2
+{
+
+	/**
+	 * Encoding of port data requests and replies.
+	 *
+	 * SEND_DATA    request : name_len | data_len | name[name_len] | data[data_len]
+	 * RECEIVE_DATA request : name_len | 0 | name[name_len]
+	 * RECEIVE_DATA reply   : name_len | data_len | name[name_len] | data[data_len]
+	 *
+	 * With CAPABILITY_FRAGMENTED_DATA, a value larger than one packet is split into numbered fragments:
+	 *
+	 * SEND_DATA_FRAGMENT             : name_len | data_len | name[name_len] | index | count | data[data_len]
+	 * RECEIVE_DATA_FRAGMENT request  : name_len | 0 | name[name_len]
+	 * RECEIVE_DATA_FRAGMENT reply    : name_len | data_len | name[name_len] | index | count | data[data_len]
+	 *
+	 * Fragments go back-to-back in index order. RTno answers SEND_DATA only after the last fragment,
+	 * with RESULT::ERR if any fragment was missing. A RECEIVE_DATA_FRAGMENT reply other than RESULT::OK
+	 * is a single fragment (index 0, count 1) without data.
+	 */
+	static const size_t FRAGMENT_HEADER_SIZE = 4;
+	static const size_t FRAGMENT_MAX_COUNT = 255;
+
+	/**
+	 * @brief Data bytes one fragment of a port named name_len bytes carries.
+	 */
+	inline size_t fragment_capacity(const size_t name_len)
+	{
+		return name_len + FRAGMENT_HEADER_SIZE < PACKET_MAX_DATA_SIZE ? PACKET_MAX_DATA_SIZE - FRAGMENT_HEADER_SIZE - name_len : 0;
+	}
+
+	/**
+	 * @brief SEND_DATA request carrying length bytes of data to portName.
+	 * @return RESULT::ERR if 2 + portName.length() + length exceeds PACKET_MAX_DATA_SIZE.
+	 */
+	result_t<packet_t> make_send_data_packet(const std::string &portName, const uint8_t *data, const uint8_t length);
+
+	/**
+	 * @brief Write the SEND_DATA prefix for portName into packet and reserve length data bytes.
+	 * @return where the caller encodes the data, or NULL (packet untouched) if the request does not fit in a packet.
+	 */
+	uint8_t *prepare_send_data_packet(packet_t &packet, const std::string &portName, const uint8_t length);
+
+	/**
+	 * @return RESULT::ERR if portName does not fit in a packet.
+	 */
+	result_t<packet_t> make_receive_data_packet(const std::string &portName);
+
+	/**
+	 * @brief Write the fragment prefix for portName into packet (SEND_DATA_FRAGMENT or RECEIVE_DATA_FRAGMENT) and reserve length data bytes.
+	 * @return where the caller copies the data, or NULL (packet untouched) if the fragment does not fit in a packet
+	 *         (length exceeds fragment_capacity(portName.length())).
+	 */
+	uint8_t *prepare_fragment_packet(packet_t &packet, const std::string &portName, const uint8_t index, const uint8_t count, const uint8_t length);
+
+	/**
+	 * @brief Locate the data of a fragment without copying it.
+	 * @return RESULT of the packet, or RESULT::ERR if the fragment is malformed.
+	 */
+	RESULT view_fragment(const packet_t &packet, const uint8_t **data, uint8_t *size, uint8_t *index, uint8_t *count);
+
+	/**
+	 * @brief Parse RECEIVE_DATA reply.
+	 * @param name [out] port name in the reply. Ignored if NULL.
+	 * @return RESULT of the reply packet, or RESULT::ERR if the reply is malformed or exceeds max_size.
+	 */
+	RESULT parse_receive_data_reply(const packet_t &packet, uint8_t *data, const uint8_t max_size, uint8_t *size_read, std::string *name = NULL);
+
+	/**
+	 * @brief Locate the data of RECEIVE_DATA reply without copying it.
+	 * @param data [out] points into packet.
+	 * @return RESULT of the reply packet, or RESULT::ERR if the reply is malformed.
+	 */
+	RESULT view_receive_data_reply(const packet_t &packet, const uint8_t **data, uint8_t *size);
+
+	/**
+	 * @brief True if the reply (RECEIVE_DATA or RECEIVE_DATA_FRAGMENT) belongs to the port. Replies without port name (e.g. SEND_DATA) always match.
+	 */
+	bool reply_matches_port(const packet_t &packet, const std::string &portName);
+}
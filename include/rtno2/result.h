@@ -2,6 +2,7 @@
 #define RESULT_HEADER_FILE_INCLUDED
 
 #include <optional>
+#include <utility>
 #include <string>
 #include <sstream>
 
@@ -76,17 +77,49 @@ namespace ssr::rtno2
     }
   }
 
+  /**
+   * Value or error code, in the manner of std::expected<T, RESULT>.
+   *
+   * A value is moved in (result_t(T &&)) and can be moved out again with *std::move(r),
+   * so returning a result never deep-copies the value. result_t itself is move-only.
+   * error() is RESULT::OK while a value is held.
+   */
   template <typename T>
   class result_t
   {
+  private:
+    std::optional<T> value_;
+    RESULT result_;
+
   public:
-    std::optional<T> value;
-    RESULT result;
+    result_t() : result_(RESULT::UNINITIALIZED) {}
+    result_t(T &&t) : value_(std::move(t)), result_(RESULT::OK) {}
+    result_t(RESULT r) : value_(std::nullopt), result_(r) {}
+
+    result_t(result_t &&) = default;
+    result_t &operator=(result_t &&) = default;
+    result_t(const result_t &) = delete;
+    result_t &operator=(const result_t &) = delete;
 
   public:
-    result_t() : result(RESULT::UNINITIALIZED) {}
-    result_t(T &&t) : value(t), result(RESULT::OK) {}
-    result_t(RESULT r) : value(std::nullopt), result(r) {}
+    bool has_value() const { return value_.has_value(); }
+    explicit operator bool() const { return has_value(); }
+
+    RESULT error() const { return result_; }
+
+    /**
+     * @throw std::bad_optional_access if no value is held.
+     */
+    T &value() & { return value_.value(); }
+    const T &value() const & { return value_.value(); }
+    T &&value() && { return std::move(value_.value()); }
+
+    T &operator*() & { return *value_; }
+    const T &operator*() const & { return *value_; }
+    T &&operator*() && { return std::move(*value_); }
+
+    T *operator->() { return &*value_; }
+    const T *operator->() const { return &*value_; }
   };
 
 }
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <sstream>
+
+#include "deadline.h"
+
+namespace ssr::rtno2
+{
+
+    /**
+     * Retry policy of one protocol_t call.
+     *
+     * Each attempt sends the request once and waits at most attempt_timeout_usec for the reply.
+     * Before attempt n (n >= 1) the caller sleeps backoff_usec * backoff_multiplier^(n-1), capped by max_backoff_usec.
+     * Independently of the policy, the whole call never runs past the deadline given by the caller.
+     */
+    struct retry_policy_t
+    {
+    public:
+        int max_attempts;
+        uint32_t attempt_timeout_usec;
+        uint32_t backoff_usec;
+        uint32_t backoff_multiplier;
+        uint32_t max_backoff_usec;
+
+    public:
+        retry_policy_t(const int max_attempts = 15, const uint32_t attempt_timeout_usec = 20 * 1000, const uint32_t backoff_usec = 0, const uint32_t backoff_multiplier = 2, const uint32_t max_backoff_usec = 100 * 1000)
+            : max_attempts(max_attempts), attempt_timeout_usec(attempt_timeout_usec), backoff_usec(backoff_usec), backoff_multiplier(backoff_multiplier), max_backoff_usec(max_backoff_usec)
+        {
+        }
+
+    public:
+        /**
+         * @brief Sleep time before the attempt (zero for the first attempt).
+         */
+        uint32_t backoff_before(const int attempt) const
+        {
+            if (attempt <= 0 || backoff_usec == 0)
+            {
+                return 0;
+            }
+            uint64_t backoff = backoff_usec;
+            for (int i = 1; i < attempt && backoff < max_backoff_usec; i++)
+            {
+                backoff *= backoff_multiplier;
+            }
+            return backoff > max_backoff_usec ? max_backoff_usec : static_cast<uint32_t>(backoff);
+        }
+
+        /**
+         * @brief Worst case duration of a call which uses up all attempts.
+         */
+        uint64_t budget_usec() const
+        {
+            uint64_t budget = 0;
+            for (int i = 0; i < max_attempts; i++)
+            {
+                budget += backoff_before(i) + (uint64_t)attempt_timeout_usec;
+            }
+            return budget;
+        }
+
+        /**
+         * @brief Deadline which lets all attempts run to the end.
+         */
+        deadline_t deadline() const
+        {
+            const uint64_t budget = budget_usec();
+            return budget >= WAIT_INFINITE ? deadline_t::max() : deadline_after(static_cast<uint32_t>(budget));
+        }
+
+        std::string to_string() const
+        {
+            std::stringstream ss;
+            ss << "retry_policy_t(max_attempts=" << max_attempts << ", attempt_timeout_usec=" << attempt_timeout_usec
+               << ", backoff_usec=" << backoff_usec << ", backoff_multiplier=" << backoff_multiplier
+               << ", max_backoff_usec=" << max_backoff_usec << ")";
+            return ss.str();
+        }
+    };
+}
@@ -0,0 +1,196 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include <optional>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+
+#include "SerialDevice.h"
+#include "packet.h"
+#include "profile.h"
+#include "frame_decoder.h"
+#include "state.h"
+#include "ec_type.h"
+
+namespace ssr::rtno2
+{
+
+    /**
+     * In-process stand-in for RTno firmware, usable wherever a SerialDevice is (and as a pty, see simulator_pty_t).
+     *
+     * Requests written by the host are handled in write(), and the replies are read back through read(),
+     * after the processing delay if one is set. Requests are processed one after another, so a burst of N requests
+     * is answered over N delays. Every COMMAND is answered as the firmware does: the RTC state machine
+     * (INITIALIZE, ACTIVATE, DEACTIVATE, ONERROR, RESET, GET_STATE), GET_CONTEXT_TYPE, the profile, port data and RECEIVE_LOG.
+     * With a heartbeat interval, HEART_BEAT is sent unsolicited every interval.
+     *
+     * Each inport keeps the last value sent to it, and EXECUTE (in STATE::ACTIVE only) copies inport values
+     * to the outports connected to them. ACTIVATE resets outports to their initial value, if they have one. Values are kept as the firmware would see them, so extensions
+     * such as CAPABILITY_PACKED_BOOLEAN_SEQ are encoded and decoded here independently of the host codec.
+     * With CAPABILITY_FRAGMENTED_DATA, values of any size are reassembled from / split into fragments.
+     * Requests are decoded in either FRAMING, and replies go out in the framing (and with the frame id) of their request.
+     * With CAPABILITY_BATCH_CYCLE, BATCH_CYCLE writes, executes and reads in one round trip (see cycle_t).
+     */
+    class simulator_t : public ssr::SerialDevice
+    {
+    public:
+        struct port_t
+        {
+            TYPECODE typecode;
+            std::string name;
+            bool written;
+            std::vector<uint8_t> value; // element by element, as the firmware stores it (one octet per bool)
+            std::vector<uint8_t> fragments; // SEND_DATA_FRAGMENT data received so far
+            size_t next_fragment = 0;
+            std::optional<std::vector<uint8_t>> initial; // loaded on ACTIVATE
+        };
+
+    private:
+        std::mutex mutex_;
+        std::condition_variable cond_;
+        frame_decoder_t requests_;
+        std::vector<uint8_t> rx_; // bytes for the host to read
+        std::vector<uint8_t> payload_;
+        FRAMING reply_framing_;
+        uint8_t reply_frame_id_;
+        int64_t reply_ready_nsec_;                                 // when the replies to the current request become readable
+        int64_t busy_until_nsec_;                                  // ready time of the last request
+        std::deque<std::pair<int64_t, std::vector<uint8_t>>> delayed_; // frames waiting for their ready time
+        int64_t next_heartbeat_nsec_;
+
+        STATE state_;
+        EC_TYPE ec_type_;
+        uint32_t processing_delay_usec_;
+        uint32_t heartbeat_interval_usec_;
+        std::string log_; // returned by the next RECEIVE_LOG
+
+        Architecture architecture_;
+        uint8_t supported_capabilities_;
+        uint8_t capabilities_; // accepted in the last GET_PROFILE
+        std::vector<port_t> inports_;
+        std::vector<port_t> outports_;
+        std::vector<std::pair<size_t, size_t>> connections_; // (inport, outport)
+
+        uint64_t bytes_received_;
+        uint64_t bytes_sent_;
+
+    public:
+        simulator_t(const Architecture architecture = Architecture::ARM, const uint8_t supported_capabilities = CAPABILITY_PACKED_BOOLEAN_SEQ | CAPABILITY_FRAGMENTED_DATA | CAPABILITY_FRAMING_V2 | CAPABILITY_BATCH_CYCLE);
+        virtual ~simulator_t() {}
+
+    public:
+        void add_inport(const TYPECODE typecode, const std::string &name);
+        void add_outport(const TYPECODE typecode, const std::string &name);
+
+        /**
+         * @brief Add an outport holding initial_value (in wire format) until the first EXECUTE after each ACTIVATE.
+         */
+        void add_outport(const TYPECODE typecode, const std::string &name, const std::vector<uint8_t> &initial_value);
+
+        /**
+         * @brief Copy the value of inport to outport on every EXECUTE. Both must have the same TYPECODE.
+         */
+        bool connect(const std::string &inport, const std::string &outport);
+
+        uint8_t capabilities() const { return capabilities_; }
+
+        /**
+         * @brief Execution context type answered to GET_CONTEXT_TYPE. EC_TYPE::PROXY_SYNCHRONOUS by default.
+         */
+        void set_ec_type(const EC_TYPE ec_type);
+
+        /**
+         * @brief Time from the end of a request (or of the previous one still being processed) to its replies. 0 by default.
+         */
+        void set_processing_delay(const uint32_t usec);
+
+        /**
+         * @brief Send HEART_BEAT every usec. 0 (default) disables it.
+         */
+        void set_heartbeat_interval(const uint32_t usec);
+
+        /**
+         * @brief Queue text for the next RECEIVE_LOG, as the firmware's log does.
+         */
+        void log(const std::string &message);
+
+        STATE state();
+
+        /**
+         * @brief Bytes written by the host / replied to the host, frames included.
+         */
+        uint64_t bytes_received() const { return bytes_received_; }
+        uint64_t bytes_sent() const { return bytes_sent_; }
+
+    public:
+        void flushRxBuffer();
+        void flushTxBuffer() {}
+        ssr::RETVAL getSizeInRxBuffer();
+        ssr::RETVAL write(const uint8_t *src, const uint8_t size);
+        ssr::RETVAL read(uint8_t *dst, const uint8_t size);
+        ssr::RETVAL getSenderInfo(uint8_t *) { return 0; }
+        ssr::RETVAL waitRxReady(const uint32_t timeout_usec);
+
+    private:
+        void handle(const packet_t &request);
+        void handle_send_data(const packet_t &request);
+        void handle_receive_data(const packet_t &request);
+        void handle_send_data_fragment(const packet_t &request);
+        void handle_receive_data_fragment(const packet_t &request);
+        void handle_batch_cycle(const packet_t &request);
+        void handle_state(const packet_t &request);
+        RESULT execute();
+        void activate();
+        void release_due();
+        void release(const int64_t now_nsec);
+        bool store(port_t &port, const uint8_t *value, const size_t size);
+        void load(const port_t &port, std::vector<uint8_t> &payload);
+        void reply(const packet_t &packet);
+        port_t *find(std::vector<port_t> &ports, const uint8_t *name, const uint8_t name_len);
+    };
+
+#ifndef WIN32
+    /**
+     * Pseudo terminal served by a simulator_t, so programs which open a serial port by name
+     * (rtno2, rtno_test, com2tcp) talk to the simulator through name(), e.g. /dev/pts/3.
+     *
+     * A thread moves requests from the terminal to the simulator and replies back. It polls every millisecond,
+     * so delayed replies and heartbeats go out within a millisecond of their time.
+     */
+    class simulator_pty_t
+    {
+    private:
+        simulator_t &simulator_;
+        int master_;
+        int slave_; // kept open, so the terminal survives clients closing it
+        std::string name_;
+        std::atomic<bool> running_;
+        std::thread thread_;
+
+    public:
+        simulator_pty_t(simulator_t &simulator) : simulator_(simulator), master_(-1), slave_(-1), running_(false) {}
+        ~simulator_pty_t() { close(); }
+
+    public:
+        /**
+         * @brief Open the pty in raw mode and start serving it.
+         * @return RESULT::ERR if no pty is available.
+         */
+        RESULT open();
+        void close();
+
+        /**
+         * @brief Path of the terminal for clients. Empty until open().
+         */
+        const std::string &name() const { return name_; }
+
+    private:
+        void serve();
+    };
+#endif
+}
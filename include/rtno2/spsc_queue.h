@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <atomic>
+#include <new>
+#include <utility>
+
+namespace ssr::rtno2
+{
+
+    /**
+     * Bounded lock-free queue for exactly one producer thread and one consumer thread.
+     *
+     * push() is called only by the producer, front() / pop() / clear() only by the consumer.
+     * CAPACITY must be a power of two. Elements live in inline storage, so the queue never allocates.
+     */
+    template <typename T, size_t CAPACITY>
+    class spsc_queue_t
+    {
+        static_assert(CAPACITY > 0 && (CAPACITY & (CAPACITY - 1)) == 0, "CAPACITY must be a power of two");
+
+    private:
+        alignas(64) std::atomic<size_t> head_; // next slot to pop (consumer)
+        alignas(64) std::atomic<size_t> tail_; // next slot to push (producer)
+        alignas(T) unsigned char storage_[sizeof(T) * CAPACITY];
+
+    public:
+        spsc_queue_t() : head_(0), tail_(0) {}
+        ~spsc_queue_t() { clear(); }
+
+        spsc_queue_t(const spsc_queue_t &) = delete;
+        spsc_queue_t &operator=(const spsc_queue_t &) = delete;
+
+    public:
+        /**
+         * @brief Append an element. Returns false (and drops value) if the queue is full.
+         */
+        template <typename U>
+        bool push(U &&value)
+        {
+            const size_t tail = tail_.load(std::memory_order_relaxed);
+            if (tail - head_.load(std::memory_order_acquire) == CAPACITY)
+            {
+                return false;
+            }
+            new (slot(tail)) T(std::forward<U>(value));
+            tail_.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        /**
+         * @brief Oldest element, or nullptr if the queue is empty.
+         */
+        T *front()
+        {
+            const size_t head = head_.load(std::memory_order_relaxed);
+            if (head == tail_.load(std::memory_order_acquire))
+            {
+                return nullptr;
+            }
+            return slot(head);
+        }
+
+        /**
+         * @brief Remove the element returned by front(). The queue must not be empty.
+         */
+        void pop()
+        {
+            const size_t head = head_.load(std::memory_order_relaxed);
+            slot(head)->~T();
+            head_.store(head + 1, std::memory_order_release);
+        }
+
+        void clear()
+        {
+            while (front() != nullptr)
+            {
+                pop();
+            }
+        }
+
+        bool empty() const
+        {
+            return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+        }
+
+        size_t size() const
+        {
+            return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+        }
+
+        static constexpr size_t capacity() { return CAPACITY; }
+
+    private:
+        T *slot(const size_t index)
+        {
+            return std::launder(reinterpret_cast<T *>(storage_ + sizeof(T) * (index & (CAPACITY - 1))));
+        }
+    };
+}
@@ -5,38 +5,198 @@
 #include "result.h"
 #include "hal/SerialDevice.h"
 #include "logger.h"
+#include "deadline.h"
+#include "wait_policy.h"
+#include "frame_decoder.h"
+#include "spsc_queue.h"
 #include <string>
+#include <vector>
+#include <array>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 #include <exception>
+#include <memory>
+
+#define PACKET_MAX_FRAME_SIZE FRAME_MAX_SIZE
 
 namespace ssr::rtno2
 {
 
+	/**
+	 * Frame transport over SerialDevice.
+	 *
+	 * Decoded packets are routed into one queue per COMMAND, and HEART_BEAT packets only advance a liveness counter.
+	 * By default the caller's thread reads the device while it waits in receive().
+	 * After start_receiver() a background thread decodes continuously and callers only wait on the queues.
+	 * Either way a packet which nobody is waiting for stays in its queue instead of being dropped.
+	 *
+	 * Frames are sent in V1 until set_framing(FRAMING::V2). Both formats are decoded until then, and only V2 afterwards.
+	 * In V2 every sent frame gets the next 8-bit frame id, and receive() can wait for the reply to a given id.
+	 */
 	class transport_t
 	{
+	public:
+		static const size_t RECEIVE_QUEUE_CAPACITY = 16;
+		static const int ANY_FRAME_ID = -1; // also the frame id of V1 frames
+
 	private:
+		struct received_t
+		{
+			uint64_t sequence;
+			int16_t frame_id;
+			packet_t packet;
+		};
+		typedef spsc_queue_t<received_t, RECEIVE_QUEUE_CAPACITY> receive_queue_t;
+
 	protected:
 		SerialDevice *serial_device_;
 		uint8_t sender_info_[PACKET_SENDER_INFO_LENGTH];
 		logger_t logger_;
+		wait_policy_t wait_policy_;
+		uint32_t send_pacing_usec_;
+		frame_decoder_t decoder_;
+		std::vector<uint8_t> tx_buffer_;
+		std::atomic<FRAMING> framing_; // also read by the receive thread
+		uint8_t next_frame_id_;
+		int last_frame_id_;
+
+		std::array<int8_t, 256> queue_index_;
+		std::unique_ptr<receive_queue_t[]> queues_;
+		uint64_t sequence_;
+		std::atomic<uint64_t> checksum_errors_; // broken frames decoded so far
+		uint64_t checksum_errors_reported_;		// by receive(), to the consumer thread
+		std::atomic<uint64_t> heartbeat_count_;
+		std::atomic<int64_t> last_heartbeat_nsec_;
+		std::atomic<uint64_t> dropped_count_;
+
+		std::thread receiver_;
+		std::atomic<bool> receiver_running_;
+		std::mutex mutex_;
+		std::condition_variable cond_;
+		std::atomic<int> waiters_;
 
 	public:
-		transport_t(SerialDevice *pSerialDevice, ssr::rtno2::LOGLEVEL loglevel);
+		transport_t(SerialDevice *pSerialDevice, ssr::rtno2::LOGLEVEL loglevel, const wait_policy_t &wait_policy = wait_policy_t::blocking());
 		~transport_t(void);
 
 	public:
-		RESULT send(const packet_t &packet);
-		result_t<packet_t> receive(const uint32_t wait_usec);
+		RESULT send(const packet_t &packet) { return send(packet, packet.getSum()); }
 
-		RESULT is_new(const uint32_t wait_usec = 1000 * 1000);
+		/**
+		 * @brief Send packet with a checksum the caller already knows (e.g. updated incrementally by a port handle).
+		 */
+		RESULT send(const packet_t &packet, const uint8_t sum);
 
-	private:
-		RESULT read(uint8_t *buffer, uint8_t size, const uint32_t wait_usec = 1000 * 1000);
-		RESULT write(const uint8_t *buffer, const uint8_t size);
+		/**
+		 * @brief Send frames back-to-back in one write.
+		 */
+		RESULT send(const std::vector<const packet_t *> &packets);
+
+		/**
+		 * @brief Next packet in arrival order, whatever its COMMAND (HEART_BEAT excluded).
+		 * @param frame_id [out] frame id of the packet, or ANY_FRAME_ID for V1. Ignored if NULL.
+		 */
+		result_t<packet_t> receive(const deadline_t deadline, int *frame_id = NULL);
+		result_t<packet_t> receive(const uint32_t wait_usec) { return receive(deadline_after(wait_usec)); }
+
+		/**
+		 * @brief Next packet of command, or a PACKET_ERROR packet. Packets of other commands stay queued.
+		 *
+		 * A broken frame cannot be told apart by command. It ends the wait with RESULT::CHECKSUM_ERROR only if it
+		 * was decoded during this call and nothing for command has arrived, so it does not end waits started later.
+		 * @param frame_id unless ANY_FRAME_ID, V2 packets of command with another frame id (late replies) are dropped.
+		 */
+		result_t<packet_t> receive(const COMMAND command, const deadline_t deadline, const int frame_id = ANY_FRAME_ID);
+
+		RESULT is_new(const deadline_t deadline);
+		RESULT is_new(const uint32_t wait_usec = 1000 * 1000) { return is_new(deadline_after(wait_usec)); }
+
+		/**
+		 * @brief Drop queued packets of command (e.g. late replies to an earlier request).
+		 */
+		void discard(const COMMAND command);
+
+		/**
+		 * @brief Replace the device (e.g. after re-opening it). The receive thread, if running, is restarted.
+		 */
+		void set_serial_device(SerialDevice *serial_device);
 
 	public:
-		void clear_rx_buffer()
+		/**
+		 * @brief Start the background receive thread. Receive calls must then come from one consumer thread.
+		 *
+		 * Off by default. It does not shorten a request/reply round trip (see rtno_bench demux), but keeps the
+		 * device drained and HEART_BEAT counted while the caller is busy between requests.
+		 */
+		RESULT start_receiver();
+		void stop_receiver();
+		bool is_receiver_running() const { return receiver_running_.load(); }
+
+		/**
+		 * @brief Number of HEART_BEAT packets received so far.
+		 */
+		uint64_t heartbeat_count() const { return heartbeat_count_.load(std::memory_order_relaxed); }
+
+		/**
+		 * @brief Time of the latest HEART_BEAT, or time_point() if none arrived yet.
+		 */
+		monotonic_clock::time_point last_heartbeat() const
 		{
-			serial_device_->flushRxBuffer();
+			return monotonic_clock::time_point(monotonic_clock::duration(last_heartbeat_nsec_.load(std::memory_order_relaxed)));
 		}
+
+		/**
+		 * @brief Number of packets dropped because their queue was full.
+		 */
+		uint64_t dropped_count() const { return dropped_count_.load(std::memory_order_relaxed); }
+
+	public:
+		/**
+		 * @brief Frame format of sent frames, and of received ones once V2 (see frame_decoder_t::set_negotiated()).
+		 * Switch to V2 only after RTno accepted CAPABILITY_FRAMING_V2, and back to V1 for the profile exchange.
+		 */
+		void set_framing(const FRAMING framing) { framing_.store(framing); }
+		FRAMING framing() const { return framing_.load(); }
+
+		/**
+		 * @brief Frame id of the last frame sent, or ANY_FRAME_ID in V1. Ids of a batch are consecutive (mod 256).
+		 */
+		int last_frame_id() const { return last_frame_id_; }
+
+	public:
+		void set_wait_policy(const wait_policy_t &wait_policy) { wait_policy_ = wait_policy; }
+		const wait_policy_t &wait_policy() const { return wait_policy_; }
+
+		/**
+		 * @brief Pace transmission byte by byte for firmware that drops bytes of a burst.
+		 * @param interbyte_delay_usec delay after each byte (e.g. PACKET_SENDING_DELAY). Zero disables pacing (default).
+		 */
+		void set_send_pacing(const uint32_t interbyte_delay_usec) { send_pacing_usec_ = interbyte_delay_usec; }
+
+	private:
+		RESULT wait_rx(const deadline_t deadline, int &available);
+		RESULT fill(const deadline_t deadline);
+		RESULT write(const uint8_t *buffer, const size_t size);
+
+		void receiver_main();
+		RESULT pump(const deadline_t deadline);
+		int decode_all();
+		void dispatch(const packet_t &packet, const int frame_id);
+		size_t encode(uint8_t *dst, const packet_t &packet, const uint8_t sum);
+		receive_queue_t *queue_of(const COMMAND command);
+		receive_queue_t *oldest_queue();
+		template <typename READY>
+		RESULT wait_queued(const READY &ready, const deadline_t deadline, const uint64_t checksum_errors_before);
+		RESULT timeout_result();
+
+	public:
+		/**
+		 * @brief Drop everything received so far.
+		 *
+		 * With the receive thread running only the queues are cleared, since the device belongs to the thread.
+		 */
+		void clear_rx_buffer();
 	};
 };
@@ -1,7 +1,10 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <sstream>
+#include <vector>
+#include <type_traits>
 
 namespace ssr::rtno2
 {
@@ -24,42 +27,100 @@ namespace ssr::rtno2
         TIMED_DOUBLE_SEQ = 'D',
     };
 
-    inline std::string typecode_to_str(TYPECODE typecode)
+    /**
+     * X(code, name, element type, is sequence, on-wire width of one element)
+     *
+     * Every typed path (typecode_traits, value_typecode, visit_port, typecode_to_str) is generated from this table.
+     * TimedDouble is 8 bytes wide except on AVR, whose double is a float (see wire_width() in codec.h).
+     */
+#define RTNO_TYPECODE_TABLE(X)                                      \
+    X(TIMED_BOOLEAN, "TimedBoolean", bool, false, 1)                \
+    X(TIMED_OCTET, "TimedOctet", uint8_t, false, 1)                 \
+    X(TIMED_CHAR, "TimedChar", char, false, 1)                      \
+    X(TIMED_LONG, "TimedLong", int32_t, false, 4)                   \
+    X(TIMED_FLOAT, "TimedFloat", float, false, 4)                   \
+    X(TIMED_DOUBLE, "TimedDouble", double, false, 8)                \
+    X(TIMED_BOOLEAN_SEQ, "TimedBooleanSeq", bool, true, 1)          \
+    X(TIMED_OCTET_SEQ, "TimedOctetSeq", uint8_t, true, 1)           \
+    X(TIMED_CHAR_SEQ, "TimedCharSeq", char, true, 1)                \
+    X(TIMED_LONG_SEQ, "TimedLongSeq", int32_t, true, 4)             \
+    X(TIMED_FLOAT_SEQ, "TimedFloatSeq", float, true, 4)             \
+    X(TIMED_DOUBLE_SEQ, "TimedDoubleSeq", double, true, 8)
+
+    /**
+     * Compile-time properties of a TYPECODE.
+     *  - element_type: C++ type of one element
+     *  - value_type: element_type, or std::vector<element_type> for sequences
+     *  - wire_width: bytes of one element on the wire
+     */
+    template <TYPECODE CODE>
+    struct typecode_traits;
+
+#define RTNO_TYPECODE_TRAITS(CODE, NAME, ELEMENT, SEQUENCE, WIDTH)                              \
+    template <>                                                                                 \
+    struct typecode_traits<TYPECODE::CODE>                                                      \
+    {                                                                                           \
+        static constexpr TYPECODE typecode = TYPECODE::CODE;                                    \
+        static constexpr const char *name = NAME;                                               \
+        using element_type = ELEMENT;                                                           \
+        static constexpr bool is_sequence = SEQUENCE;                                           \
+        static constexpr uint8_t wire_width = WIDTH;                                            \
+        using value_type = std::conditional_t<SEQUENCE, std::vector<ELEMENT>, ELEMENT>;         \
+    };
+
+    RTNO_TYPECODE_TABLE(RTNO_TYPECODE_TRAITS)
+#undef RTNO_TYPECODE_TRAITS
+
+    /**
+     * Reverse lookup: TYPECODE of a value_type (e.g. value_typecode<std::vector<float>>::value is TIMED_FLOAT_SEQ).
+     */
+    template <typename T>
+    struct value_typecode;
+
+#define RTNO_VALUE_TYPECODE(CODE, NAME, ELEMENT, SEQUENCE, WIDTH)                               \
+    template <>                                                                                 \
+    struct value_typecode<typecode_traits<TYPECODE::CODE>::value_type>                          \
+    {                                                                                           \
+        static constexpr TYPECODE value = TYPECODE::CODE;                                       \
+    };
+
+    RTNO_TYPECODE_TABLE(RTNO_VALUE_TYPECODE)
+#undef RTNO_VALUE_TYPECODE
+
+    /**
+     * @brief Call f(typecode_traits<typecode>()) for a TYPECODE known at runtime.
+     *
+     * The switch is generated from RTNO_TYPECODE_TABLE, so f is instantiated once per TYPECODE
+     * and every TYPECODE is handled.
+     * @return false (without calling f) if typecode is unknown.
+     */
+    template <typename F>
+    inline bool visit_port(const TYPECODE typecode, F &&f)
     {
         switch (typecode)
         {
-        case TYPECODE::TIMED_BOOLEAN:
-            return "TimedBoolean";
-        case TYPECODE::TIMED_CHAR:
-            return "TimedChar";
-        case TYPECODE::TIMED_OCTET:
-            return "TimedOctet";
-        case TYPECODE::TIMED_LONG:
-            return "TimedLong";
-        case TYPECODE::TIMED_FLOAT:
-            return "TimedFloat";
-        case TYPECODE::TIMED_DOUBLE:
-            return "TimedDouble";
-
-        case TYPECODE::TIMED_BOOLEAN_SEQ:
-            return "TimedBooleanSeq";
-        case TYPECODE::TIMED_CHAR_SEQ:
-            return "TimedCharSeq";
-        case TYPECODE::TIMED_OCTET_SEQ:
-            return "TimedOctetSeq";
+#define RTNO_VISIT_PORT_CASE(CODE, NAME, ELEMENT, SEQUENCE, WIDTH) \
+    case TYPECODE::CODE:                                           \
+        f(typecode_traits<TYPECODE::CODE>());                      \
+        return true;
 
-        case TYPECODE::TIMED_LONG_SEQ:
-            return "TimedLongSeq";
-        case TYPECODE::TIMED_FLOAT_SEQ:
-            return "TimedFloatSeq";
-        case TYPECODE::TIMED_DOUBLE_SEQ:
-            return "TimedDoubleSeq";
+            RTNO_TYPECODE_TABLE(RTNO_VISIT_PORT_CASE)
+#undef RTNO_VISIT_PORT_CASE
         default:
+            return false;
+        }
+    }
+
+    inline std::string typecode_to_str(TYPECODE typecode)
+    {
+        std::string name;
+        if (!visit_port(typecode, [&name](auto traits)
+                        { name = decltype(traits)::name; }))
         {
             std::ostringstream oss;
             oss << "UnknownTypeCode(" << static_cast<int>(typecode) << ")";
             return oss.str();
         }
-        }
+        return name;
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <sstream>
+
+namespace ssr::rtno2
+{
+
+    /**
+     * How transport_t waits for receive data from SerialDevice.
+     */
+    enum class WAIT_MODE : uint8_t
+    {
+        BLOCKING = 1,        // Sleep until the device becomes readable (fd readiness).
+        SPIN_THEN_BLOCK = 2, // Busy-poll for spin_usec, then sleep like BLOCKING.
+        BUSY_POLL = 3,       // Busy-poll until data or deadline. Lowest latency, burns a core.
+    };
+
+    inline std::string wait_mode_to_string(WAIT_MODE mode)
+    {
+        switch (mode)
+        {
+        case WAIT_MODE::BLOCKING:
+            return "WAIT_MODE::BLOCKING";
+        case WAIT_MODE::SPIN_THEN_BLOCK:
+            return "WAIT_MODE::SPIN_THEN_BLOCK";
+        case WAIT_MODE::BUSY_POLL:
+            return "WAIT_MODE::BUSY_POLL";
+        default:
+        {
+            std::stringstream ss;
+            ss << "WAIT_MODE::UNKNOWN(" << (int)mode << ")";
+            return ss.str();
+        }
+        }
+    }
+
+    struct wait_policy_t
+    {
+    public:
+        WAIT_MODE mode;
+        uint32_t spin_usec;
+
+    public:
+        static wait_policy_t blocking()
+        {
+            return wait_policy_t{WAIT_MODE::BLOCKING, 0};
+        }
+
+        static wait_policy_t spin_then_block(const uint32_t spin_usec = 50)
+        {
+            return wait_policy_t{WAIT_MODE::SPIN_THEN_BLOCK, spin_usec};
+        }
+
+        static wait_policy_t busy_poll()
+        {
+            return wait_policy_t{WAIT_MODE::BUSY_POLL, 0};
+        }
+
+    public:
+        std::string to_string() const
+        {
+            std::stringstream ss;
+            ss << "wait_policy_t(mode=" << wait_mode_to_string(mode) << ", spin_usec=" << spin_usec << ")";
+            return ss.str();
+        }
+    };
+}
@@ -1,15 +1,33 @@
 #include <iostream>
 
-#include <thread>
-#include <chrono>
+#include <memory>
+#include <vector>
+#include <csignal>
 
 #include <spdlog/spdlog.h>
 #include <spdlog/sinks/stdout_color_sinks.h>
 #include <spdlog/sinks/basic_file_sink.h>
 
-#include "hal/Socket.h"
-#include "hal/ServerSocket.h"
 #include "hal/Serial.h"
+#include "rtno2/relay.h"
+
+static ssr::rtno2::relay_t *running_relay = nullptr;
+
+static void on_signal(int)
+{
+    if (running_relay)
+    {
+        running_relay->stop();
+    }
+}
+
+static void print_usage()
+{
+    std::cout << "Usage: com2tcp SERIAL BAUDRATE [PORT=10000] [SERIAL BAUDRATE PORT]..." << std::endl;
+    std::cout << "  Broker each serial port to the TCP clients connected to its port, all in one process." << std::endl;
+    std::cout << "  Clients of a port take turns on the serial line, one request/reply transaction at a time," << std::endl;
+    std::cout << "  and identical GET_STATE / GET_PROFILE requests share one reply." << std::endl;
+}
 
 int main(const int argc, const char *argv[])
 {
@@ -26,124 +44,45 @@ int main(const int argc, const char *argv[])
     std::vector<std::shared_ptr<spdlog::sinks::sink>> sink_list = {file_sink, console_sink};
 
     auto logger = spdlog::logger("com2tcp", sink_list.begin(), sink_list.end());
+    if (argc < 3 || (argc > 4 && (argc - 1) % 3 != 0))
+    {
+        print_usage();
+        return -1;
+    }
     logger.info("com2tcp started.");
     try
     {
-        const std::string filename = argv[1];
-        const int baudrate = atoi(argv[2]);
-        const int port_number = (argc >= 4) ? atoi(argv[3]) : 10000;
-
-        ssr::ServerSocket ss;
-        ss.bind(port_number);
-        ss.listen();
-        while (true)
+        ssr::rtno2::relay_t relay;
+        // Serial ports stay open (and owned by this process) for as long as it runs.
+        std::vector<std::unique_ptr<ssr::Serial>> serials;
+        for (int i = 1; i < argc; i += 3)
         {
-            logger.info(" - com2tcp listening on port {}", port_number);
-            ssr::Socket socket = ss.accept();
+            const std::string filename = argv[i];
+            const int baudrate = atoi(argv[i + 1]);
+            const int port_number = (i + 2 < argc) ? atoi(argv[i + 2]) : 10000;
 
-            auto pid = fork();
-            if (pid == 0)
+            serials.emplace_back(new ssr::Serial(filename.c_str(), baudrate));
+            logger.info(" - com2tcp serial port opened : {} {}", filename, baudrate);
+            if (relay.add(serials.back()->getFileDescriptor(), port_number) != ssr::rtno2::RESULT::OK)
             {
-                logger.info(" - com2tcp connected.");
-
-                if (socket.setNonBlock(true) < 0)
-                {
-                    logger.error(" - com2tcp setNonBlock failed");
-                    break;
-                }
-                logger.info(" - com2tcp connected.");
-                ssr::Serial s(filename.c_str(), baudrate);
-                s.flushRxBuffer();
-                logger.info(" - com2tcp serial port opened : {} {}", filename, baudrate);
-
-                const size_t MAX_BUFFER = 1024;
-                uint8_t buffer[MAX_BUFFER];
-                memset(buffer, 0, MAX_BUFFER);
-
-                while (true)
-                {
-                    // std::cout << "while loop start" << std::endl;
-                    logger.info(" - com2tcp check serial receive");
-                    int received_size;
-                    if ((received_size = s.getSizeInRxBuffer()) < 0)
-                    {
-                        // Error failed.
-                        logger.error(" - com2tcp getSizeInRxBuffer failed.");
-                        break;
-                    }
-                    else if (received_size == 0)
-                    {
-                        logger.info(" - com2tcp No data received from serial.");
-                    }
-                    else // if (received_size > 0)
-                    {
-                        logger.debug(" - com2tcp sending data size: {} to socket", received_size);
-                        if (received_size > MAX_BUFFER)
-                        {
-                            received_size = MAX_BUFFER;
-                        }
-                        if (s.read(buffer, received_size) < 0)
-                        {
-                            logger.error(" - com2tcp read failed.");
-                            break;
-                        }
-                        logger.debug(" - com2tcp sending data to socket");
-                        // Write function always blocks when peer is shutdown.
-                        // Use thread to avoid blocking main loop.
-
-                        if (socket.write(buffer, received_size) < 0)
-                        {
-                            logger.error(" - com2tcp send failed.");
-                            break;
-                        }
-                        perror("com2tcp send failed");
-                    }
-
-                    logger.info(" - com2tcp check socket receive");
-                    if ((received_size = socket.getSizeInRxBuffer()) < 0)
-                    {
-                        // Error
-                        logger.error(" - com2tcp getSizeInRxBuffer failed.");
-                        break;
-                    }
-                    else if (received_size == 0)
-                    {
-                        logger.info(" - com2tcp No data received from socket.");
-                    }
-                    else // if (received_size > 0)
-                    {
-                        logger.debug(" - com2tcp receiving data size: {}", received_size);
-                        if ((received_size = socket.read(buffer, received_size)) < 0)
-                        {
-                            logger.error(" - com2tcp recv failed (received_size={})", received_size);
-                            continue;
-                        }
-                        if (received_size > 0)
-                        {
-                            if (s.write(buffer, received_size) < 0)
-                            {
-                                logger.error(" - com2tcp write failed.");
-                                break;
-                            }
-                        }
-                    }
-                    logger.debug(" - com2tcp sleep 1 microsecond");
-                    std::this_thread::sleep_for(std::chrono::microseconds(1));
-                } // while
-            } // if pid==0
-            else if (pid > 0)
-            {
-                logger.info(" - com2tcp forked child process pid={}", pid);
-                continue;
-            }
-            else
-            {
-                logger.error(" - com2tcp fork failed.");
+                logger.error(" - com2tcp can not listen on port {}", port_number);
+                return -1;
             }
-            logger.info(" - com2tcp disconnected.");
+            logger.info(" - com2tcp listening on port {}", port_number);
         }
-        logger.info(" - com2tcp server socket closed.");
-        return 0;
+
+        running_relay = &relay;
+        std::signal(SIGINT, on_signal);
+        std::signal(SIGTERM, on_signal);
+        const auto result = relay.run();
+        running_relay = nullptr;
+
+        const auto &statistics = relay.statistics();
+        logger.info(" - com2tcp stopped: {} bytes serial to tcp, {} bytes tcp to serial, {} transactions ({} timed out), {} requests coalesced, "
+                    "{} clients ({} refused), {} wakeups",
+                    statistics.serial_to_tcp, statistics.tcp_to_serial, statistics.transactions, statistics.timeouts, statistics.coalesced,
+                    statistics.clients, statistics.refused, statistics.wakeups);
+        return result == ssr::rtno2::RESULT::OK ? 0 : -1;
     }
     catch (const std::exception &e)
     {
@@ -151,4 +90,4 @@ int main(const int argc, const char *argv[])
         logger.error(" - com2tcp Exception: {}", e.what());
         return -1;
     }
-}
\ No newline at end of file
+}
@@ -2,98 +2,40 @@
 #include <iostream>
 #include <thread>
 #include <chrono>
-#include <mutex>
-#include <queue>
-
-#define BUFSIZE 1024
-uint8_t buffer[BUFSIZE];
-int32_t buffer_start = 0;
-int32_t buffer_end = 0;
-
-std::queue<uint8_t> buf_queue;
-
-std::mutex buffer_mutex;
-
-void buffer_push(uint8_t dat)
-{
-	std::lock_guard<std::mutex> lock(buffer_mutex);
-	// buffer[buffer_end] = dat;
-	// buffer_end++;
-	// if (buffer_end >= BUFSIZE)
-	// {
-	// 	buffer_end = 0;
-	// }
-	buf_queue.push(dat);
-}
-
-void buffer_push(uint8_t *data, size_t size)
-{
-	// std::lock_guard<std::mutex> lock(buffer_mutex);
-	for (size_t i = 0; i < size; i++)
-	{
-		buffer_push(data[i]);
-	}
-}
-
-uint8_t buffer_pop()
-{
-	std::lock_guard<std::mutex> lock(buffer_mutex);
-	// uint8_t dat = buffer[buffer_start];
-	// buffer_start++;
-	// if (buffer_start >= BUFSIZE)
-	// {
-	// 	buffer_start = 0;
-	// }
-	// return dat;
-	uint8_t dat = buf_queue.front();
-	buf_queue.pop();
-	return dat;
-}
-
-void buffer_clear()
-{
-	std::lock_guard<std::mutex> lock(buffer_mutex);
-	// buffer_start = 0;
-	// buffer_end = 0;
-	while (!buf_queue.empty())
-	{
-		buf_queue.pop();
-	}
-}
-
-int32_t get_buffer_size()
-{
-	std::lock_guard<std::mutex> lock(buffer_mutex);
-	// int32_t size = buffer_end - buffer_start;
-	// if (size < 0)
-	// {
-	// 	size += BUFSIZE;
-	// }
-	// return size;
-	return buf_queue.size();
-}
+#include <algorithm>
 
 using namespace ssr;
 
-EtherTcp::EtherTcp(const char *ipAddress, int32_t port)
+EtherTcp::EtherTcp(const char *ipAddress, int32_t port, const ReceiveMode receiveMode, const size_t rxBufferSize, const OverflowPolicy overflowPolicy)
+	: m_ReceiveMode(receiveMode), m_Endflag(0), m_Closed(false), m_RxBuffer(rxBufferSize), m_OverflowPolicy(overflowPolicy), m_DroppedSize(0)
 {
 	m_pSocket = new ssr::Socket(ipAddress, port);
-	m_thread = std::thread([this]
-						   { this->svc(); });
+	// RTno frames are a few bytes each, and every request waits for its reply. Nagle's algorithm would hold
+	// a request until the previous segment is acknowledged, and a delayed ACK takes up to 40 ms to come.
+	m_pSocket->setNoDelay(true);
+	m_pSocket->setQuickAck(true);
+	if (m_ReceiveMode == RECEIVE_THREAD)
+	{
+		m_thread = std::thread([this]
+							   { this->svc(); });
+	}
 }
 
 EtherTcp::~EtherTcp()
 {
 	std::cout << "EtherTcp::~EtherTcp() called" << std::endl;
 	m_Endflag = 1;
-	m_thread.join();
+	if (m_thread.joinable())
+	{
+		m_thread.join();
+	}
 	delete m_pSocket;
 }
 
 void EtherTcp::flushRxBuffer()
 {
 	// Clear the receive buffer
-	buffer_clear();
+	m_RxBuffer.clear();
 }
 
 /**
@@ -110,27 +52,11 @@ void EtherTcp::flushTxBuffer()
  */
 RETVAL EtherTcp::getSizeInRxBuffer()
 {
-	/*
-		fd_set read_fdset;
-		FD_ZERO(&read_fdset);
-		FD_SET(m_ServerSocket, &read_fdset);
-
-		select(0, &read_fdset, NULL, NULL, NULL);
-
-		if(FD_ISSET(m_ServerSocket, &read_fdset)) {
-			uint8_t buf[BUFSIZE];
-			RETVAL readable_size = BUFSIZE - get_buffer_size();
-			RETVAL read_size = recv(m_ServerSocket, (char*)buf, readable_size, 0);
-			for(RETVAL i = 0;i < read_size;i++) {
-				buffer_push(buf[i]);
-			}
-		}
-
-		return get_buffer_size();;
-	*/
-	//	return 256;
-
-	return ::get_buffer_size();
+	if (m_ReceiveMode == RECEIVE_ON_READ)
+	{
+		receive();
+	}
+	return static_cast<RETVAL>(m_RxBuffer.getSize());
 }
 
 /**
@@ -148,54 +74,120 @@ RETVAL EtherTcp::write(const uint8_t *src, const uint8_t size)
 	return retval;
 }
 
+RETVAL EtherTcp::writeMore(const uint8_t *src, const uint8_t size)
+{
+	int retval = m_pSocket->writeMore(src, size);
+	if (retval < 0)
+	{
+		std::cerr << "[EtherTcp] write error." << std::endl;
+		perror("EtherTcp::writeMore error");
+	}
+	return retval;
+}
+
 /**
  * @brief read data from RxBuffer of Serial Port
  */
 RETVAL EtherTcp::read(uint8_t *dst, const uint8_t size)
 {
-	// return recv(m_ServerSocket, (char*)dst, size, 0);
-	uint8_t *dist_buf = (uint8_t *)dst;
-	uint32_t size_read = size;
-	if (size >= (uint32_t)get_buffer_size())
+	if (m_ReceiveMode == RECEIVE_ON_READ && m_RxBuffer.getSize() < size)
 	{
-		size_read = get_buffer_size();
+		receive();
 	}
-	for (uint32_t i = 0; i < size_read; i++)
+	return static_cast<RETVAL>(m_RxBuffer.pop(dst, size));
+}
+
+void EtherTcp::receive()
+{
+	// Twice, in case the free space wraps around the end of the ring.
+	for (int i = 0; i < 2; i++)
 	{
-		dist_buf[i] = buffer_pop();
+		size_t writable;
+		uint8_t *dst = m_RxBuffer.prepare(writable);
+		if (writable == 0)
+		{
+			return;
+		}
+		const int sz = m_pSocket->readNonBlocking(dst, static_cast<unsigned int>(writable));
+		if (sz <= 0)
+		{
+			m_Closed = m_Closed || sz == 0;
+			return;
+		}
+		m_RxBuffer.commit(sz);
+		if ((size_t)sz < writable)
+		{
+			return;
+		}
 	}
+}
 
-	return size_read;
+int EtherTcp::getFileDescriptor()
+{
+	return m_ReceiveMode == RECEIVE_ON_READ ? m_pSocket->getFileDescriptor() : -1;
+}
+
+RETVAL EtherTcp::waitRxReady(const uint32_t timeout_usec)
+{
+	if (m_RxBuffer.getSize() > 0)
+	{
+		return 1;
+	}
+	if (m_ReceiveMode == RECEIVE_ON_READ)
+	{
+		if (m_Closed)
+		{
+			return -1;
+		}
+		// Readable also when the peer has closed; the next receive() notices it.
+		return SerialDevice::waitRxReady(timeout_usec);
+	}
+	std::unique_lock<std::mutex> lock(m_RxMutex);
+	return m_RxReady.wait_for(lock, std::chrono::microseconds(timeout_usec), [this]
+							  { return m_RxBuffer.getSize() > 0 || m_Endflag; })
+			   ? (m_RxBuffer.getSize() > 0 ? 1 : -1)
+			   : 0;
 }
 
 RETVAL EtherTcp::svc(void)
 {
-	m_Endflag = 0;
 	m_pSocket->setNonBlock(1);
+	const int BUFFER_SIZE = 1024;
+	uint8_t buffer[BUFFER_SIZE];
 	while (!m_Endflag)
 	{
 		std::this_thread::sleep_for(std::chrono::microseconds(1));
-		uint8_t buf;
-		const int BUFFER_SIZE = 1024;
-		uint8_t buffer[BUFFER_SIZE];
-		int32_t receive_size;
-		if ((receive_size = m_pSocket->getSizeInRxBuffer()) > 0)
+		int32_t receive_size = m_pSocket->getSizeInRxBuffer();
+		if (receive_size <= 0)
+		{
+			continue;
+		}
+		receive_size = std::min(receive_size, BUFFER_SIZE);
+		if (m_OverflowPolicy == OVERFLOW_BACKPRESSURE)
 		{
-			int32_t sz = m_pSocket->read(buffer, receive_size > BUFFER_SIZE ? BUFFER_SIZE : receive_size);
-			if (sz > 0)
+			// Leave the rest in the socket; the peer stalls once its window fills.
+			receive_size = std::min(receive_size, static_cast<int32_t>(m_RxBuffer.getFreeSize()));
+			if (receive_size == 0)
 			{
-				// buffer_push(buffer[0]);
-				buffer_push(buffer, sz);
+				continue;
 			}
-			else if (sz < 0)
+		}
+		int32_t sz = m_pSocket->read(buffer, receive_size);
+		if (sz > 0)
+		{
+			const size_t pushed = m_RxBuffer.push(buffer, sz);
+			m_DroppedSize.fetch_add(sz - pushed, std::memory_order_relaxed);
 			{
-				// Error
-				// std::cerr << "[EtherTcp] read error." << std::endl;
-				// perror("EtherTcp::svc read error");
-				// exit(-1);
+				// Taking the mutex orders the push before a reader that is about to sleep.
+				std::lock_guard<std::mutex> lock(m_RxMutex);
 			}
+			m_RxReady.notify_all();
 		}
 	}
+	{
+		std::lock_guard<std::mutex> lock(m_RxMutex);
+	}
+	m_RxReady.notify_all();
 	return 0;
 }
 
@@ -254,3 +254,14 @@ int SerialPort::read(void *dst, const unsigned int size)
 	return ret;
 #endif
 }
+
+/*******************************
+ */
+int SerialPort::getFileDescriptor()
+{
+#ifdef WIN32
+	return -1;
+#else
+	return m_Fd;
+#endif
+}
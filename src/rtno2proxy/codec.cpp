@@ -0,0 +1,150 @@
+#include "rtno2/codec.h"
+
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define RTNO_CODEC_SSE2
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define RTNO_CODEC_NEON
+#endif
+
+using namespace ssr::rtno2;
+
+void ssr::rtno2::codec_narrow_double(uint8_t *dst, const double *src, const size_t count)
+{
+	size_t i = 0;
+#if defined(RTNO_CODEC_SSE2)
+	for (; i + 4 <= count; i += 4)
+	{
+		const __m128 lo = _mm_cvtpd_ps(_mm_loadu_pd(src + i));
+		const __m128 hi = _mm_cvtpd_ps(_mm_loadu_pd(src + i + 2));
+		_mm_storeu_ps((float *)(dst + i * sizeof(float)), _mm_movelh_ps(lo, hi));
+	}
+#elif defined(RTNO_CODEC_NEON)
+	for (; i + 4 <= count; i += 4)
+	{
+		const float32x2_t lo = vcvt_f32_f64(vld1q_f64(src + i));
+		const float32x2_t hi = vcvt_f32_f64(vld1q_f64(src + i + 2));
+		vst1q_f32((float *)(dst + i * sizeof(float)), vcombine_f32(lo, hi));
+	}
+#endif
+	for (; i < count; i++)
+	{
+		const float value = static_cast<float>(src[i]);
+		memcpy(dst + i * sizeof(float), &value, sizeof(float));
+	}
+}
+
+void ssr::rtno2::codec_widen_float(double *dst, const uint8_t *src, const size_t count)
+{
+	size_t i = 0;
+#if defined(RTNO_CODEC_SSE2)
+	for (; i + 4 <= count; i += 4)
+	{
+		const __m128i value = _mm_loadu_si128((const __m128i *)(src + i * sizeof(float)));
+		_mm_storeu_pd(dst + i, _mm_cvtps_pd(_mm_castsi128_ps(value)));
+		_mm_storeu_pd(dst + i + 2, _mm_cvtps_pd(_mm_castsi128_ps(_mm_srli_si128(value, 8))));
+	}
+#elif defined(RTNO_CODEC_NEON)
+	for (; i + 4 <= count; i += 4)
+	{
+		const float32x4_t value = vld1q_f32((const float *)(src + i * sizeof(float)));
+		vst1q_f64(dst + i, vcvt_f64_f32(vget_low_f32(value)));
+		vst1q_f64(dst + i + 2, vcvt_high_f64_f32(value));
+	}
+#endif
+	for (; i < count; i++)
+	{
+		float value;
+		memcpy(&value, src + i * sizeof(float), sizeof(float));
+		dst[i] = value;
+	}
+}
+
+void ssr::rtno2::codec_octet_to_bool(bool *dst, const uint8_t *src, const size_t count)
+{
+	size_t i = 0;
+#if defined(RTNO_CODEC_SSE2)
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i one = _mm_set1_epi8(1);
+	for (; i + 16 <= count; i += 16)
+	{
+		const __m128i value = _mm_loadu_si128((const __m128i *)(src + i));
+		_mm_storeu_si128((__m128i *)(dst + i), _mm_andnot_si128(_mm_cmpeq_epi8(value, zero), one));
+	}
+#elif defined(RTNO_CODEC_NEON)
+	const uint8x16_t one = vdupq_n_u8(1);
+	for (; i + 16 <= count; i += 16)
+	{
+		vst1q_u8((uint8_t *)(dst + i), vminq_u8(vld1q_u8(src + i), one));
+	}
+#endif
+	for (; i < count; i++)
+	{
+		dst[i] = src[i] != 0;
+	}
+}
+
+void ssr::rtno2::codec_pack_bool(uint8_t *dst, const bool *src, const size_t count)
+{
+	size_t i = 0;
+#if defined(RTNO_CODEC_SSE2)
+	const __m128i zero = _mm_setzero_si128();
+	for (; i + 16 <= count; i += 16)
+	{
+		const __m128i value = _mm_loadu_si128((const __m128i *)(src + i));
+		const int bits = _mm_movemask_epi8(_mm_cmpgt_epi8(value, zero));
+		dst[i / 8] = static_cast<uint8_t>(bits);
+		dst[i / 8 + 1] = static_cast<uint8_t>(bits >> 8);
+	}
+#elif defined(RTNO_CODEC_NEON)
+	static const uint8_t WEIGHTS[16] = {1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+	const uint8x16_t weights = vld1q_u8(WEIGHTS);
+	for (; i + 16 <= count; i += 16)
+	{
+		const uint8x16_t value = vld1q_u8((const uint8_t *)(src + i));
+		const uint8x16_t bits = vandq_u8(vtstq_u8(value, value), weights);
+		dst[i / 8] = vaddv_u8(vget_low_u8(bits));
+		dst[i / 8 + 1] = vaddv_u8(vget_high_u8(bits));
+	}
+#endif
+	for (; i < count; i += 8)
+	{
+		uint8_t byte = 0;
+		for (size_t bit = 0; bit < 8 && i + bit < count; bit++)
+		{
+			byte |= (src[i + bit] ? 1 : 0) << bit;
+		}
+		dst[i / 8] = byte;
+	}
+}
+
+void ssr::rtno2::codec_unpack_bool(bool *dst, const uint8_t *src, const size_t count)
+{
+	size_t i = 0;
+#if defined(RTNO_CODEC_SSE2)
+	const __m128i mask = _mm_set1_epi64x((long long)0x8040201008040201ULL);
+	const __m128i one = _mm_set1_epi8(1);
+	for (; i + 16 <= count; i += 16)
+	{
+		// Broadcast each of the two bytes over eight lanes, then test lane n against bit n % 8.
+		const __m128i bytes = _mm_set_epi64x((long long)(src[i / 8 + 1] * 0x0101010101010101ULL), (long long)(src[i / 8] * 0x0101010101010101ULL));
+		_mm_storeu_si128((__m128i *)(dst + i), _mm_and_si128(_mm_cmpeq_epi8(_mm_and_si128(bytes, mask), mask), one));
+	}
+#elif defined(RTNO_CODEC_NEON)
+	static const uint8_t WEIGHTS[16] = {1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+	const uint8x16_t weights = vld1q_u8(WEIGHTS);
+	const uint8x16_t one = vdupq_n_u8(1);
+	for (; i + 16 <= count; i += 16)
+	{
+		const uint8x16_t bytes = vcombine_u8(vdup_n_u8(src[i / 8]), vdup_n_u8(src[i / 8 + 1]));
+		vst1q_u8((uint8_t *)(dst + i), vandq_u8(vtstq_u8(bytes, weights), one));
+	}
+#endif
+	for (; i < count; i++)
+	{
+		dst[i] = ((src[i / 8] >> (i % 8)) & 1) != 0;
+	}
+}
@@ -0,0 +1,142 @@
+#include "rtno2/cycle.h"
+
+#include <string.h>
+
+using namespace ssr::rtno2;
+
+cycle_t &cycle_t::send_inport_data(const port_id_t port, const uint8_t *data, const uint8_t length)
+{
+	writes_.push_back(write_t{port, values_.size(), length, RESULT::UNINITIALIZED});
+	values_.insert(values_.end(), data, data + length);
+	return *this;
+}
+
+cycle_t &cycle_t::execute()
+{
+	execute_ = true;
+	return *this;
+}
+
+cycle_t &cycle_t::receive_outport_data(const port_id_t port)
+{
+	reads_.push_back(read_t{port, 0, RESULT::UNINITIALIZED});
+	read_values_.resize(reads_.size() * PACKET_MAX_DATA_SIZE);
+	return *this;
+}
+
+cycle_t &cycle_t::receive_all_outports(const profile_t &profile)
+{
+	for (size_t id = 0; id < profile.outports_.size(); id++)
+	{
+		receive_outport_data(port_id_t{static_cast<port_index_t>(id), profile.generation_});
+	}
+	return *this;
+}
+
+void cycle_t::clear()
+{
+	writes_.clear();
+	values_.clear();
+	execute_ = false;
+	execute_result_ = RESULT::UNINITIALIZED;
+	reads_.clear();
+}
+
+RESULT cycle_t::result() const
+{
+	for (auto &write : writes_)
+	{
+		if (write.result != RESULT::OK)
+		{
+			return write.result;
+		}
+	}
+	if (execute_ && execute_result_ != RESULT::OK)
+	{
+		return execute_result_;
+	}
+	for (auto &read : reads_)
+	{
+		if (read.result != RESULT::OK)
+		{
+			return read.result;
+		}
+	}
+	return RESULT::OK;
+}
+
+bool cycle_t::encode(packet_t &packet) const
+{
+	if (writes_.size() > 255 || reads_.size() > 255)
+	{
+		return false;
+	}
+	size_t size = 3 + reads_.size();
+	for (auto &write : writes_)
+	{
+		size += 2 + write.length;
+	}
+	if (size > PACKET_MAX_DATA_SIZE)
+	{
+		return false;
+	}
+
+	packet = packet_t(COMMAND::BATCH_CYCLE, RESULT::OK);
+	uint8_t *dst = packet.getWritableData();
+	*dst++ = execute_ ? BATCH_EXECUTE : 0;
+	*dst++ = static_cast<uint8_t>(writes_.size());
+	for (auto &write : writes_)
+	{
+		if (write.port.index > 255)
+		{
+			return false;
+		}
+		*dst++ = static_cast<uint8_t>(write.port.index);
+		*dst++ = write.length;
+		memcpy(dst, values_.data() + write.offset, write.length);
+		dst += write.length;
+	}
+	*dst++ = static_cast<uint8_t>(reads_.size());
+	for (auto &read : reads_)
+	{
+		if (read.port.index > 255)
+		{
+			return false;
+		}
+		*dst++ = static_cast<uint8_t>(read.port.index);
+	}
+	packet.setDataLength(static_cast<uint8_t>(size));
+	return true;
+}
+
+RESULT cycle_t::decode(const packet_t &reply)
+{
+	const uint8_t *src = reply.getData();
+	const uint8_t *end = src + reply.getDataLength();
+	if (reply.get_command() != COMMAND::BATCH_CYCLE || end - src < 1 || src[0] != writes_.size() || end - src < 3 + (ptrdiff_t)writes_.size())
+	{
+		return RESULT::ERR;
+	}
+	src++;
+	for (auto &write : writes_)
+	{
+		write.result = (RESULT)*src++;
+	}
+	execute_result_ = (RESULT)*src++;
+	if (*src++ != reads_.size())
+	{
+		return RESULT::ERR;
+	}
+	for (size_t i = 0; i < reads_.size(); i++)
+	{
+		if (end - src < 3 || src[0] != reads_[i].port.index || end - src < 3 + src[2])
+		{
+			return RESULT::ERR;
+		}
+		reads_[i].result = (RESULT)src[1];
+		reads_[i].size = src[2];
+		memcpy(read_buffer(i), src + 3, src[2]);
+		src += 3 + src[2];
+	}
+	return RESULT::OK;
+}
@@ -0,0 +1,171 @@
+#include "rtno2/frame_decoder.h"
+
+#include <string.h>
+#include <array>
+
+using namespace ssr::rtno2;
+
+// CRC16_TABLES[k][b]: CRC of byte b followed by k zero bytes (slice-by-4).
+static constexpr std::array<std::array<uint16_t, 256>, 4> make_crc16_tables()
+{
+	std::array<std::array<uint16_t, 256>, 4> tables = {};
+	for (int i = 0; i < 256; i++)
+	{
+		uint16_t crc = static_cast<uint16_t>(i << 8);
+		for (int bit = 0; bit < 8; bit++)
+		{
+			crc = (crc & 0x8000) ? static_cast<uint16_t>((crc << 1) ^ 0x1021) : static_cast<uint16_t>(crc << 1);
+		}
+		tables[0][i] = crc;
+	}
+	for (int k = 1; k < 4; k++)
+	{
+		for (int i = 0; i < 256; i++)
+		{
+			const uint16_t prev = tables[k - 1][i];
+			tables[k][i] = static_cast<uint16_t>((prev << 8) ^ tables[0][prev >> 8]);
+		}
+	}
+	return tables;
+}
+
+static constexpr auto CRC16_TABLES = make_crc16_tables();
+
+uint16_t ssr::rtno2::crc16_ccitt(const uint8_t *data, const size_t size, uint16_t crc)
+{
+	size_t i = 0;
+	for (; i + 4 <= size; i += 4)
+	{
+		crc = CRC16_TABLES[3][(crc >> 8) ^ data[i]] ^ CRC16_TABLES[2][(crc & 0xFF) ^ data[i + 1]] ^
+			  CRC16_TABLES[1][data[i + 2]] ^ CRC16_TABLES[0][data[i + 3]];
+	}
+	for (; i < size; i++)
+	{
+		crc = static_cast<uint16_t>((crc << 8) ^ CRC16_TABLES[0][(crc >> 8) ^ data[i]]);
+	}
+	return crc;
+}
+
+size_t ssr::rtno2::encode_frame(uint8_t *dst, const packet_t &packet, const uint8_t sum, const FRAMING framing, const uint8_t frame_id)
+{
+	const uint8_t length = packet.getDataLength();
+	dst[0] = PACKET_START_BYTE;
+	if (framing == FRAMING::V1)
+	{
+		dst[1] = PACKET_START_BYTE;
+		memcpy(dst + 2, packet.serialize(), packet.getPacketLength());
+		dst[2 + packet.getPacketLength()] = sum;
+		return 2 + packet.getPacketLength() + 1;
+	}
+	dst[1] = FRAME_V2_MARK;
+	dst[2] = frame_id;
+	dst[3] = (uint8_t)packet.get_command();
+	dst[4] = (uint8_t)packet.get_result();
+	dst[5] = length;
+	dst[6] = 0;
+	memcpy(dst + 2 + FRAME_V2_HEADER_SIZE, packet.getData(), length);
+	const uint16_t crc = crc16_ccitt(dst + 2, FRAME_V2_HEADER_SIZE + length);
+	dst[2 + FRAME_V2_HEADER_SIZE + length] = static_cast<uint8_t>(crc);
+	dst[3 + FRAME_V2_HEADER_SIZE + length] = static_cast<uint8_t>(crc >> 8);
+	return 2 + FRAME_V2_HEADER_SIZE + length + FRAME_V2_CRC_SIZE;
+}
+
+uint8_t *frame_decoder_t::prepare(size_t &writable)
+{
+	if (begin_ == end_)
+	{
+		begin_ = end_ = 0;
+	}
+	else if (begin_ > 0 && BUFFER_SIZE - end_ < BUFFER_SIZE / 4)
+	{
+		memmove(buffer_, buffer_ + begin_, end_ - begin_);
+		end_ -= begin_;
+		begin_ = 0;
+	}
+	writable = BUFFER_SIZE - end_;
+	return buffer_ + end_;
+}
+
+result_t<packet_t> frame_decoder_t::decode()
+{
+	while (true)
+	{
+		// Find 0x0a 0x0a (V1) or 0x0a 0xa5 (V2). A lone 0x0a at the tail is kept until the next byte arrives.
+		state_ = STATE::SYNC;
+		auto start = (const uint8_t *)memchr(buffer_ + begin_, PACKET_START_BYTE, end_ - begin_);
+		if (start == NULL)
+		{
+			begin_ = end_;
+			return RESULT::NOT_AVAILABLE;
+		}
+		begin_ = start - buffer_;
+		if (end_ - begin_ < 2)
+		{
+			return RESULT::NOT_AVAILABLE;
+		}
+		if (buffer_[begin_ + 1] != FRAME_V2_MARK && (buffer_[begin_ + 1] != PACKET_START_BYTE || negotiated_ == FRAMING::V2))
+		{
+			begin_++;
+			continue;
+		}
+		const bool v2 = buffer_[begin_ + 1] == FRAME_V2_MARK;
+
+		const size_t header = begin_ + 2;
+		const size_t header_size = v2 ? FRAME_V2_HEADER_SIZE : PACKET_RECEIVE_HEADER_SIZE;
+		const size_t check_size = v2 ? FRAME_V2_CRC_SIZE : 1;
+		if (end_ - header < header_size)
+		{
+			state_ = STATE::HEADER;
+			return RESULT::NOT_AVAILABLE;
+		}
+		const size_t length = v2 ? (buffer_[header + 3] | (buffer_[header + 4] << 8)) : buffer_[header + 2];
+		if (length > PACKET_MAX_DATA_SIZE)
+		{
+			// Corrupted length (or a frame this side cannot hold). Resynchronize after the start bytes.
+			framing_ = v2 ? FRAMING::V2 : FRAMING::V1;
+			begin_ = header;
+			return RESULT::CHECKSUM_ERROR;
+		}
+		if (end_ - header < header_size + length)
+		{
+			state_ = STATE::BODY;
+			return RESULT::NOT_AVAILABLE;
+		}
+		if (end_ - header < header_size + length + check_size)
+		{
+			state_ = STATE::CHECKSUM;
+			return RESULT::NOT_AVAILABLE;
+		}
+
+		const uint8_t *frame = buffer_ + header;
+		begin_ = header + header_size + length + check_size;
+		state_ = STATE::SYNC;
+		if (v2)
+		{
+			framing_ = FRAMING::V2;
+			frame_id_ = frame[0];
+			const uint16_t crc = crc16_ccitt(frame, header_size + length);
+			if (frame[header_size + length] != static_cast<uint8_t>(crc) || frame[header_size + length + 1] != static_cast<uint8_t>(crc >> 8))
+			{
+				if (negotiated_ == FRAMING::V2)
+				{
+					begin_ = header; // the next frame may start inside what a broken length claimed
+				}
+				return RESULT::CHECKSUM_ERROR;
+			}
+			return packet_t((COMMAND)frame[1], (RESULT)frame[2], frame + header_size, static_cast<uint8_t>(length));
+		}
+
+		framing_ = FRAMING::V1;
+		uint8_t sum = 0;
+		for (size_t i = 0; i < header_size + length; i++)
+		{
+			sum += frame[i];
+		}
+		if (sum != frame[header_size + length])
+		{
+			return RESULT::CHECKSUM_ERROR;
+		}
+		return packet_t((COMMAND)frame[0], (RESULT)frame[1], frame + header_size, static_cast<uint8_t>(length));
+	}
+}
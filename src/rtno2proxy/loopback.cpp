@@ -0,0 +1,234 @@
+#include "rtno2/loopback.h"
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+
+using namespace ssr::rtno2;
+
+static int64_t now_nsec()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static const uint64_t NEVER = std::numeric_limits<uint64_t>::max();
+
+loopback_t::channel_t::channel_t(const link_config_t &config)
+	: config_(config), rng_(config.seed), jitter_rng_(config.seed ^ 0x9e3779b9u),
+	  byte_nsec_(config.baudrate > 0 ? (int64_t)config.bits_per_byte * 1000000000 / config.baudrate : 0),
+	  line_free_nsec_(0), last_arrival_nsec_(0), burst_left_(0)
+{
+	bytes_to_drop_ = next_distance(config_.drop_rate);
+	bytes_to_burst_ = next_distance(config_.burst_rate);
+	bits_to_flip_ = next_distance(config_.bit_error_rate);
+}
+
+uint64_t loopback_t::channel_t::next_distance(const double rate)
+{
+	if (rate <= 0)
+	{
+		return NEVER;
+	}
+	if (rate >= 1)
+	{
+		return 0;
+	}
+	// Number of events passing before the next hit, instead of one draw per byte or bit.
+	return std::geometric_distribution<uint64_t>(rate)(rng_);
+}
+
+void loopback_t::channel_t::write(const uint8_t *src, const size_t size)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	const int64_t now = now_nsec();
+	const int64_t jitter = config_.jitter_usec > 0 ? (int64_t)std::uniform_int_distribution<uint32_t>(0, config_.jitter_usec)(jitter_rng_) * 1000 : 0;
+	int64_t line = std::max(now, line_free_nsec_);
+	for (size_t i = 0; i < size; i++)
+	{
+		// A lost byte still takes its time on the line.
+		line += byte_nsec_;
+		statistics_.bytes++;
+
+		bool lost = false;
+		if (burst_left_ > 0)
+		{
+			burst_left_--;
+			lost = true;
+		}
+		else if (bytes_to_burst_ != NEVER && bytes_to_burst_-- == 0)
+		{
+			bytes_to_burst_ = next_distance(config_.burst_rate);
+			burst_left_ = config_.burst_length > 0 ? config_.burst_length - 1 : 0;
+			lost = true;
+		}
+		if (bytes_to_drop_ != NEVER && bytes_to_drop_-- == 0)
+		{
+			bytes_to_drop_ = next_distance(config_.drop_rate);
+			lost = true;
+		}
+		if (lost)
+		{
+			statistics_.dropped++;
+			continue;
+		}
+
+		uint8_t value = src[i];
+		while (bits_to_flip_ < 8)
+		{
+			value ^= (uint8_t)(1 << bits_to_flip_);
+			statistics_.flipped++;
+			const uint64_t distance = next_distance(config_.bit_error_rate);
+			bits_to_flip_ = distance == NEVER ? NEVER : bits_to_flip_ + 1 + distance;
+		}
+		if (bits_to_flip_ != NEVER)
+		{
+			bits_to_flip_ -= 8;
+		}
+
+		// UART does not reorder bytes, so jitter only ever delays.
+		last_arrival_nsec_ = std::max(line + (int64_t)config_.latency_usec * 1000 + jitter, last_arrival_nsec_);
+		queue_.emplace_back(last_arrival_nsec_, value);
+	}
+	line_free_nsec_ = line;
+	cond_.notify_all();
+}
+
+size_t loopback_t::channel_t::arrived(const int64_t now) const
+{
+	size_t n = 0;
+	while (n < queue_.size() && queue_[n].first <= now)
+	{
+		n++;
+	}
+	return n;
+}
+
+size_t loopback_t::channel_t::available()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return queue_.empty() ? 0 : arrived(now_nsec());
+}
+
+size_t loopback_t::channel_t::read(uint8_t *dst, const size_t size)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	if (queue_.empty())
+	{
+		return 0;
+	}
+	const int64_t now = now_nsec();
+	size_t n = 0;
+	while (n < size && !queue_.empty() && queue_.front().first <= now)
+	{
+		dst[n++] = queue_.front().second;
+		queue_.pop_front();
+	}
+	return n;
+}
+
+bool loopback_t::channel_t::wait(const uint32_t timeout_usec)
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	const int64_t deadline = now_nsec() + (int64_t)timeout_usec * 1000;
+	while (true)
+	{
+		const int64_t now = now_nsec();
+		if (!queue_.empty() && queue_.front().first <= now)
+		{
+			return true;
+		}
+		if (now >= deadline)
+		{
+			return false;
+		}
+		// Wake up when the next byte arrives, or when write() queues one.
+		const int64_t wake = queue_.empty() ? deadline : std::min(deadline, queue_.front().first);
+		cond_.wait_for(lock, std::chrono::nanoseconds(std::max<int64_t>(wake - now, 0)));
+	}
+}
+
+void loopback_t::channel_t::flush()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	queue_.erase(queue_.begin(), queue_.begin() + arrived(now_nsec()));
+}
+
+loopback_t::statistics_t loopback_t::channel_t::statistics()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return statistics_;
+}
+
+void loopback_t::endpoint_t::flushRxBuffer()
+{
+	rx_.flush();
+}
+
+ssr::RETVAL loopback_t::endpoint_t::getSizeInRxBuffer()
+{
+	return static_cast<ssr::RETVAL>(rx_.available());
+}
+
+ssr::RETVAL loopback_t::endpoint_t::write(const uint8_t *src, const uint8_t size)
+{
+	tx_.write(src, size);
+	return size;
+}
+
+ssr::RETVAL loopback_t::endpoint_t::read(uint8_t *dst, const uint8_t size)
+{
+	return static_cast<ssr::RETVAL>(rx_.read(dst, size));
+}
+
+ssr::RETVAL loopback_t::endpoint_t::waitRxReady(const uint32_t timeout_usec)
+{
+	return rx_.wait(timeout_usec) ? 1 : 0;
+}
+
+static link_config_t reverse_of(const link_config_t &config)
+{
+	link_config_t reverse = config;
+	reverse.seed = config.seed + 1;
+	return reverse;
+}
+
+loopback_t::loopback_t(const link_config_t &config) : loopback_t(config, reverse_of(config))
+{
+}
+
+loopback_t::loopback_t(const link_config_t &a_to_b, const link_config_t &b_to_a)
+	: a_to_b_(a_to_b), b_to_a_(b_to_a), a_(b_to_a_, a_to_b_), b_(a_to_b_, b_to_a_)
+{
+}
+
+bridge_t::bridge_t(ssr::SerialDevice &a, ssr::SerialDevice &b) : running_(true)
+{
+	forward_ = std::thread([this, &a, &b]()
+						   { copy(a, b); });
+	backward_ = std::thread([this, &a, &b]()
+							{ copy(b, a); });
+}
+
+bridge_t::~bridge_t()
+{
+	running_ = false;
+	forward_.join();
+	backward_.join();
+}
+
+void bridge_t::copy(ssr::SerialDevice &from, ssr::SerialDevice &to)
+{
+	uint8_t buffer[255];
+	while (running_)
+	{
+		if (from.waitRxReady(10 * 1000) <= 0)
+		{
+			continue;
+		}
+		ssr::RETVAL n;
+		while ((n = from.read(buffer, sizeof(buffer))) > 0)
+		{
+			to.write(buffer, static_cast<uint8_t>(n));
+		}
+	}
+}
@@ -0,0 +1,34 @@
+#include "rtno2/pipeline.h"
+#include "rtno2/request.h"
+
+using namespace ssr::rtno2;
+
+pipeline_t &pipeline_t::send_inport_data(const std::string &portName, const uint8_t *data, const uint8_t length)
+{
+	add(make_send_data_packet(portName, data, length), COMMAND::SEND_DATA, portName, NULL, 0, NULL);
+	return *this;
+}
+
+pipeline_t &pipeline_t::execute()
+{
+	requests_.push_back(request_t{packet_t(COMMAND::EXECUTE, RESULT::OK), COMMAND::EXECUTE, "", NULL, 0, NULL, RESULT::UNINITIALIZED});
+	return *this;
+}
+
+pipeline_t &pipeline_t::receive_outport_data(const std::string &portName, uint8_t *data, const uint8_t max_size, uint8_t *size_read)
+{
+	add(make_receive_data_packet(portName), COMMAND::RECEIVE_DATA, portName, data, max_size, size_read);
+	return *this;
+}
+
+void pipeline_t::add(result_t<packet_t> &&packet, const COMMAND reply_command, const std::string &portName, uint8_t *data, const uint8_t max_size, uint8_t *size_read)
+{
+	if (!packet)
+	{
+		// Keeps its index, so the results of the other requests stay where the caller expects them.
+		requests_.push_back(request_t{packet_t(reply_command, RESULT::OK), reply_command, portName, NULL, 0, NULL, packet.error()});
+		error_ = packet.error();
+		return;
+	}
+	requests_.push_back(request_t{*std::move(packet), reply_command, portName, data, max_size, size_read, RESULT::UNINITIALIZED});
+}
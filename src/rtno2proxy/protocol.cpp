@@ -5,13 +5,14 @@
 #include <chrono>
 #include <thread>
 #include <iostream>
+#include <algorithm>
 
 #include "rtno2/logger.h"
 #include "protocol.h"
 
 using namespace ssr::rtno2;
 
-protocol_t::protocol_t(SerialDevice *serial_device, ssr::rtno2::LOGLEVEL loglevel, ssr::rtno2::LOGLEVEL transport_loglevel) : transport_(serial_device, transport_loglevel), logger_(get_logger("protocol")), architecture_(Architecture::UNKNOWN)
+protocol_t::protocol_t(SerialDevice *serial_device, ssr::rtno2::LOGLEVEL loglevel, ssr::rtno2::LOGLEVEL transport_loglevel) : transport_(serial_device, transport_loglevel), logger_(get_logger("protocol")), architecture_(Architecture::UNKNOWN), capabilities_(0), offered_capabilities_(0), profile_valid_(false), profile_generation_(0)
 {
 
 	set_log_level(&logger_, loglevel);
@@ -38,176 +39,310 @@ std::string to_byte_string(const uint8_t *data, const uint8_t size)
 	return ss.str();
 }
 
-result_t<packet_t> protocol_t::wait_and_receive_command(const COMMAND command, const uint32_t wait_usec, const uint32_t retry_counts)
+static bool is_timeout(const RESULT result)
 {
-	RTNO_TRACE(logger_, "protocol_t::wait_and_receive_command(command={}, wait_usec={}) called", command_to_string(command), wait_usec);
-	RESULT result;
-	for (uint32_t attempt = 0; attempt < retry_counts; attempt++)
+	return result == RESULT::TIMEOUT || result == RESULT::PACKET_START_TIMEOUT || result == RESULT::PACKET_HEADER_TIMEOUT || result == RESULT::PACKET_BODY_TIMEOUT || result == RESULT::PACKET_CHECKSUM_TIMEOUT;
+}
+
+result_t<packet_t> protocol_t::wait_and_receive_command(const COMMAND command, const deadline_t deadline, const int frame_id)
+{
+	RTNO_TRACE(logger_, "protocol_t::wait_and_receive_command(command={}, remaining_usec={}) called", command_to_string(command), remaining_usec(deadline));
+	auto receive_result = transport_.receive(command, deadline, frame_id);
+	if (!receive_result)
 	{
-		if ((result = transport_.is_new(wait_usec)) == RESULT::OK)
+		if (!is_timeout(receive_result.error()))
 		{
-			auto receive_result = transport_.receive(wait_usec);
-			if (receive_result.result != RESULT::OK)
-			{
-				RTNO_ERROR(logger_, "In wait_an_receive_command, transport.receive({}) failed. Result is {}", wait_usec, result_to_string(receive_result.result));
-				return receive_result.result;
-			}
-			try
-			{
-				packet_t pac = receive_result.value.value();
-				RTNO_DEBUG(logger_, "In wait_and_receive_command, received packet ({})", pac.to_string());
-
-				if (pac.get_command() == COMMAND::HEART_BEAT)
-				{
-					RTNO_DEBUG(logger_, "In wait_and_receive_command, received HEART_BEAT packet. Ignoring and continue waiting.");
-					attempt--;
-					continue;
-				}
-
-				if (pac.get_command() == command)
-				{
-					RTNO_TRACE(logger_, "In wait_and_receive_command({}) exit with success", command_to_string(command));
-					return pac;
-				}
-
-				if (pac.get_command() == COMMAND::PACKET_ERROR)
-				{
-					RTNO_ERROR(logger_, "In wait_and_receive_command() detect PACKET_ERROR. Replied messasge includes RESULT({})", result_to_string(pac.get_result()));
-					return pac.get_result();
-				}
-				else
-				{
-					RTNO_DEBUG(logger_, "In wait_and_receive_command({}) now waiting command ({}={}) but received invalid unknown command({}={}={}). retry (attempt={})", retry_counts, command_to_string(command), (int)command, command_to_string(pac.get_command()), ((char)pac.get_command()), ((int)pac.get_command()), attempt);
-					continue;
-				}
-			}
-			catch (const std::exception &e)
-			{
-				RTNO_ERROR(logger_, "In wait_and_receive_command(), exception occurred when processing received packet: {}", e.what());
-				return RESULT::ERR;
-			}
+			RTNO_ERROR(logger_, "In wait_and_receive_command, transport.receive() failed. Result is {}", result_to_string(receive_result.error()));
 		}
+		return receive_result.error();
+	}
+	const packet_t &pac = *receive_result;
+	RTNO_DEBUG(logger_, "In wait_and_receive_command, received packet ({})", pac.to_string());
+	if (pac.get_command() == COMMAND::PACKET_ERROR)
+	{
+		RTNO_ERROR(logger_, "In wait_and_receive_command() detect PACKET_ERROR. Replied messasge includes RESULT({})", result_to_string(pac.get_result()));
+		return pac.get_result();
 	}
-	RTNO_TRACE(logger_, "wait_and_receive_command() exit");
-	return RESULT::TIMEOUT;
+	RTNO_TRACE(logger_, "In wait_and_receive_command({}) exit with success", command_to_string(command));
+	return receive_result;
 }
 
-result_t<STATE> protocol_t::get_state(uint32_t wait_usec, const int retry_count)
+bool protocol_t::wait_backoff(const int attempt, const deadline_t deadline, const retry_policy_t &policy)
 {
-	RTNO_TRACE(logger_, "RTnoProtocol::getRTnoState() called.");
-	static const packet_t cmd_packet(COMMAND::GET_STATE, RESULT::OK);
-	for (int i = 0; i < retry_count; i++)
+	const uint32_t backoff = policy.backoff_before(attempt);
+	if (backoff > 0)
 	{
+		const uint32_t rest = remaining_usec(deadline);
+		std::this_thread::sleep_for(std::chrono::microseconds(backoff < rest ? backoff : rest));
+	}
+	return !is_expired(deadline);
+}
 
-		transport_.send(cmd_packet);
+result_t<packet_t> protocol_t::transact(const packet_t &request, const COMMAND reply_command, const deadline_t deadline, const retry_policy_t &policy)
+{
+	return transact(request, request.getSum(), reply_command, deadline, policy);
+}
 
-		auto result = wait_and_receive_command(COMMAND::GET_STATE, wait_usec, retry_count);
-		if (result.result == RESULT::OK)
-		{
+result_t<packet_t> protocol_t::transact(const packet_t &request, const uint8_t sum, const COMMAND reply_command, const deadline_t deadline, const retry_policy_t &policy)
+{
+	RTNO_TRACE(logger_, "transact({}, {}) called", request.to_string(), policy.to_string());
+	if (request.get_command() == COMMAND::RESET || request.get_command() == COMMAND::INITIALIZE)
+	{
+		invalidate_profile();
+	}
+	return transact_with([&]()
+						 { return transport_.send(request, sum); },
+						 reply_command, deadline, policy);
+}
 
-			RTNO_TRACE(logger_, "RTnoProtocol::getRTnoState() exit");
-			return (STATE)result.value.value().getData()[0];
+template <typename SEND>
+result_t<packet_t> protocol_t::transact_with(const SEND &send, const COMMAND reply_command, const deadline_t deadline, const retry_policy_t &policy)
+{
+	RESULT last_result = RESULT::TIMEOUT;
+	// A late reply to an earlier call must not be taken as the reply to this one.
+	transport_.discard(reply_command);
+	for (int attempt = 0; attempt < policy.max_attempts; attempt++)
+	{
+		if (!wait_backoff(attempt, deadline, policy))
+		{
+			break;
+		}
+		const RESULT send_result = send();
+		if (send_result != RESULT::OK)
+		{
+			last_result = send_result;
+			RTNO_WARN(logger_, "In transact({}), send failed ({}). retry (attempt={})", command_to_string(reply_command), result_to_string(send_result), attempt);
+			continue;
 		}
-		else if (result.result == RESULT::PACKET_START_TIMEOUT || result.result == RESULT::PACKET_HEADER_TIMEOUT || result.result == RESULT::PACKET_BODY_TIMEOUT || result.result == RESULT::PACKET_CHECKSUM_TIMEOUT)
+		const auto attempt_deadline = std::min(deadline, deadline_after(policy.attempt_timeout_usec));
+		auto result = wait_and_receive_command(reply_command, attempt_deadline, transport_.last_frame_id());
+		if (result)
 		{
-			RTNO_DEBUG(logger_, "In getRTnoState(), timeout. retry");
+			return result;
 		}
+		last_result = result.error();
+		if (result.error() == RESULT::CHECKSUM_ERROR)
+		{
+			RTNO_WARN(logger_, "In transact({}), receive checksum error. retry (attempt={})", command_to_string(reply_command), attempt);
+			transport_.clear_rx_buffer();
+		}
+		else if (is_timeout(result.error()))
+		{
+			RTNO_DEBUG(logger_, "In transact({}), timeout. retry (attempt={})", command_to_string(reply_command), attempt);
+			transport_.clear_rx_buffer();
+		}
+		else
+		{
+			RTNO_WARN(logger_, "In transact({}), error {}. retry (attempt={})", command_to_string(reply_command), result_to_string(result.error()), attempt);
+		}
+	}
+	if (is_expired(deadline))
+	{
+		RTNO_WARN(logger_, "transact({}) exit with TIMEOUT (deadline expired, last result={})", command_to_string(reply_command), result_to_string(last_result));
+		return RESULT::TIMEOUT;
+	}
+	RTNO_WARN(logger_, "transact({}) exit with ERR (attempts exhausted, last result={})", command_to_string(reply_command), result_to_string(last_result));
+	return RESULT::ERR;
+}
+
+result_t<packet_t> protocol_t::transact_once(const packet_t &request, const COMMAND reply_command, const deadline_t deadline, const retry_policy_t &policy)
+{
+	RTNO_TRACE(logger_, "transact_once({}) called", request.to_string());
+	transport_.discard(reply_command);
+	const RESULT send_result = transport_.send(request);
+	if (send_result != RESULT::OK)
+	{
+		RTNO_WARN(logger_, "transact_once({}) exit with error (send failed {})", command_to_string(reply_command), result_to_string(send_result));
+		return send_result;
 	}
+	auto result = wait_and_receive_command(reply_command, std::min(deadline, deadline_after(policy.attempt_timeout_usec)), transport_.last_frame_id());
+	if (!result)
+	{
+		RTNO_WARN(logger_, "transact_once({}) exit with {}. The request may have run.", command_to_string(reply_command), result_to_string(result.error()));
+		if (result.error() == RESULT::CHECKSUM_ERROR || is_timeout(result.error()))
+		{
+			transport_.clear_rx_buffer();
+			return result.error() == RESULT::CHECKSUM_ERROR ? RESULT::CHECKSUM_ERROR : RESULT::TIMEOUT;
+		}
+	}
+	return result;
+}
 
+result_t<STATE> protocol_t::get_state(const deadline_t deadline, const retry_policy_t &policy)
+{
+	RTNO_TRACE(logger_, "RTnoProtocol::getRTnoState() called.");
+	static const packet_t cmd_packet(COMMAND::GET_STATE, RESULT::OK);
+	auto result = transact(cmd_packet, COMMAND::GET_STATE, deadline, policy);
+	if (!result)
+	{
+		return result.error();
+	}
 	RTNO_TRACE(logger_, "RTnoProtocol::getRTnoState() exit");
-	return RESULT::ERR;
+	return (STATE)result->getData()[0];
 }
 
-result_t<EC_TYPE> protocol_t::get_ec_type(uint32_t wait_usec, const int retry_count)
+result_t<EC_TYPE> protocol_t::get_ec_type(const deadline_t deadline, const retry_policy_t &policy)
 {
 	RTNO_TRACE(logger_, "RTnoProtocol::getRTnoExecutionContextType() called.");
 	static const packet_t cmd_packet(COMMAND::GET_CONTEXT_TYPE, RESULT::OK);
-	for (int i = 0; i < retry_count; i++)
+	auto result = transact(cmd_packet, COMMAND::GET_CONTEXT_TYPE, deadline, policy);
+	if (!result)
 	{
-
-		transport_.send(cmd_packet);
-		auto result = wait_and_receive_command(COMMAND::GET_CONTEXT_TYPE, wait_usec, retry_count);
-		if (result.result == RESULT::OK)
-		{
-			RTNO_TRACE(logger_, "RTnoProtocol::getRTnoExecutionContextType() exit");
-			return (EC_TYPE)result.value.value().getData()[0];
-		}
-		else if (result.result == RESULT::PACKET_START_TIMEOUT || result.result == RESULT::PACKET_HEADER_TIMEOUT || result.result == RESULT::PACKET_BODY_TIMEOUT || result.result == RESULT::PACKET_CHECKSUM_TIMEOUT)
-		{
-			RTNO_DEBUG(logger_, "In getRTnoState(), timeout. retry");
-		}
+		return result.error();
 	}
 	RTNO_TRACE(logger_, "RTnoProtocol::getRTnoExecutionContextType() exit");
-	return RESULT::ERR;
+	return (EC_TYPE)result->getData()[0];
+}
+
+void protocol_t::reconnect(SerialDevice *serial_device)
+{
+	RTNO_DEBUG(logger_, "reconnect() called.");
+	transport_.set_serial_device(serial_device);
+	invalidate_profile();
+	architecture_ = Architecture::UNKNOWN;
+	capabilities_ = 0;
+	transport_.set_framing(FRAMING::V1);
 }
 
-result_t<profile_t> protocol_t::get_profile(const uint32_t wait_usec, const int retry_count)
+void protocol_t::invalidate_profile_on(const RESULT result)
 {
-	RTNO_TRACE(logger_, "get_profile({}, {}) called.", wait_usec, retry_count);
-	static const packet_t cmd_packet(COMMAND::GET_PROFILE, (RESULT::OK));
-	for (int i = 0; i < retry_count; i++)
+	if (result == RESULT::INPORT_NOT_FOUND || result == RESULT::OUTPORT_NOT_FOUND)
 	{
-		transport_.clear_rx_buffer();
-		transport_.send(cmd_packet);
-		profile_t profile;
+		RTNO_DEBUG(logger_, "{} received. Profile cache is invalidated.", result_to_string(result));
+		invalidate_profile();
+	}
+}
 
-		int timeout_count = wait_usec / 1000;
-		auto result = wait_and_receive_command(COMMAND::PLATFORM_PROFILE, wait_usec, retry_count);
-		if (result.result == RESULT::OK)
-		{
-			RTNO_TRACE(logger_, "Platform profile received.");
-			auto pac = result.value.value();
-			auto platform_profile = parse_platform_profile(pac);
-			RTNO_DEBUG(logger_, "COMMAND::PLATFORM_PROFILE received ({}).", platform_profile.to_string());
-			profile.append_platform_profile(platform_profile);
-		}
-		else if (result.result == RESULT::CHECKSUM_ERROR)
+RESULT protocol_t::refresh_profile(const deadline_t deadline, const retry_policy_t &policy)
+{
+	RTNO_TRACE(logger_, "refresh_profile({}) called.", policy.to_string());
+	auto result = fetch_profile(deadline, policy);
+	if (!result)
+	{
+		invalidate_profile();
+		return result.error();
+	}
+	profile_ = *std::move(result);
+	profile_.generation_ = ++profile_generation_;
+	profile_valid_ = true;
+	return RESULT::OK;
+}
+
+result_t<profile_t> protocol_t::get_profile(const deadline_t deadline, const retry_policy_t &policy)
+{
+	RESULT result;
+	if (!profile_valid_ && (result = refresh_profile(deadline, policy)) != RESULT::OK)
+	{
+		return result;
+	}
+	return profile_t(profile_);
+}
+
+result_t<port_profile_t> protocol_t::inport_profile(const std::string &portName, const deadline_t deadline, const retry_policy_t &policy)
+{
+	RESULT result;
+	if (!profile_valid_ && (result = refresh_profile(deadline, policy)) != RESULT::OK)
+	{
+		return result;
+	}
+	return profile_.inport(portName);
+}
+
+result_t<port_profile_t> protocol_t::outport_profile(const std::string &portName, const deadline_t deadline, const retry_policy_t &policy)
+{
+	RESULT result;
+	if (!profile_valid_ && (result = refresh_profile(deadline, policy)) != RESULT::OK)
+	{
+		return result;
+	}
+	return profile_.outport(portName);
+}
+
+result_t<port_id_t> protocol_t::inport_id(const std::string &portName, const deadline_t deadline, const retry_policy_t &policy)
+{
+	RESULT result;
+	if (!profile_valid_ && (result = refresh_profile(deadline, policy)) != RESULT::OK)
+	{
+		return result;
+	}
+	port_id_t id = profile_.inport_id(portName);
+	if (!id.valid())
+	{
+		return RESULT::INPORT_NOT_FOUND;
+	}
+	return id;
+}
+
+result_t<port_id_t> protocol_t::outport_id(const std::string &portName, const deadline_t deadline, const retry_policy_t &policy)
+{
+	RESULT result;
+	if (!profile_valid_ && (result = refresh_profile(deadline, policy)) != RESULT::OK)
+	{
+		return result;
+	}
+	port_id_t id = profile_.outport_id(portName);
+	if (!id.valid())
+	{
+		return RESULT::OUTPORT_NOT_FOUND;
+	}
+	return id;
+}
+
+result_t<profile_t> protocol_t::fetch_profile(const deadline_t deadline, const retry_policy_t &policy)
+{
+	RTNO_TRACE(logger_, "fetch_profile({}) called.", policy.to_string());
+	// Extensions are offered in the request data only when there are any, so the request is unchanged otherwise.
+	const packet_t cmd_packet(COMMAND::GET_PROFILE, RESULT::OK, &offered_capabilities_, offered_capabilities_ != 0 ? 1 : 0);
+	capabilities_ = 0;
+	// RTno decodes both formats, so V1 reaches firmware in either state.
+	transport_.set_framing(FRAMING::V1);
+	// A failed send of the last attempt is reported as is, and anything else as TIMEOUT.
+	RESULT last_result = RESULT::TIMEOUT;
+	for (int attempt = 0; attempt < policy.max_attempts; attempt++)
+	{
+		if (!wait_backoff(attempt, deadline, policy))
 		{
-			RTNO_WARN(logger_, "In get_profile, receive checksum error. retry");
-			this->transport_.clear_rx_buffer();
-			continue;
+			break;
 		}
-		else if (result.result == RESULT::PACKET_START_TIMEOUT || result.result == RESULT::PACKET_HEADER_TIMEOUT || result.result == RESULT::PACKET_BODY_TIMEOUT || result.result == RESULT::PACKET_CHECKSUM_TIMEOUT)
+		transport_.clear_rx_buffer();
+		last_result = transport_.send(cmd_packet);
+		if (last_result != RESULT::OK)
 		{
-			RTNO_DEBUG(logger_, "In get_profile(), timeout. retry");
+			RTNO_WARN(logger_, "In fetch_profile(), send failed ({}). retry (attempt={})", result_to_string(last_result), attempt);
 			continue;
 		}
+		last_result = RESULT::TIMEOUT;
+		profile_t profile;
 
-		while (1)
+		// Profile arrives as a sequence of packets terminated by GET_PROFILE.
+		// attempt_timeout_usec bounds the silence between two packets, and deadline bounds the whole exchange.
+		bool retry = false;
+		while (!retry)
 		{
-			auto result = transport_.is_new(wait_usec);
-			if (result != RESULT::OK)
-			{
-
-				RTNO_WARN(logger_, "In profile body receive sequence in get_profile(), is_new() timeout.");
-				break;
-			}
-
-			auto receive_result = transport_.receive(wait_usec);
-			if (receive_result.result != RESULT::OK)
+			const auto packet_deadline = std::min(deadline, deadline_after(policy.attempt_timeout_usec));
+			auto receive_result = transport_.receive(packet_deadline);
+			if (!receive_result)
 			{
-				if (receive_result.result == RESULT::PACKET_START_TIMEOUT || receive_result.result == RESULT::PACKET_HEADER_TIMEOUT || receive_result.result == RESULT::PACKET_BODY_TIMEOUT || receive_result.result == RESULT::PACKET_CHECKSUM_TIMEOUT)
+				if (is_timeout(receive_result.error()))
 				{
-					RTNO_DEBUG(logger_, "In getRTnoState(), timeout. retry");
-					transport_.clear_rx_buffer();
-					break;
+					RTNO_DEBUG(logger_, "In fetch_profile(), timeout. retry (attempt={})", attempt);
 				}
-				else if (receive_result.result == RESULT::CHECKSUM_ERROR)
+				else if (receive_result.error() == RESULT::CHECKSUM_ERROR)
 				{
-					RTNO_WARN(logger_, "In get_profile, receive checksum error. retry");
-					std::this_thread::sleep_for(std::chrono::milliseconds(10));
-					transport_.clear_rx_buffer();
-					return this->get_profile(wait_usec, retry_count - 1);
+					RTNO_WARN(logger_, "In fetch_profile, receive checksum error. retry (attempt={})", attempt);
 				}
 				else
 				{
-					RTNO_ERROR(logger_, "In get_profile, receive error: {}", result_to_string(receive_result.result));
+					RTNO_ERROR(logger_, "In fetch_profile, receive error: {}", result_to_string(receive_result.error()));
 					transport_.clear_rx_buffer();
-					return receive_result.result;
+					return receive_result.error();
 				}
+				transport_.clear_rx_buffer();
+				retry = true;
+				continue;
 			}
 
-			packet_t pac = receive_result.value.value();
+			const packet_t &pac = *receive_result;
 			switch ((COMMAND)pac.get_command())
 			{
 			case COMMAND::PLATFORM_PROFILE:
@@ -221,13 +356,17 @@ result_t<profile_t> protocol_t::get_profile(const uint32_t wait_usec, const int
 				RTNO_DEBUG(logger_, "COMMAND::GET_PROFILE received ({})", profile.to_string());
 				RTNO_TRACE(logger_, "RTnoProtocol::getRTnoProfile() exit");
 				transport_.clear_rx_buffer();
+				if (capabilities_ & CAPABILITY_FRAMING_V2)
+				{
+					transport_.set_framing(FRAMING::V2);
+				}
 				return profile; // onGetProfile(pac);
 
 			case COMMAND::INPORT_PROFILE:
 			{
 				auto inport_prof = parse_port_profile(pac);
 				RTNO_DEBUG(logger_, "COMMAND::INPORT_PROFILE received ({})", inport_prof.to_string());
-				profile.append_in_port(inport_prof);
+				profile.append_in_port(std::move(inport_prof));
 			}
 			break;
 
@@ -235,10 +374,13 @@ result_t<profile_t> protocol_t::get_profile(const uint32_t wait_usec, const int
 			{
 				auto outport_prof = parse_port_profile(pac);
 				RTNO_DEBUG(logger_, "COMMAND::OUTPORT_PROFILE received ({})", outport_prof.to_string());
-				profile.append_out_port(outport_prof);
+				profile.append_out_port(std::move(outport_prof));
 			}
 			break;
 
+			case COMMAND::HEART_BEAT:
+				break;
+
 			case COMMAND::PACKET_ERROR:
 			{
 				RTNO_ERROR(logger_, "COMMAND::PACKET_ERROR received. (packet={})", pac.to_string());
@@ -255,7 +397,7 @@ result_t<profile_t> protocol_t::get_profile(const uint32_t wait_usec, const int
 			}
 		}
 	}
-	return RESULT::TIMEOUT;
+	return last_result;
 }
 
 // RTnoProfile RTnoProtocol::onGetProfile(const packet_t& packet)
@@ -274,12 +416,18 @@ platform_profile_t protocol_t::parse_platform_profile(const packet_t &packet)
 		profile.architecture_ = (Architecture)packet.getData()[0];
 		this->architecture_ = profile.architecture_;
 	}
+	if (packet.getDataLength() >= 2)
+	{
+		// Never trust RTno to accept more than was offered.
+		profile.capabilities_ = packet.getData()[1] & offered_capabilities_;
+	}
+	this->capabilities_ = profile.capabilities_;
 	return profile;
 }
 
 port_profile_t protocol_t::parse_port_profile(const packet_t &packet)
 {
-	logger_.debug("parse_port_profile({}) called.", packet.to_string());
+	RTNO_DEBUG(logger_, "parse_port_profile({}) called.", packet.to_string());
 	char strbuf[64];
 	memcpy(strbuf, packet.getData() + 1, packet.getDataLength() - 1);
 	strbuf[packet.getDataLength() - 1] = 0;
@@ -291,203 +439,559 @@ static bool is_ok(const ssr::rtno2::packet_t &packet)
 	return packet.get_result() == RESULT::OK;
 }
 
-RESULT protocol_t::activate(const uint32_t wait_usec, const int retry_count)
+RESULT protocol_t::activate(const deadline_t deadline, const retry_policy_t &policy)
 {
 	RTNO_TRACE(logger_, "activate() called.");
 	RTNO_INFO(logger_, "Activating RTno");
 	static const packet_t cmd_packet(COMMAND::ACTIVATE, RESULT::OK);
-	for (int i = 0; i < retry_count; i++)
+	auto result = transact(cmd_packet, COMMAND::ACTIVATE, deadline, policy);
+	if (result)
 	{
+		RTNO_DEBUG(logger_, " - RTnoProtocol::activateRTno() exit with {}.", result_to_string(result->get_result()));
+		return result->get_result();
+	}
+	return result.error();
+}
 
-		transport_.send(cmd_packet);
-		auto result = wait_and_receive_command(COMMAND::ACTIVATE, wait_usec, retry_count);
-		if (result.result == RESULT::OK)
-		{
-			RTNO_DEBUG(logger_, " - RTnoProtocol::activateRTno() exit with success.");
-			return result.result;
-		}
-		else if (result.result == RESULT::CHECKSUM_ERROR)
+RESULT protocol_t::deactivate(const deadline_t deadline, const retry_policy_t &policy)
+{
+	RTNO_TRACE(logger_, "deactivate() called.");
+	RTNO_INFO(logger_, "Deactivating RTno");
+	static const packet_t cmd_packet(COMMAND::DEACTIVATE, RESULT::OK);
+	auto result = transact(cmd_packet, COMMAND::DEACTIVATE, deadline, policy);
+	if (result)
+	{
+		RTNO_DEBUG(logger_, " - RTnoProtocol::deactivateRTno() exit with {}.", result_to_string(result->get_result()));
+		return result->get_result();
+	}
+	return result.error();
+}
+
+RESULT protocol_t::execute(const deadline_t deadline, const retry_policy_t &policy)
+{
+	RTNO_TRACE(logger_, "execute() called.");
+	RTNO_INFO(logger_, "Executing RTno");
+	static const packet_t cmd_packet(COMMAND::EXECUTE, RESULT::OK);
+	auto result = transact(cmd_packet, COMMAND::EXECUTE, deadline, policy);
+	if (result)
+	{
+		RTNO_DEBUG(logger_, "executeRTno() exit with {}", result_to_string(result->get_result()));
+		return result->get_result();
+	}
+	return result.error();
+}
+
+RESULT protocol_t::send_inport_data(const std::string &portName, const uint8_t *data, const uint8_t length, const deadline_t deadline, const retry_policy_t &policy)
+{
+	RTNO_DEBUG(logger_, "send_inport_data(port={}, data={}, length={}, {}) called", portName, to_byte_string(data, length), length, policy.to_string());
+	if (2 + portName.length() + length > PACKET_MAX_DATA_SIZE)
+	{
+		if (capabilities_ & CAPABILITY_FRAGMENTED_DATA)
 		{
-			RTNO_WARN(logger_, "In activate, receive checksum error. retry");
-			transport_.clear_rx_buffer();
-			continue;
+			fragment_buffer_.assign(data, data + length);
+			return send_fragmented(portName, deadline, policy);
 		}
-		//      RTNO_DEBUG(m_Logger, " - RTnoProtocol::activateRTno() exit with failure.");
+		RTNO_ERROR(logger_, "send_inport_data(port={}, length={}) exit with error (does not fit in a packet)", portName, length);
+		return RESULT::ERR;
+	}
+	auto packet = make_send_data_packet(portName, data, length);
+	if (!packet)
+	{
+		return packet.error();
+	}
+	auto result = transact(*packet, COMMAND::SEND_DATA, deadline, policy);
+	if (result)
+	{
+		RTNO_TRACE(logger_, "send_inport_data() exit with success ({})", result->to_string());
+		invalidate_profile_on(result->get_result());
+		return result->get_result();
+	}
+	RTNO_ERROR(logger_, "send_inport_data(port={}, data={}, length={}) exit with error ({})", portName, to_byte_string(data, length), length, result_to_string(result.error()));
+	return result.error();
+}
 
-		else if (result.result == RESULT::PACKET_START_TIMEOUT || result.result == RESULT::PACKET_HEADER_TIMEOUT || result.result == RESULT::PACKET_BODY_TIMEOUT || result.result == RESULT::PACKET_CHECKSUM_TIMEOUT)
+RESULT protocol_t::receive_outport_data(const std::string &portName, uint8_t *data, const uint8_t max_size, uint8_t *size_read, const deadline_t deadline, const retry_policy_t &policy)
+{
+	RTNO_TRACE(logger_, "receive_outport_data(portName={}, {}) called", portName, policy.to_string());
+	auto packet = make_receive_data_packet(portName);
+	if (!packet)
+	{
+		RTNO_ERROR(logger_, "receive_outport_data(portName={}) exit with error (name does not fit in a packet)", portName);
+		return packet.error();
+	}
+	auto result = transact(*packet, COMMAND::RECEIVE_DATA, deadline, policy);
+	if (result)
+	{
+		// The name is only for the debug log below; copying it allocates for long names.
+		std::string name;
+		auto reply_result = parse_receive_data_reply(*result, data, max_size, size_read, logger_.should_log(spdlog::level::debug) ? &name : NULL);
+		invalidate_profile_on(reply_result);
+		if (reply_result == RESULT::ERR)
 		{
-			RTNO_DEBUG(logger_, "In getRTnoState(), timeout. retry");
-			transport_.clear_rx_buffer();
+			RTNO_ERROR(logger_, "receive_outport_data() malformed reply or maximum buffer size exceeded (max={}, received={})", max_size, *size_read);
+			RTNO_ERROR(logger_, "receive_outport_data(portName={}) exit with error", portName);
+			return reply_result;
 		}
+		RTNO_DEBUG(logger_, "receive_outport_data() received (name={}, data_size={}, data={}) exit with {} ({})", name, *size_read, to_byte_string(data, *size_read), result_to_string(reply_result), result->to_string());
+		return reply_result;
 	}
-	return RESULT::ERR;
+
+	RTNO_ERROR(logger_, "receive_outport_data(portName={}) exit with error ({})", portName, result_to_string(result.error()));
+	return result.error();
 }
 
-RESULT protocol_t::deactivate(const uint32_t wait_usec, const int retry_count)
+RESULT protocol_t::send_inport_data(const port_id_t port, const uint8_t *data, const uint8_t length, const deadline_t deadline, const retry_policy_t &policy)
 {
-	RTNO_TRACE(logger_, "deactivate() called.");
-	RTNO_INFO(logger_, "Deactivating RTno");
-	static const packet_t cmd_packet(COMMAND::DEACTIVATE, RESULT::OK);
-	for (int i = 0; i < retry_count; i++)
+	auto profile = profile_valid_ ? profile_.inport_at(port) : NULL;
+	if (profile == NULL)
+	{
+		RTNO_ERROR(logger_, "send_inport_data(port_id={}/{}) exit with error (stale port id)", port.index, port.generation);
+		return RESULT::INPORT_NOT_FOUND;
+	}
+	return send_inport_data(profile->name(), data, length, deadline, policy);
+}
+
+RESULT protocol_t::receive_outport_data(const port_id_t port, uint8_t *data, const uint8_t max_size, uint8_t *size_read, const deadline_t deadline, const retry_policy_t &policy)
+{
+	auto profile = profile_valid_ ? profile_.outport_at(port) : NULL;
+	if (profile == NULL)
+	{
+		RTNO_ERROR(logger_, "receive_outport_data(port_id={}/{}) exit with error (stale port id)", port.index, port.generation);
+		return RESULT::OUTPORT_NOT_FOUND;
+	}
+	return receive_outport_data(profile->name(), data, max_size, size_read, deadline, policy);
+}
+
+RESULT protocol_t::send_prepared(const packet_t &request, const uint8_t sum, const deadline_t deadline, const retry_policy_t &policy)
+{
+	RTNO_TRACE(logger_, "send_prepared({}, {}) called", request.to_string(), policy.to_string());
+	auto result = transact(request, sum, COMMAND::SEND_DATA, deadline, policy);
+	if (!result)
+	{
+		RTNO_ERROR(logger_, "send_prepared({}) exit with error ({})", request.to_string(), result_to_string(result.error()));
+		return result.error();
+	}
+	invalidate_profile_on(result->get_result());
+	return result->get_result();
+}
+
+result_t<packet_t> protocol_t::receive_prepared(const packet_t &request, const uint8_t sum, const deadline_t deadline, const retry_policy_t &policy)
+{
+	RTNO_TRACE(logger_, "receive_prepared({}, {}) called", request.to_string(), policy.to_string());
+	auto result = transact(request, sum, COMMAND::RECEIVE_DATA, deadline, policy);
+	if (!result)
+	{
+		RTNO_ERROR(logger_, "receive_prepared({}) exit with error ({})", request.to_string(), result_to_string(result.error()));
+	}
+	return result;
+}
+
+RESULT protocol_t::send_fragmented(const std::string &portName, const deadline_t deadline, const retry_policy_t &policy)
+{
+	RTNO_TRACE(logger_, "send_fragmented(port={}, size={}, {}) called", portName, fragment_buffer_.size(), policy.to_string());
+	const size_t capacity = fragment_capacity(portName.length());
+	const size_t count = capacity > 0 ? (fragment_buffer_.size() + capacity - 1) / capacity : 0;
+	if (count == 0 || count > FRAGMENT_MAX_COUNT)
+	{
+		RTNO_ERROR(logger_, "send_fragmented(port={}) exit with error ({} bytes do not fit in {} fragments)", portName, fragment_buffer_.size(), FRAGMENT_MAX_COUNT);
+		return RESULT::ERR;
+	}
+	if (fragment_packets_.size() < count)
+	{
+		fragment_packets_.resize(count, packet_t(COMMAND::SEND_DATA_FRAGMENT, RESULT::OK));
+	}
+	fragment_frames_.clear();
+	for (size_t i = 0, offset = 0; i < count; i++, offset += capacity)
 	{
+		const size_t size = std::min(capacity, fragment_buffer_.size() - offset);
+		memcpy(prepare_fragment_packet(fragment_packets_[i], portName, static_cast<uint8_t>(i), static_cast<uint8_t>(count), static_cast<uint8_t>(size)), fragment_buffer_.data() + offset, size);
+		fragment_frames_.push_back(&fragment_packets_[i]);
+	}
+	// RTno answers SEND_DATA once, after the last fragment.
+	auto result = transact_with([&]()
+								{ return transport_.send(fragment_frames_); },
+								COMMAND::SEND_DATA, deadline, policy);
+	if (!result)
+	{
+		RTNO_ERROR(logger_, "send_fragmented(port={}) exit with error ({})", portName, result_to_string(result.error()));
+		return result.error();
+	}
+	invalidate_profile_on(result->get_result());
+	return result->get_result();
+}
 
-		transport_.send(cmd_packet);
-		auto result = wait_and_receive_command(COMMAND::DEACTIVATE, wait_usec, retry_count);
-		if (result.result == RESULT::OK)
+RESULT protocol_t::receive_fragmented(const std::string &portName, const deadline_t deadline, const retry_policy_t &policy)
+{
+	RTNO_TRACE(logger_, "receive_fragmented(port={}, {}) called", portName, policy.to_string());
+	packet_t request(COMMAND::RECEIVE_DATA_FRAGMENT, RESULT::OK);
+	if (prepare_send_data_packet(request, portName, 0) == NULL)
+	{
+		RTNO_ERROR(logger_, "receive_fragmented(port={}) exit with error (name does not fit in a packet)", portName);
+		return RESULT::ERR;
+	}
+	RESULT last_result = RESULT::TIMEOUT;
+	for (int attempt = 0; attempt < policy.max_attempts; attempt++)
+	{
+		if (!wait_backoff(attempt, deadline, policy))
 		{
-			RTNO_DEBUG(logger_, " - RTnoProtocol::deactivateRTno() exit with success.");
-			return result.result;
+			break;
 		}
-		else if (result.result == RESULT::CHECKSUM_ERROR)
+		transport_.discard(COMMAND::RECEIVE_DATA_FRAGMENT);
+		const RESULT send_result = transport_.send(request);
+		if (send_result != RESULT::OK)
 		{
-			RTNO_WARN(logger_, "In deactivate, receive checksum error. retry");
-			transport_.clear_rx_buffer();
+			last_result = send_result;
+			RTNO_WARN(logger_, "In receive_fragmented(), send failed ({}). retry (attempt={})", result_to_string(send_result), attempt);
 			continue;
 		}
-		else if (result.result == RESULT::PACKET_START_TIMEOUT || result.result == RESULT::PACKET_HEADER_TIMEOUT || result.result == RESULT::PACKET_BODY_TIMEOUT || result.result == RESULT::PACKET_CHECKSUM_TIMEOUT)
+		const int frame_id = transport_.last_frame_id();
+		fragment_buffer_.clear();
+
+		// Fragments arrive in index order. attempt_timeout_usec bounds the silence between two of them.
+		size_t next = 0;
+		while (true)
 		{
-			RTNO_WARN(logger_, "In getRTnoState(), timeout. retry");
-			transport_.clear_rx_buffer();
+			const auto fragment_deadline = std::min(deadline, deadline_after(policy.attempt_timeout_usec));
+			auto received = wait_and_receive_command(COMMAND::RECEIVE_DATA_FRAGMENT, fragment_deadline, frame_id);
+			if (!received)
+			{
+				last_result = received.error();
+				if (is_timeout(last_result) || last_result == RESULT::CHECKSUM_ERROR)
+				{
+					transport_.clear_rx_buffer();
+				}
+				RTNO_DEBUG(logger_, "In receive_fragmented(), {} after {} fragments. retry (attempt={})", result_to_string(last_result), next, attempt);
+				break;
+			}
+			if (!reply_matches_port(*received, portName))
+			{
+				RTNO_DEBUG(logger_, "In receive_fragmented(), discard stale reply ({})", received->to_string());
+				continue;
+			}
+			const uint8_t *data = NULL;
+			uint8_t size = 0, index = 0, count = 0;
+			const RESULT result = view_fragment(*received, &data, &size, &index, &count);
+			if (result != RESULT::OK)
+			{
+				// Failures (e.g. OUTPORT_BUFFER_EMPTY) are answered with a single fragment, and are final.
+				invalidate_profile_on(result);
+				return result;
+			}
+			if (index != next && next == 0)
+			{
+				RTNO_DEBUG(logger_, "In receive_fragmented(), discard fragment {}/{} of an earlier transfer", index, count);
+				continue;
+			}
+			if (index != next)
+			{
+				last_result = RESULT::ERR;
+				RTNO_WARN(logger_, "In receive_fragmented(), fragment {} lost (received {}/{}). retry (attempt={})", next, index, count, attempt);
+				break;
+			}
+			fragment_buffer_.insert(fragment_buffer_.end(), data, data + size);
+			if (++next == count)
+			{
+				RTNO_TRACE(logger_, "receive_fragmented() exit with success ({} bytes in {} fragments)", fragment_buffer_.size(), count);
+				return RESULT::OK;
+			}
 		}
 	}
+	if (is_expired(deadline))
+	{
+		RTNO_WARN(logger_, "receive_fragmented(port={}) exit with TIMEOUT (deadline expired, last result={})", portName, result_to_string(last_result));
+		return RESULT::TIMEOUT;
+	}
+	RTNO_WARN(logger_, "receive_fragmented(port={}) exit with ERR (attempts exhausted, last result={})", portName, result_to_string(last_result));
 	return RESULT::ERR;
 }
 
-RESULT protocol_t::execute(const uint32_t wait_usec, const int retry_count)
+static RESULT complete_request(pipeline_t::request_t &request, const packet_t &reply)
 {
-	try
+	if (reply.get_command() == COMMAND::RECEIVE_DATA)
 	{
-		RTNO_TRACE(logger_, "execute() called.");
-		RTNO_INFO(logger_, "Executing RTno");
-		static const packet_t cmd_packet(COMMAND::EXECUTE, RESULT::OK);
-		for (int i = 0; i < retry_count; i++)
-		{
+		return request.result = parse_receive_data_reply(reply, request.data, request.max_size, request.size_read);
+	}
+	return request.result = reply.get_result();
+}
+
+RESULT protocol_t::run_pipeline(pipeline_t &pipeline, const deadline_t deadline, const retry_policy_t &policy)
+{
+	RTNO_TRACE(logger_, "run_pipeline(size={}, {}) called", pipeline.size(), policy.to_string());
+	if (pipeline.error() != RESULT::OK)
+	{
+		RTNO_ERROR(logger_, "run_pipeline() exit with error (a request does not fit in a packet)");
+		return pipeline.error();
+	}
+	auto &requests = pipeline.requests();
+	pipeline_packets_.clear();
+	for (auto &request : requests)
+	{
+		request.result = RESULT::UNINITIALIZED;
+		pipeline_packets_.push_back(&request.packet);
+	}
 
-			transport_.send(cmd_packet);
-			auto result = wait_and_receive_command(COMMAND::EXECUTE, wait_usec, retry_count);
-			if (result.result == RESULT::OK)
+	const bool sent = !requests.empty() && transport_.send(pipeline_packets_) == RESULT::OK;
+	if (sent)
+	{
+		// Replies come back in request order. Each outstanding reply gets one attempt_timeout_usec.
+		// In V2 each reply carries the frame id of its request, and the ids of the batch are consecutive.
+		const bool by_frame_id = transport_.last_frame_id() != transport_t::ANY_FRAME_ID && requests.size() <= 256;
+		const uint8_t first_id = static_cast<uint8_t>(transport_.last_frame_id() - (requests.size() - 1));
+		size_t next = 0;
+		while (next < requests.size())
+		{
+			const auto attempt_deadline = std::min(deadline, deadline_after(policy.attempt_timeout_usec));
+			int frame_id = transport_t::ANY_FRAME_ID;
+			auto received = transport_.receive(attempt_deadline, &frame_id);
+			if (received.error() == RESULT::CHECKSUM_ERROR)
+			{
+				RTNO_WARN(logger_, "In run_pipeline(), checksum error. The reply is lost and will be retried.");
+				continue;
+			}
+			if (!received)
+			{
+				RTNO_DEBUG(logger_, "In run_pipeline(), {} while waiting reply {}/{}", result_to_string(received.error()), next, requests.size());
+				break;
+			}
+			const packet_t &reply = *received;
+			if (by_frame_id && frame_id != transport_t::ANY_FRAME_ID)
 			{
-				if (!result.value.has_value())
+				const size_t index = static_cast<uint8_t>(frame_id - first_id);
+				if (index < next || index >= requests.size() || (reply.get_command() != requests[index].reply_command && reply.get_command() != COMMAND::PACKET_ERROR))
 				{
-					RTNO_ERROR(logger_, "In execute(), no packet received although RESULT::OK.");
-					return RESULT::ERR;
+					RTNO_DEBUG(logger_, "In run_pipeline(), discard stale reply to frame {} ({})", frame_id, reply.to_string());
+					continue;
 				}
-				RTNO_DEBUG(logger_, "executeRTno() exit with {}", result_to_string(result.value.value().get_result()));
-				return result.result;
+				complete_request(requests[index], reply);
+				next = index + 1;
+				continue;
 			}
-			else if (result.result == RESULT::CHECKSUM_ERROR)
+			size_t index = next;
+			while (index < requests.size() && !(requests[index].reply_command == reply.get_command() && reply_matches_port(reply, requests[index].port_name)))
 			{
-				RTNO_WARN(logger_, "In execute, receive checksum error. retry");
-				transport_.clear_rx_buffer();
-				continue;
+				index++;
 			}
-			else if (result.result == RESULT::PACKET_START_TIMEOUT || result.result == RESULT::PACKET_HEADER_TIMEOUT || result.result == RESULT::PACKET_BODY_TIMEOUT || result.result == RESULT::PACKET_CHECKSUM_TIMEOUT)
+			if (index == requests.size())
 			{
-				RTNO_WARN(logger_, "In getRTnoState(), timeout. retry");
-				transport_.clear_rx_buffer();
+				if (reply.get_command() == COMMAND::PACKET_ERROR)
+				{
+					RTNO_WARN(logger_, "In run_pipeline(), PACKET_ERROR({}) for request {}", result_to_string(reply.get_result()), next);
+					requests[next++].result = reply.get_result();
+				}
+				else
+				{
+					RTNO_DEBUG(logger_, "In run_pipeline(), discard stale reply ({})", reply.to_string());
+				}
+				continue;
 			}
+			// Requests skipped over lost their replies. They stay UNINITIALIZED and are retried below.
+			complete_request(requests[index], reply);
+			next = index + 1;
 		}
-		return RESULT::ERR;
 	}
-	catch (const std::exception &e)
+
+	// Fall back to stop-and-wait for every request without a reply.
+	RESULT result = RESULT::OK;
+	for (auto &request : requests)
 	{
-		RTNO_ERROR(logger_, "In execute() in protocol.cpp, Exception: {}", e.what());
-		throw e;
+		const bool lost = request.result == RESULT::UNINITIALIZED || request.result == RESULT::CHECKSUM_ERROR;
+		if (lost && sent && request.reply_command == COMMAND::EXECUTE)
+		{
+			// RTno may have run it already, and running it again would advance the control loop twice.
+			RTNO_WARN(logger_, "In run_pipeline(), reply of EXECUTE is lost. It is not retried.");
+			if (request.result == RESULT::UNINITIALIZED)
+			{
+				request.result = RESULT::TIMEOUT;
+			}
+		}
+		else if (lost)
+		{
+			RTNO_DEBUG(logger_, "In run_pipeline(), retry {} individually", request.packet.to_string());
+			if (request.reply_command == COMMAND::RECEIVE_DATA)
+			{
+				transport_.clear_rx_buffer();
+			}
+			// A late reply of the pipelined request must not be taken for the reply of the retry.
+			transport_.discard(request.reply_command);
+			auto reply = transact(request.packet, request.reply_command, deadline, policy);
+			if (reply)
+			{
+				complete_request(request, *reply);
+			}
+			else
+			{
+				request.result = reply.error();
+			}
+		}
+		invalidate_profile_on(request.result);
+		if (result == RESULT::OK && request.result != RESULT::OK)
+		{
+			result = request.result;
+		}
 	}
+	RTNO_TRACE(logger_, "run_pipeline() exit with {}", result_to_string(result));
+	return result;
 }
 
-RESULT protocol_t::send_inport_data(const std::string &portName, const uint8_t *data, const uint8_t length, const uint32_t wait_usec, const int retry_count)
+RESULT protocol_t::run_cycle(cycle_t &cycle, const deadline_t deadline, const retry_policy_t &policy)
 {
-	RTNO_DEBUG(logger_, "send_inport_data(port={}, wait_usec={}, data={}, length={}, retry={}) called", portName, wait_usec, to_byte_string(data, length), length, retry_count);
-	auto namelen = portName.length();
-	uint8_t buffer[256];
-	buffer[0] = static_cast<uint8_t>(namelen);
-	buffer[1] = length;
-	memcpy(buffer + 2, portName.c_str(), namelen);
-	memcpy(buffer + 2 + namelen, data, length);
-	packet_t packet(COMMAND::SEND_DATA, (RESULT)RESULT::OK, buffer, static_cast<uint8_t>(2 + namelen + length));
-	for (int i = 0; i < retry_count; i++)
+	RTNO_TRACE(logger_, "run_cycle(writes={}, execute={}, reads={}, {}) called", cycle.write_count(), cycle.executes(), cycle.read_count(), policy.to_string());
+	RESULT result;
+	if (!profile_valid_ && (result = refresh_profile(deadline, policy)) != RESULT::OK)
+	{
+		return result;
+	}
+	for (auto &write : cycle.writes())
 	{
-		transport_.send(packet);
-		auto result = wait_and_receive_command(COMMAND::SEND_DATA, wait_usec, retry_count);
-		if (result.result == RESULT::OK)
+		if (profile_.inport_at(write.port) == NULL)
 		{
-			RTNO_TRACE(logger_, "send_inport_data() exit with success ({})", result.value.value().to_string());
-			return result.value.value().get_result();
+			RTNO_ERROR(logger_, "run_cycle() exit with error (stale inport id {}/{})", write.port.index, write.port.generation);
+			return RESULT::INPORT_NOT_FOUND;
 		}
-		else if (result.result == RESULT::CHECKSUM_ERROR)
+	}
+	for (auto &read : cycle.reads())
+	{
+		if (profile_.outport_at(read.port) == NULL)
 		{
-			RTNO_WARN(logger_, "In send_inport_data, receive checksum error. retry");
-			transport_.clear_rx_buffer();
-			continue;
+			RTNO_ERROR(logger_, "run_cycle() exit with error (stale outport id {}/{})", read.port.index, read.port.generation);
+			return RESULT::OUTPORT_NOT_FOUND;
 		}
-		else if (result.result == RESULT::PACKET_START_TIMEOUT || result.result == RESULT::PACKET_HEADER_TIMEOUT || result.result == RESULT::PACKET_BODY_TIMEOUT || result.result == RESULT::PACKET_CHECKSUM_TIMEOUT)
+	}
+
+	packet_t request(COMMAND::BATCH_CYCLE, RESULT::OK);
+	if ((capabilities_ & CAPABILITY_BATCH_CYCLE) == 0 || !cycle.encode(request))
+	{
+		run_cycle_as_pipeline(cycle, deadline, policy);
+	}
+	else
+	{
+		auto reply = cycle.executes() ? transact_once(request, COMMAND::BATCH_CYCLE, deadline, policy) : transact(request, COMMAND::BATCH_CYCLE, deadline, policy);
+		if (!reply)
 		{
-			RTNO_WARN(logger_, "In send_inport_data(), timeout. retry");
-			transport_.clear_rx_buffer();
+			RTNO_ERROR(logger_, "run_cycle() exit with error ({})", result_to_string(reply.error()));
+			for (size_t i = 0; i < cycle.write_count(); i++)
+			{
+				cycle.set_write_result(i, reply.error());
+			}
+			cycle.set_execute_result(cycle.executes() ? reply.error() : RESULT::NONE);
+			for (size_t i = 0; i < cycle.read_count(); i++)
+			{
+				cycle.set_read_result(i, reply.error(), 0);
+			}
+			return reply.error();
+		}
+		if (reply->get_result() != RESULT::OK || cycle.decode(*reply) != RESULT::OK)
+		{
+			RTNO_ERROR(logger_, "run_cycle() exit with error (malformed reply {})", reply->to_string());
+			return reply->get_result() != RESULT::OK ? reply->get_result() : RESULT::ERR;
+		}
+		for (size_t i = 0; i < cycle.read_count(); i++)
+		{
+			if (cycle.read_result(i) == RESULT::NONE)
+			{
+				// Did not fit in the reply.
+				uint8_t size = 0;
+				const RESULT read_result = receive_outport_data(profile_.outports_[cycle.reads()[i].port.index].name(), cycle.read_buffer(i), PACKET_MAX_DATA_SIZE, &size, deadline, policy);
+				cycle.set_read_result(i, read_result, read_result == RESULT::OK ? size : 0);
+			}
 		}
 	}
-	RTNO_ERROR(logger_, "send_inport_data(port={}, wait_usec={}, data={}, length={}, retry={}) exit with error", portName, wait_usec, to_byte_string(data, length), length, retry_count);
-	return RESULT::ERR;
+
+	result = cycle.result();
+	invalidate_profile_on(result);
+	RTNO_TRACE(logger_, "run_cycle() exit with {}", result_to_string(result));
+	return result;
 }
 
-RESULT protocol_t::receive_outport_data(const std::string &portName, uint8_t *data, const uint8_t max_size, uint8_t *size_read, const uint32_t wait_usec, const int retry_count)
+static bool send_data_fits(const std::string &portName, const size_t length)
 {
-	RTNO_TRACE(logger_, "receive_outport_data(portName={}, retry={}) called", portName, retry_count);
-	auto namelen = portName.length(); // strlen(portName);
-	uint8_t buffer[255];
-	buffer[0] = static_cast<uint8_t>(namelen);
-	memcpy(buffer + 2, portName.c_str(), namelen);
-	packet_t packet(COMMAND::RECEIVE_DATA, (RESULT)RESULT::OK, buffer, static_cast<uint8_t>(2 + namelen));
-	for (int i = 0; i < retry_count; i++)
-	{
-		transport_.send(packet);
-		auto result = wait_and_receive_command(COMMAND::RECEIVE_DATA, wait_usec);
-		if (result.result == RESULT::OK)
-		{
-			auto packet = result.value.value();
-			uint8_t name_len = packet.getData()[0];
-			uint8_t data_len = packet.getData()[1];
-			*size_read = data_len;
-			if (*size_read > max_size)
+	return 2 + portName.length() + length <= PACKET_MAX_DATA_SIZE;
+}
+
+void protocol_t::run_cycle_as_pipeline(cycle_t &cycle, const deadline_t deadline, const retry_policy_t &policy)
+{
+	// A value which does not fit in one packet cannot be pipelined. It is sent first on its own,
+	// fragmented if RTno accepted CAPABILITY_FRAGMENTED_DATA.
+	RESULT oversized_result = RESULT::OK;
+	size_t failed = 0;
+	for (; failed < cycle.write_count(); failed++)
+	{
+		const std::string &name = profile_.inports_[cycle.writes()[failed].port.index].name();
+		const auto value = cycle.write_value(failed);
+		if (!send_data_fits(name, value.size()))
+		{
+			oversized_result = send_inport_data(name, value.data(), static_cast<uint8_t>(value.size()), deadline, policy);
+			cycle.set_write_result(failed, oversized_result);
+			if (oversized_result != RESULT::OK)
 			{
-				RTNO_ERROR(logger_, "receive_outport_data() maximum buffer size exceeded (max={}, received={})", max_size, *size_read);
-				RTNO_ERROR(logger_, "receive_outport_data(portName={}, retry={}) exit with error", portName, retry_count);
-				return packet.get_result();
+				break;
 			}
-			char name[256];
-			memcpy(name, packet.getData() + 2, name_len);
-			name[name_len] = 0;
-			memcpy(data, packet.getData() + 2 + name_len, *size_read);
-			RTNO_DEBUG(logger_, "receive_outport_data() received (name={}/name_len={}, data_size={}, data={}) exit with success ({})", name, name_len, *size_read, to_byte_string(data, *size_read), result.value.value().to_string());
-			return packet.get_result();
 		}
-		else if (result.result == RESULT::CHECKSUM_ERROR)
+	}
+	if (oversized_result != RESULT::OK)
+	{
+		RTNO_ERROR(logger_, "run_cycle() a value which does not fit in a packet failed ({}). The rest of the cycle is not run.", result_to_string(oversized_result));
+		for (size_t i = 0; i < cycle.write_count(); i++)
 		{
-			RTNO_WARN(logger_, "In receive_outport_data, receive checksum error. retry");
-			transport_.clear_rx_buffer();
-			continue;
+			// Everything not sent yet: the writes after the failed one, and the pipelined writes before it.
+			if (i > failed || (i < failed && send_data_fits(profile_.inports_[cycle.writes()[i].port.index].name(), cycle.write_value(i).size())))
+			{
+				cycle.set_write_result(i, oversized_result);
+			}
 		}
-		else if (result.result == RESULT::PACKET_START_TIMEOUT || result.result == RESULT::PACKET_HEADER_TIMEOUT || result.result == RESULT::PACKET_BODY_TIMEOUT || result.result == RESULT::PACKET_CHECKSUM_TIMEOUT)
+		cycle.set_execute_result(cycle.executes() ? oversized_result : RESULT::NONE);
+		for (size_t i = 0; i < cycle.read_count(); i++)
 		{
-			RTNO_WARN(logger_, "In receive_outport_data(), timeout. retry");
-			transport_.clear_rx_buffer();
+			cycle.set_read_result(i, oversized_result, 0);
 		}
+		return;
 	}
 
-	RTNO_ERROR(logger_, "receive_outport_data(portName={}, retry={}) exit with error", portName, retry_count);
-	return RESULT::ERR;
+	cycle_pipeline_.clear();
+	cycle_sizes_.assign(cycle.read_count(), 0);
+	for (size_t i = 0; i < cycle.write_count(); i++)
+	{
+		const std::string &name = profile_.inports_[cycle.writes()[i].port.index].name();
+		const auto value = cycle.write_value(i);
+		if (send_data_fits(name, value.size()))
+		{
+			cycle_pipeline_.send_inport_data(name, value.data(), static_cast<uint8_t>(value.size()));
+		}
+	}
+	if (cycle.executes())
+	{
+		cycle_pipeline_.execute();
+	}
+	for (size_t i = 0; i < cycle.read_count(); i++)
+	{
+		cycle_pipeline_.receive_outport_data(profile_.outports_[cycle.reads()[i].port.index].name(), cycle.read_buffer(i), PACKET_MAX_DATA_SIZE, &cycle_sizes_[i]);
+	}
+	run_pipeline(cycle_pipeline_, deadline, policy);
+
+	size_t index = 0;
+	for (size_t i = 0; i < cycle.write_count(); i++)
+	{
+		if (send_data_fits(profile_.inports_[cycle.writes()[i].port.index].name(), cycle.write_value(i).size()))
+		{
+			cycle.set_write_result(i, cycle_pipeline_.result(index++));
+		}
+	}
+	cycle.set_execute_result(cycle.executes() ? cycle_pipeline_.result(index++) : RESULT::NONE);
+	for (size_t i = 0; i < cycle.read_count(); i++)
+	{
+		const RESULT read_result = cycle_pipeline_.result(index++);
+		cycle.set_read_result(i, read_result, read_result == RESULT::OK ? cycle_sizes_[i] : 0);
+	}
 }
 
-RESULT protocol_t::receive_log_data(uint8_t *data, const uint8_t max_size, uint8_t *size_read, const uint32_t wait_usec, const int retry_count)
+RESULT protocol_t::receive_log_data(uint8_t *data, const uint8_t max_size, uint8_t *size_read, const deadline_t deadline, const retry_policy_t &policy)
 {
-	RTNO_TRACE(logger_, "receive_log_data(retry={}) called", retry_count);
-	packet_t packet(COMMAND::RECEIVE_LOG, (RESULT)RESULT::OK);
-	transport_.send(packet);
-	auto result = wait_and_receive_command(COMMAND::RECEIVE_LOG, wait_usec);
-	if (result.result == RESULT::OK)
+	RTNO_TRACE(logger_, "receive_log_data({}) called", policy.to_string());
+	static const packet_t cmd_packet(COMMAND::RECEIVE_LOG, (RESULT)RESULT::OK);
+	auto result = transact(cmd_packet, COMMAND::RECEIVE_LOG, deadline, policy);
+	if (result)
 	{
-		auto packet = result.value.value();
+		const auto &packet = *result;
 		if (max_size < packet.getDataLength() + 1)
 		{
 			return RESULT::LOG_DATA_EXCEED_SIZE;
@@ -499,18 +1003,18 @@ RESULT protocol_t::receive_log_data(uint8_t *data, const uint8_t max_size, uint8
 		return packet.get_result();
 	}
 
-	RTNO_ERROR(logger_, "receive_log_data() exit with error (wait_and_receive_command returns error ({}))", result_to_string(result.result));
-	return RESULT::ERR;
+	RTNO_ERROR(logger_, "receive_log_data() exit with error (transact returns error ({}))", result_to_string(result.error()));
+	return result.error();
 }
 
-result_t<std::string> protocol_t::get_log(const uint32_t wait_usec, const int retry_count)
+result_t<std::string> protocol_t::get_log(const deadline_t deadline, const retry_policy_t &policy)
 {
 	uint8_t buffer[MAX_PACKET_SIZE];
 	uint8_t size_read = 0;
-	result_t<std::string> result;
-	if ((result = this->receive_log_data(buffer, MAX_PACKET_SIZE, &size_read, wait_usec, retry_count)).result != RESULT::OK)
+	RESULT result;
+	if ((result = this->receive_log_data(buffer, MAX_PACKET_SIZE, &size_read, deadline, policy)) != RESULT::OK)
 	{
-		return result.result;
+		return result;
 	}
 	return std::string((char *)buffer);
 }
@@ -0,0 +1,740 @@
+#include "rtno2/relay.h"
+
+#ifdef __linux__
+
+#include "rtno2/request.h"
+#include "ByteRing.h"
+
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <chrono>
+#include <deque>
+#include <algorithm>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+using namespace ssr::rtno2;
+
+static int64_t now_nsec()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// epoll_event.data: pair index (listen, serial) or client slot << 2 | kind
+enum : uint64_t
+{
+	KIND_LISTEN = 0,
+	KIND_SERIAL = 1,
+	KIND_CLIENT = 2,
+	STOP_TAG = ~0ULL,
+};
+
+struct request_t
+{
+	packet_t packet;
+	FRAMING framing;
+	uint8_t frame_id;
+};
+
+struct relay_t::client_t
+{
+	size_t slot;
+	pair_t &pair;
+	int fd; // -1 once dropped, until reap_clients()
+	ssr::ByteRing to_client;
+	frame_decoder_t requests;
+	std::deque<request_t> queue; // decoded, not yet on the wire
+	uint32_t events;
+
+	client_t(const size_t slot, pair_t &pair, const int fd) : slot(slot), pair(pair), fd(fd), to_client(BUFFER_SIZE), events(0) {}
+};
+
+struct relay_t::pair_t
+{
+	// Client receiving a reply in the framing and frame id of its own request.
+	struct recipient_t
+	{
+		client_t *client;
+		FRAMING framing;
+		uint8_t frame_id;
+	};
+
+	size_t index;
+	uint16_t port;
+	int serial_fd;
+	int listen_fd;
+	ssr::ByteRing to_serial;
+	frame_decoder_t replies;
+	std::vector<client_t *> clients; // in turn order
+	size_t next_client;
+	uint32_t serial_events; // registered interest, EPOLL_CTL_MOD only on change
+
+	// The transaction on the wire.
+	bool active;
+	client_t *owner; // NULL if it disconnected meanwhile
+	std::vector<request_t> requests;
+	size_t written;	 // requests pushed to to_serial
+	size_t pending;	 // requests not answered yet
+	bool replied;	 // a reply frame arrived (no more joining)
+	std::vector<recipient_t> joined;
+	int64_t last_nsec; // last serial activity of the transaction
+
+	pair_t(const size_t index, const uint16_t port, const int serial_fd, const int listen_fd)
+		: index(index), port(port), serial_fd(serial_fd), listen_fd(listen_fd), to_serial(BUFFER_SIZE), next_client(0), serial_events(0),
+		  active(false), owner(NULL), written(0), pending(0), replied(false), last_nsec(0)
+	{
+	}
+};
+
+static epoll_event make_event(const uint32_t events, const uint64_t tag)
+{
+	epoll_event event;
+	memset(&event, 0, sizeof(event));
+	event.events = events;
+	event.data.u64 = tag;
+	return event;
+}
+
+static uint64_t tag_of(const size_t index, const uint64_t kind)
+{
+	return ((uint64_t)index << 2) | kind;
+}
+
+static void set_tcp_option(const int fd, const int option, const int value)
+{
+	setsockopt(fd, IPPROTO_TCP, option, &value, sizeof(value));
+}
+
+static void update_events(const int epoll_fd, const int fd, const uint64_t tag, uint32_t &registered, const uint32_t events)
+{
+	if (events != registered)
+	{
+		auto event = make_event(events, tag);
+		epoll_ctl(epoll_fd, EPOLL_CTL_MOD, fd, &event);
+		registered = events;
+	}
+}
+
+static bool is_coalescible(const packet_t &request)
+{
+	return request.get_command() == COMMAND::GET_STATE || request.get_command() == COMMAND::GET_PROFILE;
+}
+
+static bool same_request(const packet_t &a, const packet_t &b)
+{
+	return a.get_command() == b.get_command() && a.getDataLength() == b.getDataLength() && memcmp(a.getData(), b.getData(), a.getDataLength()) == 0;
+}
+
+/**
+ * @brief false for a SEND_DATA_FRAGMENT before the last one, which RTno does not answer.
+ */
+static bool is_answered(const packet_t &request)
+{
+	const uint8_t *data;
+	uint8_t size, index, count;
+	return request.get_command() != COMMAND::SEND_DATA_FRAGMENT || view_fragment(request, &data, &size, &index, &count) != RESULT::OK || index + 1 >= count;
+}
+
+/**
+ * @brief false for the replies which precede the one answering a request (profiles, fragments but the last).
+ */
+static bool is_last_reply(const packet_t &reply)
+{
+	const uint8_t *data;
+	uint8_t size, index, count;
+	switch (reply.get_command())
+	{
+	case COMMAND::PLATFORM_PROFILE:
+	case COMMAND::INPORT_PROFILE:
+	case COMMAND::OUTPORT_PROFILE:
+		return false;
+	case COMMAND::RECEIVE_DATA_FRAGMENT:
+		return view_fragment(reply, &data, &size, &index, &count) != RESULT::OK || index + 1 >= count;
+	default:
+		return true;
+	}
+}
+
+/**
+ * @brief Number of requests at the front of queue forming one transaction, 0 if a run of fragments is incomplete.
+ */
+static size_t ready_count(const std::deque<request_t> &queue)
+{
+	if (queue.empty())
+	{
+		return 0;
+	}
+	if (is_coalescible(queue.front().packet))
+	{
+		return 1; // alone, so that others can share it
+	}
+	size_t complete = 0;
+	for (size_t n = 1; n <= queue.size(); n++)
+	{
+		if (is_answered(queue[n - 1].packet))
+		{
+			complete = n;
+			if (complete >= relay_t::MAX_BATCH)
+			{
+				break;
+			}
+		}
+	}
+	return complete;
+}
+
+relay_t::relay_t(const LOGLEVEL loglevel, const uint32_t timeout_usec)
+	: epoll_fd_(epoll_create1(EPOLL_CLOEXEC)), stop_fd_(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)), timeout_usec_(timeout_usec), logger_(get_logger("relay"))
+{
+	set_log_level(&logger_, loglevel);
+	auto event = make_event(EPOLLIN, STOP_TAG);
+	epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, stop_fd_, &event);
+}
+
+relay_t::~relay_t()
+{
+	for (auto &client : clients_)
+	{
+		if (client && client->fd >= 0)
+		{
+			::close(client->fd);
+		}
+	}
+	for (auto &pair : pairs_)
+	{
+		if (pair->listen_fd >= 0)
+		{
+			::close(pair->listen_fd);
+		}
+	}
+	::close(stop_fd_);
+	::close(epoll_fd_);
+}
+
+RESULT relay_t::add(const int serial_fd, const uint16_t port)
+{
+	const int listen_fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	const int reuse = 1;
+	struct sockaddr_in addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_ANY);
+	addr.sin_port = htons(port);
+	if (listen_fd < 0 || setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) < 0 ||
+		bind(listen_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(listen_fd, 8) < 0)
+	{
+		RTNO_ERROR(logger_, "relay_t::add() can not listen on port {} ({})", port, strerror(errno));
+		if (listen_fd >= 0)
+		{
+			::close(listen_fd);
+		}
+		return RESULT::ERR;
+	}
+	fcntl(serial_fd, F_SETFL, fcntl(serial_fd, F_GETFL, 0) | O_NONBLOCK);
+
+	pairs_.emplace_back(new pair_t(pairs_.size(), port, serial_fd, listen_fd));
+	pair_t &pair = *pairs_.back();
+	auto listen_event = make_event(EPOLLIN, tag_of(pair.index, KIND_LISTEN));
+	epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, listen_fd, &listen_event);
+	pair.serial_events = EPOLLIN;
+	auto serial_event = make_event(pair.serial_events, tag_of(pair.index, KIND_SERIAL));
+	epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, serial_fd, &serial_event);
+	RTNO_INFO(logger_, "relay_t::add() serial fd {} on port {}", serial_fd, port);
+	return RESULT::OK;
+}
+
+void relay_t::stop()
+{
+	const uint64_t one = 1;
+	// Only write() here: stop() may run in a signal handler.
+	if (::write(stop_fd_, &one, sizeof(one)) < 0)
+	{
+	}
+}
+
+RESULT relay_t::run()
+{
+	epoll_event events[64];
+	while (true)
+	{
+		const int n = epoll_wait(epoll_fd_, events, 64, timeout_msec());
+		statistics_.wakeups++;
+		if (n < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+			RTNO_ERROR(logger_, "relay_t::run() epoll_wait failed ({})", strerror(errno));
+			return RESULT::ERR;
+		}
+		for (int i = 0; i < n; i++)
+		{
+			const uint64_t tag = events[i].data.u64;
+			if (tag == STOP_TAG)
+			{
+				uint64_t count;
+				if (::read(stop_fd_, &count, sizeof(count)) < 0)
+				{
+				}
+				return RESULT::OK;
+			}
+			const uint32_t ready = events[i].events;
+			switch (tag & 3)
+			{
+			case KIND_LISTEN:
+				accept_client(*pairs_[tag >> 2]);
+				break;
+			case KIND_SERIAL:
+			{
+				pair_t &pair = *pairs_[tag >> 2];
+				if (pair.serial_fd >= 0 && (ready & (EPOLLIN | EPOLLERR | EPOLLHUP)))
+				{
+					receive_serial(pair);
+				}
+				if (pair.serial_fd >= 0 && (ready & EPOLLOUT))
+				{
+					send_serial(pair);
+				}
+				break;
+			}
+			case KIND_CLIENT:
+			{
+				// A client dropped earlier in this batch keeps its slot until reap_clients().
+				client_t *client = clients_[tag >> 2].get();
+				if (client && client->fd >= 0 && (ready & (EPOLLIN | EPOLLERR | EPOLLHUP | EPOLLRDHUP)))
+				{
+					receive_client(*client);
+				}
+				if (client && client->fd >= 0 && (ready & EPOLLOUT))
+				{
+					send_client(*client);
+				}
+				break;
+			}
+			}
+		}
+		expire_transactions();
+		reap_clients();
+		for (auto &pair : pairs_)
+		{
+			update_interest(*pair);
+		}
+		if (std::all_of(pairs_.begin(), pairs_.end(), [](auto &pair)
+						{ return pair->serial_fd < 0; }))
+		{
+			RTNO_ERROR(logger_, "relay_t::run() no serial device left");
+			return RESULT::ERR;
+		}
+	}
+}
+
+void relay_t::accept_client(pair_t &pair)
+{
+	int fd;
+	while ((fd = accept4(pair.listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0)
+	{
+		if (pair.clients.size() >= MAX_CLIENTS || pair.serial_fd < 0)
+		{
+			RTNO_WARN(logger_, "relay_t: port {} refused a client ({})", pair.port, pair.serial_fd < 0 ? "serial device failed" : "too many clients");
+			statistics_.refused++;
+			::close(fd);
+			continue;
+		}
+		// Replies are sent in whole frames, so Nagle would only add a delayed-ACK stall.
+		set_tcp_option(fd, TCP_NODELAY, 1);
+		set_tcp_option(fd, TCP_QUICKACK, 1);
+		size_t slot = std::find(clients_.begin(), clients_.end(), nullptr) - clients_.begin();
+		if (slot == clients_.size())
+		{
+			clients_.emplace_back();
+		}
+		clients_[slot].reset(new client_t(slot, pair, fd));
+		pair.clients.push_back(clients_[slot].get());
+		auto event = make_event(0, tag_of(slot, KIND_CLIENT));
+		epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event);
+		statistics_.clients++;
+		RTNO_INFO(logger_, "relay_t: port {} connected ({} clients)", pair.port, pair.clients.size());
+	}
+}
+
+void relay_t::drop_client(client_t &client, const char *reason)
+{
+	RTNO_INFO(logger_, "relay_t: port {} disconnected ({})", client.pair.port, reason);
+	epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, client.fd, NULL);
+	::close(client.fd);
+	client.fd = -1;
+	// The transaction stays on the wire; its replies now go nowhere. pair.joined and pair.clients may be
+	// iterated right now (deliver() drops clients), so the client leaves them in reap_clients().
+	if (client.pair.owner == &client)
+	{
+		client.pair.owner = NULL;
+	}
+}
+
+void relay_t::reap_clients()
+{
+	for (auto &pair : pairs_)
+	{
+		pair->joined.erase(std::remove_if(pair->joined.begin(), pair->joined.end(), [](const pair_t::recipient_t &r)
+										  { return r.client->fd < 0; }),
+						   pair->joined.end());
+		pair->clients.erase(std::remove_if(pair->clients.begin(), pair->clients.end(), [](client_t *client)
+										   { return client->fd < 0; }),
+							pair->clients.end());
+	}
+	for (auto &client : clients_)
+	{
+		if (client && client->fd < 0)
+		{
+			client.reset();
+		}
+	}
+}
+
+void relay_t::close_pair(pair_t &pair, const char *reason)
+{
+	RTNO_ERROR(logger_, "relay_t: serial device of port {} failed ({})", pair.port, reason);
+	for (client_t *client : pair.clients)
+	{
+		if (client->fd >= 0)
+		{
+			drop_client(*client, "serial device failed");
+		}
+	}
+	epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, pair.serial_fd, NULL);
+	pair.serial_fd = -1;
+	pair.serial_events = 0;
+	pair.active = false;
+	pair.requests.clear();
+}
+
+void relay_t::receive_serial(pair_t &pair)
+{
+	while (pair.serial_fd >= 0)
+	{
+		size_t room;
+		uint8_t *dst = pair.replies.prepare(room);
+		if (room == 0)
+		{
+			pair.replies.clear(); // garbage longer than any frame
+			continue;
+		}
+		const ssize_t n = ::read(pair.serial_fd, dst, room);
+		if (n <= 0)
+		{
+			if (n == 0 || (errno != EAGAIN && errno != EINTR))
+			{
+				close_pair(pair, n == 0 ? "end of file" : strerror(errno));
+			}
+			break;
+		}
+		pair.replies.commit(n);
+		while (true)
+		{
+			auto reply = pair.replies.decode();
+			if (reply.error() == RESULT::NOT_AVAILABLE)
+			{
+				break;
+			}
+			if (reply)
+			{
+				on_reply(pair, *reply, pair.replies.framing(), pair.replies.frame_id());
+			}
+			else
+			{
+				statistics_.discarded++;
+			}
+		}
+	}
+	// Frames of one read go out together.
+	for (client_t *client : pair.clients)
+	{
+		if (client->fd >= 0 && client->to_client.getSize() > 0)
+		{
+			send_client(*client);
+		}
+	}
+}
+
+void relay_t::receive_client(client_t &client)
+{
+	while (client.fd >= 0 && client.queue.size() < MAX_QUEUED)
+	{
+		size_t room;
+		uint8_t *dst = client.requests.prepare(room);
+		if (room == 0)
+		{
+			client.requests.clear();
+			continue;
+		}
+		const ssize_t n = recv(client.fd, dst, room, MSG_DONTWAIT);
+		if (n <= 0)
+		{
+			if (n == 0 || (errno != EAGAIN && errno != EINTR))
+			{
+				drop_client(client, n == 0 ? "closed by peer" : strerror(errno));
+			}
+			break;
+		}
+		client.requests.commit(n);
+		// Linux leaves quick-ack mode by itself; re-arm it for the next request.
+		set_tcp_option(client.fd, TCP_QUICKACK, 1);
+		while (true)
+		{
+			auto request = client.requests.decode();
+			if (request.error() == RESULT::NOT_AVAILABLE)
+			{
+				break;
+			}
+			if (request)
+			{
+				on_request(client, *request, client.requests.framing(), client.requests.frame_id());
+			}
+			else
+			{
+				statistics_.discarded++; // the client retries on timeout
+			}
+		}
+	}
+	start_transaction(client.pair);
+}
+
+void relay_t::on_request(client_t &client, const packet_t &request, const FRAMING framing, const uint8_t frame_id)
+{
+	pair_t &pair = client.pair;
+	// Join the identical read-only request on the wire if its reply has not started yet.
+	if (client.queue.empty() && pair.active && !pair.replied && pair.owner != &client && pair.requests.size() == 1 &&
+		is_coalescible(request) && same_request(request, pair.requests[0].packet) &&
+		std::none_of(pair.joined.begin(), pair.joined.end(), [&client](const pair_t::recipient_t &r)
+					 { return r.client == &client; }))
+	{
+		pair.joined.push_back({&client, framing, frame_id});
+		statistics_.coalesced++;
+		return;
+	}
+	client.queue.push_back({request, framing, frame_id});
+}
+
+void relay_t::on_reply(pair_t &pair, const packet_t &reply, const FRAMING framing, const uint8_t frame_id)
+{
+	if (reply.get_command() == COMMAND::HEART_BEAT)
+	{
+		for (client_t *client : pair.clients)
+		{
+			if (client->fd >= 0)
+			{
+				deliver(*client, reply, framing, frame_id);
+			}
+		}
+		return;
+	}
+	if (!pair.active || pair.pending == 0)
+	{
+		statistics_.discarded++; // late reply to an abandoned transaction
+		return;
+	}
+	pair.replied = true;
+	pair.last_nsec = now_nsec();
+	if (pair.owner)
+	{
+		deliver(*pair.owner, reply, framing, frame_id);
+	}
+	for (auto &recipient : pair.joined)
+	{
+		if (recipient.client->fd >= 0)
+		{
+			deliver(*recipient.client, reply, recipient.framing, recipient.frame_id);
+		}
+	}
+	pair.joined.erase(std::remove_if(pair.joined.begin(), pair.joined.end(), [](const pair_t::recipient_t &r)
+									 { return r.client->fd < 0; }),
+					  pair.joined.end());
+	if (is_last_reply(reply) && --pair.pending == 0)
+	{
+		finish_transaction(pair);
+	}
+}
+
+void relay_t::deliver(client_t &client, const packet_t &reply, const FRAMING framing, const uint8_t frame_id)
+{
+	uint8_t frame[FRAME_MAX_SIZE];
+	const size_t size = encode_frame(frame, reply, reply.getSum(), framing, frame_id);
+	if (client.to_client.push(frame, size) < size)
+	{
+		drop_client(client, "replies not read");
+	}
+}
+
+void relay_t::send_client(client_t &client)
+{
+	while (client.fd >= 0 && client.to_client.getSize() > 0)
+	{
+		size_t readable;
+		const uint8_t *src = client.to_client.peek(readable);
+		const ssize_t n = send(client.fd, src, readable, MSG_NOSIGNAL);
+		if (n < 0)
+		{
+			if (errno != EAGAIN && errno != EINTR)
+			{
+				drop_client(client, strerror(errno));
+			}
+			return;
+		}
+		client.to_client.consume(n);
+		statistics_.serial_to_tcp += n;
+	}
+}
+
+void relay_t::send_serial(pair_t &pair)
+{
+	// Frames go into to_serial as it drains, so a long run of fragments needs no more room than BUFFER_SIZE.
+	while (pair.active && pair.written < pair.requests.size() && pair.to_serial.getFreeSize() >= FRAME_MAX_SIZE)
+	{
+		const request_t &request = pair.requests[pair.written++];
+		uint8_t frame[FRAME_MAX_SIZE];
+		pair.to_serial.push(frame, encode_frame(frame, request.packet, request.packet.getSum(), request.framing, request.frame_id));
+	}
+	while (pair.serial_fd >= 0 && pair.to_serial.getSize() > 0)
+	{
+		size_t readable;
+		const uint8_t *src = pair.to_serial.peek(readable);
+		const ssize_t n = ::write(pair.serial_fd, src, readable);
+		if (n < 0)
+		{
+			if (errno != EAGAIN && errno != EINTR)
+			{
+				close_pair(pair, strerror(errno));
+			}
+			return;
+		}
+		pair.to_serial.consume(n);
+		pair.last_nsec = now_nsec();
+		statistics_.tcp_to_serial += n;
+	}
+}
+
+void relay_t::start_transaction(pair_t &pair)
+{
+	if (pair.active || pair.serial_fd < 0 || pair.clients.empty())
+	{
+		return;
+	}
+	// Round robin, so that a busy client can not starve the others.
+	for (size_t k = 0; k < pair.clients.size(); k++)
+	{
+		const size_t index = (pair.next_client + k) % pair.clients.size();
+		client_t &client = *pair.clients[index];
+		const size_t count = client.fd >= 0 ? ready_count(client.queue) : 0;
+		if (count == 0)
+		{
+			continue;
+		}
+		pair.next_client = index + 1;
+		pair.active = true;
+		pair.owner = &client;
+		pair.requests.assign(client.queue.begin(), client.queue.begin() + count);
+		client.queue.erase(client.queue.begin(), client.queue.begin() + count);
+		pair.written = 0;
+		pair.pending = std::count_if(pair.requests.begin(), pair.requests.end(), [](const request_t &r)
+									 { return is_answered(r.packet); });
+		pair.replied = false;
+		pair.joined.clear();
+		pair.last_nsec = now_nsec();
+		if (count == 1 && is_coalescible(pair.requests[0].packet))
+		{
+			for (client_t *other : pair.clients)
+			{
+				if (other != &client && other->fd >= 0 && !other->queue.empty() && same_request(other->queue.front().packet, pair.requests[0].packet))
+				{
+					pair.joined.push_back({other, other->queue.front().framing, other->queue.front().frame_id});
+					other->queue.pop_front();
+					statistics_.coalesced++;
+				}
+			}
+		}
+		statistics_.transactions++;
+		send_serial(pair);
+		return;
+	}
+}
+
+void relay_t::finish_transaction(pair_t &pair)
+{
+	pair.active = false;
+	pair.owner = NULL;
+	pair.requests.clear();
+	pair.joined.clear();
+	pair.pending = 0;
+	start_transaction(pair);
+}
+
+void relay_t::update_interest(pair_t &pair)
+{
+	if (pair.serial_fd >= 0)
+	{
+		// Replies are always read: a client which does not take them is dropped instead of stalling the others.
+		uint32_t events = EPOLLIN;
+		if (pair.to_serial.getSize() > 0 || (pair.active && pair.written < pair.requests.size()))
+		{
+			events |= EPOLLOUT;
+		}
+		update_events(epoll_fd_, pair.serial_fd, tag_of(pair.index, KIND_SERIAL), pair.serial_events, events);
+	}
+	for (client_t *client : pair.clients)
+	{
+		if (client->fd < 0)
+		{
+			continue;
+		}
+		uint32_t events = EPOLLRDHUP;
+		if (client->queue.size() < MAX_QUEUED)
+		{
+			events |= EPOLLIN;
+		}
+		if (client->to_client.getSize() > 0)
+		{
+			events |= EPOLLOUT;
+		}
+		update_events(epoll_fd_, client->fd, tag_of(client->slot, KIND_CLIENT), client->events, events);
+	}
+}
+
+int relay_t::timeout_msec()
+{
+	int64_t earliest = -1;
+	for (auto &pair : pairs_)
+	{
+		if (pair->active && (earliest < 0 || pair->last_nsec < earliest))
+		{
+			earliest = pair->last_nsec;
+		}
+	}
+	if (earliest < 0)
+	{
+		return -1; // nothing on the wire: sleep until a descriptor is ready
+	}
+	const int64_t rest = earliest + (int64_t)timeout_usec_ * 1000 - now_nsec();
+	return rest <= 0 ? 0 : (int)((rest + 999999) / 1000000);
+}
+
+void relay_t::expire_transactions()
+{
+	const int64_t now = now_nsec();
+	for (auto &pair : pairs_)
+	{
+		if (pair->active && now - pair->last_nsec >= (int64_t)timeout_usec_ * 1000)
+		{
+			RTNO_WARN(logger_, "relay_t: port {} abandoned a transaction ({} of {} requests unanswered)", pair->port, pair->pending, pair->requests.size());
+			statistics_.timeouts++;
+			finish_transaction(*pair);
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,135 @@
+#include "rtno2/request.h"
+
+#include <string.h>
+
+using namespace ssr::rtno2;
+
+result_t<packet_t> ssr::rtno2::make_send_data_packet(const std::string &portName, const uint8_t *data, const uint8_t length)
+{
+	packet_t packet(COMMAND::SEND_DATA, RESULT::OK);
+	uint8_t *dst = prepare_send_data_packet(packet, portName, length);
+	if (dst == NULL)
+	{
+		return RESULT::ERR;
+	}
+	memcpy(dst, data, length);
+	return packet;
+}
+
+uint8_t *ssr::rtno2::prepare_send_data_packet(packet_t &packet, const std::string &portName, const uint8_t length)
+{
+	auto namelen = portName.length();
+	if (2 + namelen + length > PACKET_MAX_DATA_SIZE)
+	{
+		return NULL;
+	}
+	uint8_t *buffer = packet.getWritableData();
+	buffer[0] = static_cast<uint8_t>(namelen);
+	buffer[1] = length;
+	memcpy(buffer + 2, portName.c_str(), namelen);
+	packet.setDataLength(static_cast<uint8_t>(2 + namelen + length));
+	return buffer + 2 + namelen;
+}
+
+result_t<packet_t> ssr::rtno2::make_receive_data_packet(const std::string &portName)
+{
+	packet_t packet(COMMAND::RECEIVE_DATA, RESULT::OK);
+	if (prepare_send_data_packet(packet, portName, 0) == NULL)
+	{
+		return RESULT::ERR;
+	}
+	return packet;
+}
+
+uint8_t *ssr::rtno2::prepare_fragment_packet(packet_t &packet, const std::string &portName, const uint8_t index, const uint8_t count, const uint8_t length)
+{
+	auto namelen = portName.length();
+	if (FRAGMENT_HEADER_SIZE + namelen + length > PACKET_MAX_DATA_SIZE)
+	{
+		return NULL;
+	}
+	uint8_t *buffer = packet.getWritableData();
+	buffer[0] = static_cast<uint8_t>(namelen);
+	buffer[1] = length;
+	memcpy(buffer + 2, portName.c_str(), namelen);
+	buffer[2 + namelen] = index;
+	buffer[3 + namelen] = count;
+	packet.setDataLength(static_cast<uint8_t>(FRAGMENT_HEADER_SIZE + namelen + length));
+	return buffer + FRAGMENT_HEADER_SIZE + namelen;
+}
+
+RESULT ssr::rtno2::view_fragment(const packet_t &packet, const uint8_t **data, uint8_t *size, uint8_t *index, uint8_t *count)
+{
+	if (packet.getDataLength() < FRAGMENT_HEADER_SIZE)
+	{
+		return packet.get_result() != RESULT::OK ? packet.get_result() : RESULT::ERR;
+	}
+	const uint8_t name_len = packet.getData()[0];
+	const uint8_t data_len = packet.getData()[1];
+	if (FRAGMENT_HEADER_SIZE + name_len + data_len > packet.getDataLength())
+	{
+		return RESULT::ERR;
+	}
+	*index = packet.getData()[2 + name_len];
+	*count = packet.getData()[3 + name_len];
+	if (*index >= *count)
+	{
+		return RESULT::ERR;
+	}
+	*data = packet.getData() + FRAGMENT_HEADER_SIZE + name_len;
+	*size = data_len;
+	return packet.get_result();
+}
+
+RESULT ssr::rtno2::view_receive_data_reply(const packet_t &packet, const uint8_t **data, uint8_t *size)
+{
+	if (packet.getDataLength() < 2)
+	{
+		return packet.get_result() != RESULT::OK ? packet.get_result() : RESULT::ERR;
+	}
+	const uint8_t name_len = packet.getData()[0];
+	const uint8_t data_len = packet.getData()[1];
+	if (2 + name_len + data_len > packet.getDataLength())
+	{
+		return RESULT::ERR;
+	}
+	*data = packet.getData() + 2 + name_len;
+	*size = data_len;
+	return packet.get_result();
+}
+
+RESULT ssr::rtno2::parse_receive_data_reply(const packet_t &packet, uint8_t *data, const uint8_t max_size, uint8_t *size_read, std::string *name)
+{
+	const uint8_t *value = NULL;
+	uint8_t data_len = 0;
+	const RESULT result = view_receive_data_reply(packet, &value, &data_len);
+	if (value == NULL)
+	{
+		return result;
+	}
+	*size_read = data_len;
+	if (data_len > max_size)
+	{
+		return RESULT::ERR;
+	}
+	if (name)
+	{
+		name->assign((const char *)packet.getData() + 2, packet.getData()[0]);
+	}
+	memcpy(data, value, data_len);
+	return result;
+}
+
+bool ssr::rtno2::reply_matches_port(const packet_t &packet, const std::string &portName)
+{
+	if ((packet.get_command() != COMMAND::RECEIVE_DATA && packet.get_command() != COMMAND::RECEIVE_DATA_FRAGMENT) || packet.getDataLength() < 2)
+	{
+		return true;
+	}
+	const uint8_t name_len = packet.getData()[0];
+	if (2 + name_len > packet.getDataLength())
+	{
+		return false;
+	}
+	return portName.length() == name_len && memcmp(portName.c_str(), packet.getData() + 2, name_len) == 0;
+}
@@ -0,0 +1,729 @@
+#include "rtno2/simulator.h"
+#include "rtno2/cycle.h"
+
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+
+#ifndef WIN32
+#include <pty.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+#endif
+
+using namespace ssr::rtno2;
+
+static int64_t now_nsec()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+simulator_t::simulator_t(const Architecture architecture, const uint8_t supported_capabilities)
+	: reply_framing_(FRAMING::V1), reply_frame_id_(0), reply_ready_nsec_(0), busy_until_nsec_(0), next_heartbeat_nsec_(0),
+	  state_(STATE::INACTIVE), ec_type_(EC_TYPE::PROXY_SYNCHRONOUS), processing_delay_usec_(0), heartbeat_interval_usec_(0),
+	  architecture_(architecture), supported_capabilities_(supported_capabilities), capabilities_(0), bytes_received_(0), bytes_sent_(0)
+{
+}
+
+void simulator_t::add_inport(const TYPECODE typecode, const std::string &name)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	inports_.push_back(port_t{typecode, name, false, {}, {}, 0, std::nullopt});
+}
+
+void simulator_t::add_outport(const TYPECODE typecode, const std::string &name)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	outports_.push_back(port_t{typecode, name, false, {}, {}, 0, std::nullopt});
+}
+
+void simulator_t::add_outport(const TYPECODE typecode, const std::string &name, const std::vector<uint8_t> &initial_value)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	outports_.push_back(port_t{typecode, name, true, initial_value, {}, 0, initial_value});
+}
+
+void simulator_t::set_ec_type(const EC_TYPE ec_type)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	ec_type_ = ec_type;
+}
+
+void simulator_t::set_processing_delay(const uint32_t usec)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	processing_delay_usec_ = usec;
+}
+
+void simulator_t::set_heartbeat_interval(const uint32_t usec)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	heartbeat_interval_usec_ = usec;
+	next_heartbeat_nsec_ = now_nsec() + (int64_t)usec * 1000;
+	cond_.notify_all();
+}
+
+void simulator_t::log(const std::string &message)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	log_ += message;
+}
+
+STATE simulator_t::state()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return state_;
+}
+
+bool simulator_t::connect(const std::string &inport, const std::string &outport)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	auto in = find(inports_, (const uint8_t *)inport.c_str(), static_cast<uint8_t>(inport.length()));
+	auto out = find(outports_, (const uint8_t *)outport.c_str(), static_cast<uint8_t>(outport.length()));
+	if (in == NULL || out == NULL || in->typecode != out->typecode)
+	{
+		return false;
+	}
+	connections_.emplace_back(in - inports_.data(), out - outports_.data());
+	return true;
+}
+
+void simulator_t::flushRxBuffer()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	rx_.clear();
+}
+
+ssr::RETVAL simulator_t::getSizeInRxBuffer()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	release_due();
+	return static_cast<ssr::RETVAL>(rx_.size());
+}
+
+ssr::RETVAL simulator_t::write(const uint8_t *src, const uint8_t size)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	bytes_received_ += size;
+	size_t writable;
+	memcpy(requests_.prepare(writable), src, size);
+	requests_.commit(size);
+	const int64_t now = processing_delay_usec_ > 0 ? now_nsec() : 0;
+	while (true)
+	{
+		auto request = requests_.decode();
+		if (request.error() == RESULT::NOT_AVAILABLE)
+		{
+			break;
+		}
+		reply_framing_ = requests_.framing();
+		reply_frame_id_ = requests_.frame_id();
+		if (processing_delay_usec_ > 0)
+		{
+			busy_until_nsec_ = reply_ready_nsec_ = std::max(now, busy_until_nsec_) + (int64_t)processing_delay_usec_ * 1000;
+		}
+		else
+		{
+			reply_ready_nsec_ = 0;
+		}
+		if (request.error() == RESULT::CHECKSUM_ERROR)
+		{
+			reply(packet_t(COMMAND::PACKET_ERROR_CHECKSUM, RESULT::CHECKSUM_ERROR));
+			continue;
+		}
+		handle(*request);
+	}
+	cond_.notify_all();
+	return size;
+}
+
+ssr::RETVAL simulator_t::read(uint8_t *dst, const uint8_t size)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	release_due();
+	const size_t n = std::min<size_t>(size, rx_.size());
+	memcpy(dst, rx_.data(), n);
+	rx_.erase(rx_.begin(), rx_.begin() + n);
+	return static_cast<ssr::RETVAL>(n);
+}
+
+ssr::RETVAL simulator_t::waitRxReady(const uint32_t timeout_usec)
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	release_due();
+	if (!rx_.empty())
+	{
+		return 1;
+	}
+	const int64_t deadline = now_nsec() + (int64_t)timeout_usec * 1000;
+	while (true)
+	{
+		const int64_t now = now_nsec();
+		release(now);
+		if (!rx_.empty())
+		{
+			return 1;
+		}
+		if (now >= deadline)
+		{
+			return 0;
+		}
+		// Wake up for the next delayed reply or heartbeat, whichever comes first.
+		int64_t wake = deadline;
+		if (!delayed_.empty())
+		{
+			wake = std::min(wake, delayed_.front().first);
+		}
+		if (heartbeat_interval_usec_ > 0)
+		{
+			wake = std::min(wake, next_heartbeat_nsec_);
+		}
+		cond_.wait_for(lock, std::chrono::nanoseconds(std::max<int64_t>(wake - now, 0)));
+	}
+}
+
+void simulator_t::release_due()
+{
+	// Without delayed replies and heartbeats, nothing waits for its time (and the clock is not read).
+	if (!delayed_.empty() || heartbeat_interval_usec_ > 0)
+	{
+		release(now_nsec());
+	}
+}
+
+void simulator_t::release(const int64_t now)
+{
+	while (!delayed_.empty() && delayed_.front().first <= now)
+	{
+		rx_.insert(rx_.end(), delayed_.front().second.begin(), delayed_.front().second.end());
+		delayed_.pop_front();
+	}
+	if (heartbeat_interval_usec_ > 0 && now >= next_heartbeat_nsec_)
+	{
+		// One heartbeat however long nobody read, as the firmware's is sent from its loop.
+		uint8_t frame[FRAME_MAX_SIZE];
+		const packet_t heartbeat(COMMAND::HEART_BEAT, RESULT::OK);
+		const size_t size = encode_frame(frame, heartbeat, heartbeat.getSum(), reply_framing_, 0);
+		rx_.insert(rx_.end(), frame, frame + size);
+		bytes_sent_ += size;
+		next_heartbeat_nsec_ = now + (int64_t)heartbeat_interval_usec_ * 1000;
+	}
+}
+
+void simulator_t::handle(const packet_t &request)
+{
+	switch (request.get_command())
+	{
+	case COMMAND::GET_PROFILE:
+	{
+		capabilities_ = request.getDataLength() >= 1 ? (request.getData()[0] & supported_capabilities_) : 0;
+		const uint8_t platform[2] = {(uint8_t)architecture_, capabilities_};
+		// Firmware without extensions sends the architecture only.
+		reply(packet_t(COMMAND::PLATFORM_PROFILE, RESULT::OK, platform, supported_capabilities_ != 0 ? 2 : 1));
+		for (auto ports : {std::make_pair(COMMAND::INPORT_PROFILE, &inports_), std::make_pair(COMMAND::OUTPORT_PROFILE, &outports_)})
+		{
+			for (auto &port : *ports.second)
+			{
+				uint8_t data[PACKET_MAX_DATA_SIZE];
+				data[0] = (uint8_t)port.typecode;
+				memcpy(data + 1, port.name.c_str(), port.name.length());
+				reply(packet_t(ports.first, RESULT::OK, data, static_cast<uint8_t>(1 + port.name.length())));
+			}
+		}
+		reply(packet_t(COMMAND::GET_PROFILE, RESULT::OK));
+		break;
+	}
+	case COMMAND::SEND_DATA:
+		handle_send_data(request);
+		break;
+	case COMMAND::RECEIVE_DATA:
+		handle_receive_data(request);
+		break;
+	case COMMAND::SEND_DATA_FRAGMENT:
+	case COMMAND::RECEIVE_DATA_FRAGMENT:
+		if ((capabilities_ & CAPABILITY_FRAGMENTED_DATA) == 0)
+		{
+			// Unknown to firmware without the extension.
+			reply(packet_t(COMMAND::PACKET_ERROR, RESULT::ERR));
+		}
+		else if (request.get_command() == COMMAND::SEND_DATA_FRAGMENT)
+		{
+			handle_send_data_fragment(request);
+		}
+		else
+		{
+			handle_receive_data_fragment(request);
+		}
+		break;
+	case COMMAND::BATCH_CYCLE:
+		if ((capabilities_ & CAPABILITY_BATCH_CYCLE) == 0)
+		{
+			reply(packet_t(COMMAND::PACKET_ERROR, RESULT::ERR));
+		}
+		else
+		{
+			handle_batch_cycle(request);
+		}
+		break;
+	case COMMAND::EXECUTE:
+		reply(packet_t(COMMAND::EXECUTE, execute()));
+		break;
+	case COMMAND::INITIALIZE:
+	case COMMAND::ACTIVATE:
+	case COMMAND::DEACTIVATE:
+	case COMMAND::ONERROR:
+	case COMMAND::RESET:
+		handle_state(request);
+		break;
+	case COMMAND::GET_STATE:
+	{
+		const uint8_t state = (uint8_t)state_;
+		reply(packet_t(COMMAND::GET_STATE, RESULT::OK, &state, 1));
+		break;
+	}
+	case COMMAND::GET_CONTEXT_TYPE:
+	{
+		const uint8_t ec_type = (uint8_t)ec_type_;
+		reply(packet_t(COMMAND::GET_CONTEXT_TYPE, RESULT::OK, &ec_type, 1));
+		break;
+	}
+	case COMMAND::RECEIVE_LOG:
+	{
+		const size_t size = std::min<size_t>(log_.size(), PACKET_MAX_DATA_SIZE);
+		reply(packet_t(COMMAND::RECEIVE_LOG, RESULT::OK, (const uint8_t *)log_.data(), static_cast<uint8_t>(size)));
+		log_.erase(0, size);
+		break;
+	}
+	default:
+		// Replies (profiles, PACKET_ERROR*, HEART_BEAT) and unknown commands are not requests.
+		reply(packet_t(COMMAND::PACKET_ERROR, RESULT::ERR));
+		break;
+	}
+}
+
+void simulator_t::handle_send_data(const packet_t &request)
+{
+	const uint8_t *data = request.getData();
+	if (request.getDataLength() < 2 || 2 + data[0] + data[1] > request.getDataLength())
+	{
+		reply(packet_t(COMMAND::PACKET_ERROR, RESULT::ERR));
+		return;
+	}
+	auto port = find(inports_, data + 2, data[0]);
+	if (port == NULL)
+	{
+		reply(packet_t(COMMAND::SEND_DATA, RESULT::INPORT_NOT_FOUND));
+		return;
+	}
+	reply(packet_t(COMMAND::SEND_DATA, store(*port, data + 2 + data[0], data[1]) ? RESULT::OK : RESULT::ERR));
+}
+
+void simulator_t::handle_receive_data(const packet_t &request)
+{
+	const uint8_t *data = request.getData();
+	if (request.getDataLength() < 2 || 2 + data[0] > request.getDataLength())
+	{
+		reply(packet_t(COMMAND::PACKET_ERROR, RESULT::ERR));
+		return;
+	}
+	const uint8_t name_len = data[0];
+	uint8_t buffer[PACKET_MAX_DATA_SIZE];
+	buffer[0] = name_len;
+	buffer[1] = 0;
+	memcpy(buffer + 2, data + 2, name_len);
+	auto port = find(outports_, data + 2, name_len);
+	if (port == NULL)
+	{
+		reply(packet_t(COMMAND::RECEIVE_DATA, RESULT::OUTPORT_NOT_FOUND, buffer, 2 + name_len));
+		return;
+	}
+	if (!port->written)
+	{
+		reply(packet_t(COMMAND::RECEIVE_DATA, RESULT::OUTPORT_BUFFER_EMPTY, buffer, 2 + name_len));
+		return;
+	}
+	load(*port, payload_);
+	if (2 + name_len + payload_.size() > PACKET_MAX_DATA_SIZE)
+	{
+		// Only RECEIVE_DATA_FRAGMENT can carry this value.
+		reply(packet_t(COMMAND::RECEIVE_DATA, RESULT::ERR, buffer, 2 + name_len));
+		return;
+	}
+	memcpy(buffer + 2 + name_len, payload_.data(), payload_.size());
+	buffer[1] = static_cast<uint8_t>(payload_.size());
+	reply(packet_t(COMMAND::RECEIVE_DATA, RESULT::OK, buffer, static_cast<uint8_t>(2 + name_len + payload_.size())));
+}
+
+void simulator_t::handle_send_data_fragment(const packet_t &request)
+{
+	// name_len | data_len | name | index | count | data
+	const uint8_t *data = request.getData();
+	if (request.getDataLength() < 4 || 4 + data[0] + data[1] > request.getDataLength())
+	{
+		reply(packet_t(COMMAND::PACKET_ERROR, RESULT::ERR));
+		return;
+	}
+	const uint8_t name_len = data[0];
+	const uint8_t index = data[2 + name_len];
+	const uint8_t count = data[3 + name_len];
+	auto port = find(inports_, data + 2, name_len);
+	if (port == NULL)
+	{
+		// Answered once per value, like SEND_DATA.
+		if (index + 1 == count)
+		{
+			reply(packet_t(COMMAND::SEND_DATA, RESULT::INPORT_NOT_FOUND));
+		}
+		return;
+	}
+	if (index == 0)
+	{
+		port->fragments.clear();
+		port->next_fragment = 0;
+	}
+	if (index == port->next_fragment)
+	{
+		port->fragments.insert(port->fragments.end(), data + 4 + name_len, data + 4 + name_len + data[1]);
+		port->next_fragment++;
+	}
+	else
+	{
+		port->next_fragment = SIZE_MAX; // broken until the next fragment 0
+	}
+	if (index + 1 != count)
+	{
+		return;
+	}
+	const bool complete = port->next_fragment == count && store(*port, port->fragments.data(), port->fragments.size());
+	port->next_fragment = SIZE_MAX;
+	reply(packet_t(COMMAND::SEND_DATA, complete ? RESULT::OK : RESULT::ERR));
+}
+
+void simulator_t::handle_receive_data_fragment(const packet_t &request)
+{
+	const uint8_t *data = request.getData();
+	if (request.getDataLength() < 2 || 2 + data[0] > request.getDataLength())
+	{
+		reply(packet_t(COMMAND::PACKET_ERROR, RESULT::ERR));
+		return;
+	}
+	const uint8_t name_len = data[0];
+	uint8_t buffer[PACKET_MAX_DATA_SIZE];
+	buffer[0] = name_len;
+	buffer[1] = 0;
+	memcpy(buffer + 2, data + 2, name_len);
+	buffer[2 + name_len] = 0;
+	buffer[3 + name_len] = 1;
+	auto port = find(outports_, data + 2, name_len);
+	if (port == NULL || !port->written)
+	{
+		reply(packet_t(COMMAND::RECEIVE_DATA_FRAGMENT, port == NULL ? RESULT::OUTPORT_NOT_FOUND : RESULT::OUTPORT_BUFFER_EMPTY, buffer, 4 + name_len));
+		return;
+	}
+	load(*port, payload_);
+	const size_t capacity = PACKET_MAX_DATA_SIZE - 4 - name_len;
+	const size_t count = std::max<size_t>(1, (payload_.size() + capacity - 1) / capacity);
+	if (count > 255)
+	{
+		reply(packet_t(COMMAND::RECEIVE_DATA_FRAGMENT, RESULT::ERR, buffer, 4 + name_len));
+		return;
+	}
+	for (size_t i = 0, offset = 0; i < count; i++, offset += capacity)
+	{
+		const size_t size = std::min(capacity, payload_.size() - offset);
+		buffer[1] = static_cast<uint8_t>(size);
+		buffer[2 + name_len] = static_cast<uint8_t>(i);
+		buffer[3 + name_len] = static_cast<uint8_t>(count);
+		memcpy(buffer + 4 + name_len, payload_.data() + offset, size);
+		reply(packet_t(COMMAND::RECEIVE_DATA_FRAGMENT, RESULT::OK, buffer, static_cast<uint8_t>(4 + name_len + size)));
+	}
+}
+
+void simulator_t::handle_batch_cycle(const packet_t &request)
+{
+	// flags | write_count | { inport_id | data_len | data }* | read_count | { outport_id }*
+	const uint8_t *src = request.getData();
+	const uint8_t *end = src + request.getDataLength();
+	uint8_t buffer[PACKET_MAX_DATA_SIZE];
+	size_t size = 0;
+	if (end - src < 2)
+	{
+		reply(packet_t(COMMAND::BATCH_CYCLE, RESULT::ERR));
+		return;
+	}
+	const uint8_t flags = *src++;
+	const uint8_t write_count = *src++;
+	buffer[size++] = write_count;
+	for (uint8_t i = 0; i < write_count; i++)
+	{
+		if (end - src < 2 || end - src < 2 + src[1])
+		{
+			reply(packet_t(COMMAND::BATCH_CYCLE, RESULT::ERR));
+			return;
+		}
+		RESULT result = RESULT::INPORT_NOT_FOUND;
+		if (src[0] < inports_.size())
+		{
+			result = store(inports_[src[0]], src + 2, src[1]) ? RESULT::OK : RESULT::ERR;
+		}
+		buffer[size++] = (uint8_t)result;
+		src += 2 + src[1];
+	}
+	buffer[size++] = (uint8_t)((flags & BATCH_EXECUTE) ? execute() : RESULT::NONE);
+	if (end - src < 1 || end - src < 1 + src[0])
+	{
+		reply(packet_t(COMMAND::BATCH_CYCLE, RESULT::ERR));
+		return;
+	}
+	const uint8_t read_count = *src++;
+	if (size + 1 + 3 * (size_t)read_count > PACKET_MAX_DATA_SIZE)
+	{
+		reply(packet_t(COMMAND::BATCH_CYCLE, RESULT::ERR));
+		return;
+	}
+	buffer[size++] = read_count;
+	for (uint8_t i = 0; i < read_count; i++)
+	{
+		const uint8_t id = src[i];
+		RESULT result = RESULT::OUTPORT_NOT_FOUND;
+		payload_.clear();
+		if (id < outports_.size())
+		{
+			result = RESULT::OUTPORT_BUFFER_EMPTY;
+			if (outports_[id].written)
+			{
+				load(outports_[id], payload_);
+				// The headers of the remaining reads must still fit.
+				result = size + 3 + payload_.size() + 3 * (size_t)(read_count - i - 1) <= PACKET_MAX_DATA_SIZE ? RESULT::OK : RESULT::NONE;
+			}
+		}
+		if (result != RESULT::OK)
+		{
+			payload_.clear();
+		}
+		buffer[size++] = id;
+		buffer[size++] = (uint8_t)result;
+		buffer[size++] = static_cast<uint8_t>(payload_.size());
+		memcpy(buffer + size, payload_.data(), payload_.size());
+		size += payload_.size();
+	}
+	reply(packet_t(COMMAND::BATCH_CYCLE, RESULT::OK, buffer, static_cast<uint8_t>(size)));
+}
+
+void simulator_t::handle_state(const packet_t &request)
+{
+	// The RTC state machine: INITIALIZE from any state, ACTIVATE / DEACTIVATE between INACTIVE and ACTIVE,
+	// ONERROR from ACTIVE, RESET from ERR.
+	RESULT result = RESULT::OK;
+	switch (request.get_command())
+	{
+	case COMMAND::INITIALIZE:
+		for (auto &port : inports_)
+		{
+			port.written = false;
+			port.value.clear();
+		}
+		for (auto &port : outports_)
+		{
+			port.written = port.initial.has_value();
+			port.value = port.initial.value_or(std::vector<uint8_t>());
+		}
+		state_ = STATE::INACTIVE;
+		break;
+	case COMMAND::ACTIVATE:
+		if (state_ == STATE::INACTIVE)
+		{
+			activate();
+			state_ = STATE::ACTIVE;
+		}
+		else
+		{
+			result = RESULT::INVALID_PRESTATE;
+		}
+		break;
+	case COMMAND::DEACTIVATE:
+		result = state_ == STATE::ACTIVE ? RESULT::OK : RESULT::INVALID_PRESTATE;
+		state_ = state_ == STATE::ACTIVE ? STATE::INACTIVE : state_;
+		break;
+	case COMMAND::ONERROR:
+		result = state_ == STATE::ACTIVE ? RESULT::OK : RESULT::INVALID_PRESTATE;
+		state_ = state_ == STATE::ACTIVE ? STATE::ERR : state_;
+		break;
+	default: // RESET
+		result = state_ == STATE::ERR ? RESULT::OK : RESULT::INVALID_PRESTATE;
+		state_ = state_ == STATE::ERR ? STATE::INACTIVE : state_;
+		break;
+	}
+	reply(packet_t(request.get_command(), result));
+}
+
+void simulator_t::activate()
+{
+	// Data received before activation is not new to the first EXECUTE.
+	for (auto &port : inports_)
+	{
+		port.written = false;
+	}
+	for (auto &port : outports_)
+	{
+		if (port.initial)
+		{
+			port.value = *port.initial;
+			port.written = true;
+		}
+	}
+}
+
+RESULT simulator_t::execute()
+{
+	if (state_ != STATE::ACTIVE)
+	{
+		return RESULT::INVALID_PRESTATE;
+	}
+	// An inport is copied once per value written to it, like an RTC checking isNew() in onExecute.
+	for (auto &connection : connections_)
+	{
+		auto &in = inports_[connection.first];
+		auto &out = outports_[connection.second];
+		if (in.written)
+		{
+			out.value = in.value;
+			out.written = true;
+		}
+	}
+	for (auto &connection : connections_)
+	{
+		inports_[connection.first].written = false;
+	}
+	return RESULT::OK;
+}
+
+bool simulator_t::store(port_t &port, const uint8_t *value, const size_t size)
+{
+	if (port.typecode == TYPECODE::TIMED_BOOLEAN_SEQ && (capabilities_ & CAPABILITY_PACKED_BOOLEAN_SEQ))
+	{
+		// count | bits, LSB first
+		if (size < 1 || size != 1 + (size_t)(value[0] + 7) / 8)
+		{
+			return false;
+		}
+		port.value.resize(value[0]);
+		for (size_t i = 0; i < port.value.size(); i++)
+		{
+			port.value[i] = (value[1 + i / 8] >> (i % 8)) & 1;
+		}
+	}
+	else
+	{
+		port.value.assign(value, value + size);
+	}
+	port.written = true;
+	return true;
+}
+
+void simulator_t::load(const port_t &port, std::vector<uint8_t> &payload)
+{
+	if (port.typecode == TYPECODE::TIMED_BOOLEAN_SEQ && (capabilities_ & CAPABILITY_PACKED_BOOLEAN_SEQ))
+	{
+		payload.assign(1 + (port.value.size() + 7) / 8, 0);
+		payload[0] = static_cast<uint8_t>(port.value.size());
+		for (size_t i = 0; i < port.value.size(); i++)
+		{
+			payload[1 + i / 8] |= (port.value[i] ? 1 : 0) << (i % 8);
+		}
+		return;
+	}
+	payload.assign(port.value.begin(), port.value.end());
+}
+
+void simulator_t::reply(const packet_t &packet)
+{
+	uint8_t frame[FRAME_MAX_SIZE];
+	const size_t size = encode_frame(frame, packet, packet.getSum(), reply_framing_, reply_frame_id_);
+	if (reply_ready_nsec_ == 0 && delayed_.empty())
+	{
+		rx_.insert(rx_.end(), frame, frame + size);
+	}
+	else
+	{
+		delayed_.emplace_back(reply_ready_nsec_, std::vector<uint8_t>(frame, frame + size));
+	}
+	bytes_sent_ += size;
+}
+
+simulator_t::port_t *simulator_t::find(std::vector<port_t> &ports, const uint8_t *name, const uint8_t name_len)
+{
+	for (auto &port : ports)
+	{
+		if (port.name.length() == name_len && memcmp(port.name.c_str(), name, name_len) == 0)
+		{
+			return &port;
+		}
+	}
+	return NULL;
+}
+
+#ifndef WIN32
+RESULT simulator_pty_t::open()
+{
+	char name[256];
+	if (master_ >= 0 || ::openpty(&master_, &slave_, name, NULL, NULL) < 0)
+	{
+		return RESULT::ERR;
+	}
+	struct termios tio;
+	tcgetattr(slave_, &tio);
+	cfmakeraw(&tio);
+	tcsetattr(slave_, TCSANOW, &tio);
+	name_ = name;
+	running_ = true;
+	thread_ = std::thread([this]()
+						  { serve(); });
+	return RESULT::OK;
+}
+
+void simulator_pty_t::close()
+{
+	running_ = false;
+	if (thread_.joinable())
+	{
+		thread_.join();
+	}
+	if (master_ >= 0)
+	{
+		::close(master_);
+		::close(slave_);
+		master_ = slave_ = -1;
+	}
+	name_.clear();
+}
+
+void simulator_pty_t::serve()
+{
+	uint8_t buffer[PACKET_MAX_DATA_SIZE];
+	while (running_)
+	{
+		struct pollfd fd = {master_, POLLIN, 0};
+		if (::poll(&fd, 1, 1) > 0 && (fd.revents & POLLIN))
+		{
+			const ssize_t size = ::read(master_, buffer, sizeof(buffer));
+			if (size > 0)
+			{
+				simulator_.write(buffer, static_cast<uint8_t>(size));
+			}
+		}
+		ssr::RETVAL size;
+		while ((size = simulator_.read(buffer, sizeof(buffer))) > 0)
+		{
+			for (ssize_t written = 0, n; written < size; written += n)
+			{
+				if ((n = ::write(master_, buffer + written, size - written)) < 0)
+				{
+					break;
+				}
+			}
+		}
+	}
+}
+#endif
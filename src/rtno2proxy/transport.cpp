@@ -5,6 +5,7 @@
 #include <chrono>
 #include <thread>
 #include <iostream>
+#include <algorithm>
 
 #include "definition.h"
 
@@ -16,179 +17,536 @@ const uint32_t RTNO_INFINITE = 0xFFFFFFFF;
 
 using namespace ssr::rtno2;
 
-transport_t::transport_t(SerialDevice *pSerialDevice, ssr::rtno2::LOGLEVEL loglevel) : logger_(get_logger("Transport"))
+// Commands with their own receive queue. Anything else shares one extra queue.
+static const COMMAND QUEUED_COMMANDS[] = {
+	COMMAND::INITIALIZE,
+	COMMAND::ACTIVATE,
+	COMMAND::DEACTIVATE,
+	COMMAND::GET_STATE,
+	COMMAND::GET_CONTEXT_TYPE,
+	COMMAND::EXECUTE,
+	COMMAND::RESET,
+	COMMAND::ONERROR,
+	COMMAND::GET_PROFILE,
+	COMMAND::INPORT_PROFILE,
+	COMMAND::OUTPORT_PROFILE,
+	COMMAND::PLATFORM_PROFILE,
+	COMMAND::SEND_DATA,
+	COMMAND::RECEIVE_DATA,
+	COMMAND::RECEIVE_DATA_FRAGMENT,
+	COMMAND::BATCH_CYCLE,
+	COMMAND::RECEIVE_LOG,
+	COMMAND::PACKET_ERROR,
+	COMMAND::PACKET_ERROR_CHECKSUM,
+	COMMAND::PACKET_ERROR_TIMEOUT,
+};
+static const size_t QUEUE_COUNT = sizeof(QUEUED_COMMANDS) / sizeof(QUEUED_COMMANDS[0]) + 1;
+
+// How long the receive thread blocks before it checks for stop_receiver().
+#define RECEIVER_POLL_USEC (100 * 1000)
+
+transport_t::transport_t(SerialDevice *pSerialDevice, ssr::rtno2::LOGLEVEL loglevel, const wait_policy_t &wait_policy) : logger_(get_logger("Transport")), wait_policy_(wait_policy), send_pacing_usec_(0), framing_(FRAMING::V1), next_frame_id_(0), last_frame_id_(ANY_FRAME_ID),
+																															queues_(new receive_queue_t[QUEUE_COUNT]), sequence_(0), checksum_errors_(0), checksum_errors_reported_(0), heartbeat_count_(0), last_heartbeat_nsec_(0), dropped_count_(0),
+																															receiver_running_(false), waiters_(0)
 {
 	set_log_level(&logger_, loglevel);
 	RTNO_TRACE(logger_, "Transport() called");
 	serial_device_ = pSerialDevice;
+	queue_index_.fill(QUEUE_COUNT - 1);
+	for (size_t i = 0; i < QUEUE_COUNT - 1; i++)
+	{
+		queue_index_[(uint8_t)QUEUED_COMMANDS[i]] = i;
+	}
 }
 
 transport_t::~transport_t(void)
 {
+	stop_receiver();
 }
 
-RESULT transport_t::read(uint8_t *buffer, uint8_t size, uint32_t wait_usec)
+RESULT transport_t::wait_rx(const deadline_t deadline, int &available)
 {
-	RTNO_TRACE(logger_, "transport_t::read(wait_usec={}) called", wait_usec);
-	if (size == 0)
+	if (wait_policy_.mode == WAIT_MODE::BUSY_POLL || wait_policy_.mode == WAIT_MODE::SPIN_THEN_BLOCK)
 	{
-		return RESULT::OK;
+		auto spin_deadline = deadline;
+		if (wait_policy_.mode == WAIT_MODE::SPIN_THEN_BLOCK)
+		{
+			spin_deadline = std::min(deadline, monotonic_clock::now() + std::chrono::microseconds(wait_policy_.spin_usec));
+		}
+		while (true)
+		{
+			if ((available = serial_device_->getSizeInRxBuffer()) > 0)
+			{
+				return RESULT::OK;
+			}
+			if (is_expired(spin_deadline))
+			{
+				break;
+			}
+		}
+		if (wait_policy_.mode == WAIT_MODE::BUSY_POLL)
+		{
+			return RESULT::TIMEOUT;
+		}
 	}
-	auto start_time = std::chrono::system_clock::now();
-	while (1)
+
+	while (true)
 	{
-		if (serial_device_->getSizeInRxBuffer() >= size)
+		if ((available = serial_device_->getSizeInRxBuffer()) > 0)
 		{
-			break;
+			return RESULT::OK;
 		}
-		auto duration = std::chrono::duration<double>(std::chrono::system_clock::now() - start_time).count();
-		if (duration * 1000000 > wait_usec && wait_usec != UINT32_MAX)
+		auto rest = remaining_usec(deadline);
+		if (rest == 0)
 		{
 			return RESULT::TIMEOUT;
 		}
+		// Wake up at least once a second even when waiting forever.
+		if (serial_device_->waitRxReady(rest > 1000 * 1000 ? 1000 * 1000 : rest) < 0)
+		{
+			RTNO_ERROR(logger_, "transport_t::wait_rx() waitRxReady failed");
+			return RESULT::ERR;
+		}
 	}
-	int read_size = serial_device_->read(buffer, size);
-	if (read_size != size)
+}
+
+RESULT transport_t::fill(const deadline_t deadline)
+{
+	int available = 0;
+	RESULT result;
+	if ((result = wait_rx(deadline, available)) != RESULT::OK)
+	{
+		return result;
+	}
+	size_t writable = 0;
+	uint8_t *dst = decoder_.prepare(writable);
+	size_t size = std::min<size_t>({(size_t)available, writable, 255});
+	int read_size = serial_device_->read(dst, (uint8_t)size);
+	if (read_size < 0)
 	{
-		RTNO_ERROR(logger_, "transport_t::read() read size mismatch (expected={}, actual={})", size, read_size);
+		RTNO_ERROR(logger_, "transport_t::fill() read failed ({})", read_size);
 		return RESULT::ERR;
 	}
+	RTNO_TRACE(logger_, "transport_t::fill() read {} bytes (available={})", read_size, available);
+	decoder_.commit(read_size);
 	return RESULT::OK;
 }
 
-RESULT transport_t::write(const uint8_t *buffer, const uint8_t size)
+RESULT transport_t::write(const uint8_t *buffer, const size_t size)
 {
-	RTNO_TRACE(logger_, "Transport::write() called");
+	RTNO_TRACE(logger_, "Transport::write(size={}) called", size);
+	if (send_pacing_usec_ > 0)
+	{
+		for (size_t i = 0; i < size; i++)
+		{
+			if (serial_device_->write(buffer + i, 1) != 1)
+			{
+				return RESULT::ERR;
+			}
+			std::this_thread::sleep_for(std::chrono::microseconds(send_pacing_usec_));
+		}
+		return RESULT::OK;
+	}
 
-	for (uint8_t i = 0; i < size; i++)
+	// SerialDevice::write takes at most 255 bytes. Any frame whose payload fits the v1 protocol fits in one call.
+	// Longer writes go out with writeMore() but the last, so that a stream device sends them as one segment.
+	size_t written = 0;
+	while (written < size)
 	{
-		serial_device_->write(buffer + i, 1);
-		// std::this_thread::sleep_for(std::chrono::microseconds(PACKET_SENDING_DELAY));
+		size_t chunk = std::min<size_t>(size - written, 255);
+		int ret = written + chunk < size ? serial_device_->writeMore(buffer + written, (uint8_t)chunk) : serial_device_->write(buffer + written, (uint8_t)chunk);
+		if (ret <= 0)
+		{
+			RTNO_ERROR(logger_, "transport_t::write() failed ({})", ret);
+			return RESULT::ERR;
+		}
+		written += ret;
 	}
 	return RESULT::OK;
 }
 
-RESULT transport_t::send(const packet_t &packet)
+size_t transport_t::encode(uint8_t *dst, const packet_t &packet, const uint8_t sum)
+{
+	const FRAMING framing = framing_.load();
+	if (framing == FRAMING::V2)
+	{
+		last_frame_id_ = next_frame_id_++;
+	}
+	return encode_frame(dst, packet, sum, framing, static_cast<uint8_t>(last_frame_id_));
+}
+
+RESULT transport_t::send(const packet_t &packet, const uint8_t sum)
 {
 	RTNO_TRACE(logger_, "transport_t::send({}) called", packet.to_string());
-	const uint8_t headers[2] = {0x0a, 0x0a};
+	// Assemble whole frame (start bytes, packet, checksum) so that it goes out in a single write.
+	uint8_t frame[PACKET_MAX_FRAME_SIZE];
 	RESULT result;
-	if ((result = write(headers, 2)) != RESULT::OK)
+	if ((result = write(frame, encode(frame, packet, sum))) != RESULT::OK)
 	{
-		RTNO_ERROR(logger_, "transport_t::send() send startbytes failed {}", result_to_string(result));
+		RTNO_ERROR(logger_, "transport_t::send() send frame failed {}", result_to_string(result));
 		return result;
 	}
-	if ((result = write(packet.serialize(), packet.getPacketLength())) != RESULT::OK)
+	RTNO_TRACE(logger_, "transport_t::send() exit");
+	return RESULT::OK;
+}
+
+RESULT transport_t::send(const std::vector<const packet_t *> &packets)
+{
+	RTNO_TRACE(logger_, "transport_t::send(count={}) called", packets.size());
+	tx_buffer_.resize(packets.size() * PACKET_MAX_FRAME_SIZE);
+	size_t size = 0;
+	for (auto packet : packets)
 	{
-		RTNO_ERROR(logger_, "transport_t::send() send body failed {}", result_to_string(result));
-		return result;
+		size += encode(tx_buffer_.data() + size, *packet, packet->getSum());
 	}
-	uint8_t sum = packet.getSum();
-	if ((result = write(&sum, 1)) != RESULT::OK)
+	RESULT result;
+	if ((result = write(tx_buffer_.data(), size)) != RESULT::OK)
 	{
-		RTNO_ERROR(logger_, "transport_t::send() send sum failed {}", result_to_string(result));
+		RTNO_ERROR(logger_, "transport_t::send() send {} frames failed {}", packets.size(), result_to_string(result));
 		return result;
 	}
-	RTNO_TRACE(logger_, "transport_t::send() exit");
 	return RESULT::OK;
 }
 
-RESULT transport_t::is_new(const uint32_t wait_usec)
+RESULT transport_t::start_receiver()
 {
-	RTNO_TRACE(logger_, "transport_t::is_new({}) called", wait_usec);
-	uint8_t buf;
-	RESULT result;
-	while (1)
+	if (receiver_running_.load())
+	{
+		return RESULT::OK;
+	}
+	RTNO_DEBUG(logger_, "transport_t::start_receiver() called");
+	receiver_running_.store(true);
+	try
+	{
+		receiver_ = std::thread(&transport_t::receiver_main, this);
+	}
+	catch (const std::exception &e)
+	{
+		receiver_running_.store(false);
+		RTNO_ERROR(logger_, "transport_t::start_receiver() failed to start thread: {}", e.what());
+		return RESULT::ERR;
+	}
+	return RESULT::OK;
+}
+
+void transport_t::stop_receiver()
+{
+	if (!receiver_running_.exchange(false))
+	{
+		return;
+	}
+	RTNO_DEBUG(logger_, "transport_t::stop_receiver() called");
+	if (receiver_.joinable())
+	{
+		receiver_.join();
+	}
+}
+
+void transport_t::set_serial_device(SerialDevice *serial_device)
+{
+	const bool running = receiver_running_.load();
+	stop_receiver();
+	serial_device_ = serial_device;
+	clear_rx_buffer();
+	if (running)
 	{
-		if ((result = this->read(&buf, 1, wait_usec)) != RESULT::OK)
+		start_receiver();
+	}
+}
+
+void transport_t::receiver_main()
+{
+	RTNO_TRACE(logger_, "transport_t::receiver_main() started");
+	while (receiver_running_.load())
+	{
+		RESULT result = fill(deadline_after(RECEIVER_POLL_USEC));
+		if (result == RESULT::OK)
 		{
-			if (result == RESULT::TIMEOUT)
+			if (decode_all() > 0)
 			{
-				RTNO_TRACE(logger_, "transport_t::is_new() exit with TIMEOUT");
-				return RESULT::TIMEOUT;
+				// Waiters are counted before they check the queues, so a push is never missed.
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+				if (waiters_.load() > 0)
+				{
+					std::lock_guard<std::mutex> lock(mutex_);
+					cond_.notify_all();
+				}
 			}
-			RTNO_WARN(logger_, "transport_t::is_new() exit with Error {}", result_to_string(result));
-			return result;
 		}
-		if (buf != 0x0a)
+		else if (result != RESULT::TIMEOUT)
 		{
+			RTNO_ERROR(logger_, "transport_t::receiver_main() receive failed ({})", result_to_string(result));
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+	}
+	RTNO_TRACE(logger_, "transport_t::receiver_main() exit");
+}
+
+transport_t::receive_queue_t *transport_t::queue_of(const COMMAND command)
+{
+	return &queues_[queue_index_[(uint8_t)command]];
+}
+
+void transport_t::dispatch(const packet_t &packet, const int frame_id)
+{
+	if (packet.get_command() == COMMAND::HEART_BEAT)
+	{
+		last_heartbeat_nsec_.store(monotonic_clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+		heartbeat_count_.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+	if (!queue_of(packet.get_command())->push(received_t{sequence_++, static_cast<int16_t>(frame_id), packet}))
+	{
+		dropped_count_.fetch_add(1, std::memory_order_relaxed);
+		RTNO_DEBUG(logger_, "transport_t::dispatch() queue of {} is full. Dropped ({})", command_to_string(packet.get_command()), packet.to_string());
+	}
+}
+
+int transport_t::decode_all()
+{
+	int count = 0;
+	decoder_.set_negotiated(framing_.load());
+	while (true)
+	{
+		auto decoded = decoder_.decode();
+		if (decoded.error() == RESULT::NOT_AVAILABLE)
+		{
+			return count;
+		}
+		count++;
+		if (decoded.error() == RESULT::CHECKSUM_ERROR)
+		{
+			RTNO_ERROR(logger_, "transport_t::decode_all() checksum error.");
+			checksum_errors_.fetch_add(1);
 			continue;
 		}
+		dispatch(*decoded, decoder_.framing() == FRAMING::V2 ? decoder_.frame_id() : ANY_FRAME_ID);
+	}
+}
+
+RESULT transport_t::pump(const deadline_t deadline)
+{
+	if (decode_all() > 0)
+	{
+		return RESULT::OK;
+	}
+	RESULT result;
+	if ((result = fill(deadline)) != RESULT::OK)
+	{
+		return result;
+	}
+	decode_all();
+	return RESULT::OK;
+}
+
+RESULT transport_t::timeout_result()
+{
+	if (receiver_running_.load())
+	{
+		return RESULT::PACKET_START_TIMEOUT;
+	}
+	// Partially received frame stays in decoder and is resumed by the next call.
+	switch (decoder_.state())
+	{
+	case frame_decoder_t::STATE::HEADER:
+		RTNO_ERROR(logger_, "receive() exit with read header timeout");
+		return RESULT::PACKET_HEADER_TIMEOUT;
+	case frame_decoder_t::STATE::BODY:
+		RTNO_ERROR(logger_, "receive() exit with read data body timeout");
+		return RESULT::PACKET_BODY_TIMEOUT;
+	case frame_decoder_t::STATE::CHECKSUM:
+		RTNO_ERROR(logger_, "receive() exit with read checksum timeout");
+		return RESULT::PACKET_CHECKSUM_TIMEOUT;
+	default:
+		return RESULT::PACKET_START_TIMEOUT;
+	}
+}
 
-		if ((result = this->read(&buf, 1, wait_usec)) != RESULT::OK)
+template <typename READY>
+RESULT transport_t::wait_queued(const READY &ready, const deadline_t deadline, const uint64_t checksum_errors_before)
+{
+	// Only broken frames decoded after checksum_errors_before end this wait.
+	auto broken = [&]()
+	{ return checksum_errors_.load() != checksum_errors_before; };
+	if (!receiver_running_.load())
+	{
+		// Caller's thread reads the device itself.
+		while (!ready())
 		{
-			if (result == RESULT::TIMEOUT)
+			if (broken())
 			{
-				RTNO_WARN(logger_, "In transport_t::is_new() reading 2nd starting packet failed. exit with TIMEOUT");
-				return RESULT::TIMEOUT;
+				return RESULT::CHECKSUM_ERROR;
+			}
+			RESULT result;
+			if ((result = pump(deadline)) != RESULT::OK)
+			{
+				return result == RESULT::TIMEOUT ? timeout_result() : result;
 			}
-			RTNO_WARN(logger_, "transport_t::is_new() exit with Error {}", result_to_string(result));
-			return result;
 		}
-		if (buf == 0x0a)
+		return RESULT::OK;
+	}
+
+	if (wait_policy_.mode != WAIT_MODE::BLOCKING)
+	{
+		auto spin_deadline = deadline;
+		if (wait_policy_.mode == WAIT_MODE::SPIN_THEN_BLOCK)
+		{
+			spin_deadline = std::min(deadline, monotonic_clock::now() + std::chrono::microseconds(wait_policy_.spin_usec));
+		}
+		while (!ready())
 		{
-			break;
+			if (broken())
+			{
+				return RESULT::CHECKSUM_ERROR;
+			}
+			if (is_expired(spin_deadline))
+			{
+				if (wait_policy_.mode == WAIT_MODE::BUSY_POLL)
+				{
+					return timeout_result();
+				}
+				break;
+			}
 		}
 	}
 
-	RTNO_TRACE(logger_, "transport_t::is_new() exit with OK");
-	return RESULT::OK;
+	waiters_.fetch_add(1);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+		while (!ready() && !broken())
+		{
+			auto rest = remaining_usec(deadline);
+			if (rest == 0)
+			{
+				break;
+			}
+			// Wake up at least once a second even when waiting forever.
+			cond_.wait_for(lock, std::chrono::microseconds(rest > 1000 * 1000 ? 1000 * 1000 : rest));
+		}
+	}
+	waiters_.fetch_sub(1);
+	if (ready())
+	{
+		return RESULT::OK;
+	}
+	if (broken())
+	{
+		return RESULT::CHECKSUM_ERROR;
+	}
+	return timeout_result();
 }
 
-result_t<packet_t> transport_t::receive(const uint32_t wait_usec /*=RTNO_INFINITE*/)
+transport_t::receive_queue_t *transport_t::oldest_queue()
 {
-	RTNO_TRACE(logger_, "receive(wait_usec={}) called", wait_usec);
-	uint8_t header[PACKET_RECEIVE_HEADER_SIZE]; // header[0] : COMMAND, header[1]: RESULT, header[2] : length
-	RESULT result;
-	if ((result = read(header, PACKET_RECEIVE_HEADER_SIZE, wait_usec)) != RESULT::OK)
+	receive_queue_t *oldest = NULL;
+	uint64_t sequence = 0;
+	for (size_t i = 0; i < QUEUE_COUNT; i++)
 	{
-		RTNO_WARN(logger_, "receive() exit with PACKET_RECEIVE_HEADER_SIZE");
-		if (result == RESULT::TIMEOUT)
+		auto front = queues_[i].front();
+		if (front != nullptr && (oldest == NULL || front->sequence < sequence))
 		{
-			RTNO_ERROR(logger_, "receive() exit with read header timeout");
-			return RESULT::PACKET_HEADER_TIMEOUT;
+			oldest = &queues_[i];
+			sequence = front->sequence;
 		}
-		return result;
 	}
+	return oldest;
+}
 
-	uint8_t sender[4];
-	serial_device_->getSenderInfo(sender);
-	// if(read(sender, 4, wait_usec) < 0) {
-	//     throw TimeOutException();
-	//   }
+RESULT transport_t::is_new(const deadline_t deadline)
+{
+	RTNO_TRACE(logger_, "transport_t::is_new(remaining_usec={}) called", remaining_usec(deadline));
+	RESULT result = wait_queued([this]()
+								{ return oldest_queue() != NULL; },
+								deadline, checksum_errors_reported_);
+	if (result == RESULT::CHECKSUM_ERROR)
+	{
+		// receive() reports the broken frame.
+		return RESULT::OK;
+	}
+	RTNO_TRACE(logger_, "transport_t::is_new() exit with {}", result_to_string(result));
+	return result;
+}
 
-	uint8_t data_buffer[256];
-	if ((result = read(data_buffer, header[2], wait_usec)) != RESULT::OK)
+result_t<packet_t> transport_t::receive(const deadline_t deadline, int *frame_id)
+{
+	RTNO_TRACE(logger_, "receive(remaining_usec={}) called", remaining_usec(deadline));
+	receive_queue_t *queue = NULL;
+	// Any broken frame could have been the next packet, so every one not reported yet ends the wait.
+	RESULT result = wait_queued([this, &queue]()
+								{ return (queue = oldest_queue()) != NULL; },
+								deadline, checksum_errors_reported_);
+	if (result != RESULT::OK)
 	{
-		RTNO_WARN(logger_, "receive() exit with read data timeout");
-		if (result == RESULT::TIMEOUT)
+		if (result == RESULT::CHECKSUM_ERROR)
 		{
-			RTNO_ERROR(logger_, "receive() exit with read data body timeout");
-			return RESULT::PACKET_BODY_TIMEOUT;
+			RTNO_ERROR(logger_, "receive() exit with checksum error.");
+			checksum_errors_reported_ = checksum_errors_.load();
 		}
 		return result;
 	}
+	packet_t packet = queue->front()->packet;
+	if (frame_id)
+	{
+		*frame_id = queue->front()->frame_id;
+	}
+	queue->pop();
+	RTNO_TRACE(logger_, "receive() exit");
+	return packet;
+}
 
-	packet_t packet((COMMAND)header[0], (RESULT)header[1], data_buffer, header[2]);
-	uint8_t sum = packet.getSum();
-
-	uint8_t buf;
-	if ((result = read(&buf, 1, wait_usec)) != RESULT::OK)
+result_t<packet_t> transport_t::receive(const COMMAND command, const deadline_t deadline, const int frame_id)
+{
+	RTNO_TRACE(logger_, "receive(command={}, remaining_usec={}, frame_id={}) called", command_to_string(command), remaining_usec(deadline), frame_id);
+	receive_queue_t *command_queue = queue_of(command);
+	receive_queue_t *error_queue = queue_of(COMMAND::PACKET_ERROR);
+	receive_queue_t *queue = NULL;
+	const uint64_t checksum_errors_before = checksum_errors_.load();
+	RESULT result = wait_queued([&]()
+								{
+		auto reply = command_queue->front();
+		// Late replies to earlier frames carry their own ids. V1 replies have no id and are taken as they come.
+		while (frame_id != ANY_FRAME_ID && reply != nullptr && reply->frame_id != ANY_FRAME_ID && reply->frame_id != frame_id)
+		{
+			RTNO_DEBUG(logger_, "receive({}) drops reply to frame {} while waiting frame {}", command_to_string(command), reply->frame_id, frame_id);
+			command_queue->pop();
+			reply = command_queue->front();
+		}
+		auto error = error_queue->front();
+		queue = (error != nullptr && (reply == nullptr || error->sequence < reply->sequence)) ? error_queue : (reply != nullptr ? command_queue : NULL);
+		return queue != NULL; },
+								deadline, checksum_errors_before);
+	if (result != RESULT::OK)
 	{
-		if (result == RESULT::TIMEOUT)
+		if (result == RESULT::CHECKSUM_ERROR)
 		{
-			RTNO_ERROR(logger_, "receive() exit with read checksum timeout");
-			return RESULT::PACKET_CHECKSUM_TIMEOUT;
+			RTNO_ERROR(logger_, "receive({}) exit with checksum error.", command_to_string(command));
+			checksum_errors_reported_ = checksum_errors_.load();
 		}
 		return result;
 	}
+	packet_t packet = queue->front()->packet;
+	queue->pop();
+	RTNO_TRACE(logger_, "receive({}) exit", command_to_string(command));
+	return packet;
+}
 
-	if (sum != buf)
+void transport_t::discard(const COMMAND command)
+{
+	queue_of(command)->clear();
+	queue_of(COMMAND::PACKET_ERROR)->clear();
+}
+
+void transport_t::clear_rx_buffer()
+{
+	if (!receiver_running_.load())
 	{
-		RTNO_ERROR(logger_, "receive() exit with checksum error. CHECKSUM value of received packet ({}) and calculated one ({}) is different. data is {}", (int)buf, (int)sum, packet.to_string());
-		return RESULT::CHECKSUM_ERROR;
+		serial_device_->flushRxBuffer();
+		decoder_.clear();
 	}
-
-	RTNO_TRACE(logger_, "receive() exit");
-	return packet;
+	for (size_t i = 0; i < QUEUE_COUNT; i++)
+	{
+		queues_[i].clear();
+	}
+	checksum_errors_reported_ = checksum_errors_.load();
 }
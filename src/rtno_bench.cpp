@@ -0,0 +1,1909 @@
+#include "hal/Serial.h"
+#include "hal/EtherTcp.h"
+#include "rtno2/transport.h"
+#include "rtno2/protocol.h"
+#include "rtno2/packet.h"
+#include "rtno2/logger.h"
+#include "rtno2/frame_decoder.h"
+#include "rtno2/simulator.h"
+#include "rtno2/loopback.h"
+#include "rtno2/relay.h"
+
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <random>
+
+#include <string.h>
+
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+#include <time.h>
+
+using namespace ssr::rtno2;
+
+/*******************************************************************
+ *
+ * Utilities
+ *
+ *******************************************************************/
+static double thread_cpu_seconds()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int64_t now_nsec()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(monotonic_clock::now().time_since_epoch()).count();
+}
+
+static double percentile(std::vector<double> v, const double p)
+{
+    if (v.empty())
+    {
+        return 0;
+    }
+    std::sort(v.begin(), v.end());
+    size_t index = static_cast<size_t>(p * (v.size() - 1));
+    return v[index];
+}
+
+/**
+ * Heap allocation counter. Allocations made by the simulated devices (device_scope_t) are not counted,
+ * since a real device lives in the kernel or on the other end of the cable.
+ */
+static std::atomic<uint64_t> g_allocations(0);
+static thread_local int t_device_depth = 0;
+
+struct device_scope_t
+{
+    device_scope_t() { t_device_depth++; }
+    ~device_scope_t() { t_device_depth--; }
+};
+
+void *operator new(size_t size)
+{
+    if (t_device_depth == 0)
+    {
+        g_allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (void *p = malloc(size ? size : 1))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+
+/**
+ * Pseudo terminal pair. The slave side is opened by ssr::Serial exactly as a real tty,
+ * and the bench drives the master side as if it were the RTno firmware.
+ */
+class pty_pair_t
+{
+public:
+    int master_fd;
+    int slave_fd;
+    std::string slave_name;
+
+public:
+    pty_pair_t() : master_fd(-1), slave_fd(-1)
+    {
+        master_fd = posix_openpt(O_RDWR | O_NOCTTY);
+        if (master_fd < 0 || grantpt(master_fd) < 0 || unlockpt(master_fd) < 0)
+        {
+            throw std::runtime_error("posix_openpt failed");
+        }
+        slave_name = ptsname(master_fd);
+        // Keep the slave open in raw mode so that termios settings persist while Serial reopens it.
+        slave_fd = open(slave_name.c_str(), O_RDWR | O_NOCTTY);
+        struct termios tio;
+        tcgetattr(slave_fd, &tio);
+        cfmakeraw(&tio);
+        tcsetattr(slave_fd, TCSANOW, &tio);
+    }
+
+    ~pty_pair_t()
+    {
+        close(slave_fd);
+        close(master_fd);
+    }
+};
+
+static std::vector<uint8_t> serialize_frame(const packet_t &packet)
+{
+    std::vector<uint8_t> frame = {0x0a, 0x0a};
+    frame.insert(frame.end(), packet.serialize(), packet.serialize() + packet.getPacketLength());
+    frame.push_back(packet.getSum());
+    return frame;
+}
+
+/*******************************************************************
+ *
+ * Wait policy bench
+ *
+ * The firmware side sends a GET_STATE reply every interval.
+ * The receiving thread measures wake-up latency (frame written -> packet returned)
+ * and how much CPU time it burned while waiting.
+ *
+ *******************************************************************/
+static void bench_wait_policy_one(const wait_policy_t &policy, const int count, const int interval_usec)
+{
+    pty_pair_t pty;
+    ssr::Serial serial(pty.slave_name.c_str(), 115200);
+    transport_t transport(&serial, LOGLEVEL::WARN, policy);
+
+    const uint8_t state = (uint8_t)'A';
+    auto frame = serialize_frame(packet_t(COMMAND::GET_STATE, RESULT::OK, &state, 1));
+
+    std::vector<std::atomic<int64_t>> sent_at(count);
+    std::vector<double> latencies_usec;
+    double cpu_seconds = 0;
+    double wall_seconds = 0;
+    int received = 0;
+
+    std::thread receiver([&]()
+                         {
+        auto cpu_start = thread_cpu_seconds();
+        auto wall_start = now_nsec();
+        for (int i = 0; i < count; i++)
+        {
+            if (transport.is_new(1000 * 1000) != RESULT::OK)
+            {
+                break;
+            }
+            auto result = transport.receive(1000 * 1000);
+            auto t = now_nsec();
+            if (result.error() != RESULT::OK)
+            {
+                break;
+            }
+            latencies_usec.push_back((t - sent_at[i].load()) / 1000.0);
+            received++;
+        }
+        cpu_seconds = thread_cpu_seconds() - cpu_start;
+        wall_seconds = (now_nsec() - wall_start) * 1e-9; });
+
+    for (int i = 0; i < count; i++)
+    {
+        std::this_thread::sleep_for(std::chrono::microseconds(interval_usec));
+        sent_at[i].store(now_nsec());
+        if (write(pty.master_fd, frame.data(), frame.size()) != (ssize_t)frame.size())
+        {
+            std::cerr << "write to pty failed" << std::endl;
+            break;
+        }
+    }
+    receiver.join();
+
+    std::cout << std::left << std::setw(28) << wait_mode_to_string(policy.mode)
+              << std::right << std::fixed << std::setprecision(1)
+              << std::setw(8) << received
+              << std::setw(10) << (wall_seconds > 0 ? 100.0 * cpu_seconds / wall_seconds : 0.0)
+              << std::setw(10) << percentile(latencies_usec, 0.5)
+              << std::setw(10) << percentile(latencies_usec, 0.99)
+              << std::setw(10) << percentile(latencies_usec, 1.0)
+              << std::endl;
+}
+
+static void bench_wait_policy()
+{
+    const int count = 500;
+    const int interval_usec = 2000;
+    std::cout << "[wait] " << count << " frames, one every " << interval_usec << " usec over a pty" << std::endl;
+    std::cout << std::left << std::setw(28) << "mode" << std::right
+              << std::setw(8) << "frames" << std::setw(10) << "cpu%"
+              << std::setw(10) << "p50(us)" << std::setw(10) << "p99(us)" << std::setw(10) << "max(us)" << std::endl;
+    bench_wait_policy_one(wait_policy_t::blocking(), count, interval_usec);
+    bench_wait_policy_one(wait_policy_t::spin_then_block(50), count, interval_usec);
+    bench_wait_policy_one(wait_policy_t::busy_poll(), count, interval_usec);
+}
+
+/*******************************************************************
+ *
+ * Decode bench
+ *
+ * In-memory device delivering 64-byte bursts like USB-CDC.
+ * Counts device calls (each one is a syscall on a real tty) per decoded packet.
+ *
+ *******************************************************************/
+class burst_device_t : public ssr::SerialDevice
+{
+public:
+    std::vector<uint8_t> data;
+    size_t position = 0;
+    size_t burst_size = 64;
+    int calls = 0;
+    int writes = 0;
+
+public:
+    void flushRxBuffer() { position = data.size(); }
+    void flushTxBuffer() {}
+    ssr::RETVAL getSizeInRxBuffer()
+    {
+        calls++;
+        size_t burst_end = std::min(data.size(), (position / burst_size + 1) * burst_size);
+        return burst_end - position;
+    }
+    ssr::RETVAL write(const uint8_t *, const uint8_t size)
+    {
+        writes++;
+        return size;
+    }
+    ssr::RETVAL read(uint8_t *dst, const uint8_t size)
+    {
+        calls++;
+        size_t n = std::min<size_t>(size, data.size() - position);
+        memcpy(dst, data.data() + position, n);
+        position += n;
+        return n;
+    }
+    ssr::RETVAL getSenderInfo(uint8_t *) { return 0; }
+    ssr::RETVAL waitRxReady(const uint32_t timeout_usec)
+    {
+        calls++;
+        if (position < data.size())
+        {
+            return 1;
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(timeout_usec));
+        return 0;
+    }
+};
+
+static void bench_decode()
+{
+    const int count = 10000;
+    burst_device_t device;
+    const uint8_t payload[] = {3, 4, 'l', 'o', 'n', 'g', 1, 2, 3, 4, 'o', 'u', 't'};
+    auto frame = serialize_frame(packet_t(COMMAND::RECEIVE_DATA, RESULT::OK, payload, sizeof(payload)));
+    for (int i = 0; i < count; i++)
+    {
+        device.data.insert(device.data.end(), frame.begin(), frame.end());
+    }
+
+    transport_t transport(&device, LOGLEVEL::WARN);
+    int received = 0;
+    auto start = now_nsec();
+    while (transport.is_new(0) == RESULT::OK)
+    {
+        if (transport.receive(0).error() != RESULT::OK)
+        {
+            break;
+        }
+        received++;
+    }
+    auto elapsed = (now_nsec() - start) * 1e-9;
+    std::cout << "[decode] " << received << "/" << count << " packets of " << frame.size() << " bytes in "
+              << device.burst_size << "-byte bursts: " << std::fixed << std::setprecision(2)
+              << (double)device.calls / received << " device calls/packet, "
+              << received / elapsed / 1000.0 << " kpackets/s" << std::endl;
+}
+
+static void bench_send()
+{
+    const int count = 10000;
+    burst_device_t device;
+    transport_t transport(&device, LOGLEVEL::WARN);
+    uint8_t payload[40] = {7, 31, 'i', 'n', '0', '0', '0', '0', '1'};
+    packet_t packet(COMMAND::SEND_DATA, RESULT::OK, payload, sizeof(payload));
+    auto start = now_nsec();
+    for (int i = 0; i < count; i++)
+    {
+        transport.send(packet);
+    }
+    auto elapsed = (now_nsec() - start) * 1e-9;
+    std::cout << "[send] " << count << " SEND_DATA packets with " << sizeof(payload) << "-byte payload: " << std::fixed << std::setprecision(2)
+              << (double)device.writes / count << " device writes/packet, "
+              << count / elapsed / 1000.0 << " kpackets/s" << std::endl;
+}
+
+/*******************************************************************
+ *
+ * Retry bench
+ *
+ * Device never answers. Shows how long one failing call stalls the caller.
+ *
+ *******************************************************************/
+static void bench_retry()
+{
+    burst_device_t device;
+    protocol_t protocol(&device, LOGLEVEL::CRITICAL, LOGLEVEL::CRITICAL);
+
+    auto measure = [](const std::string &label, const std::function<RESULT()> &call)
+    {
+        auto start = now_nsec();
+        auto result = call();
+        std::cout << "[retry] " << std::left << std::setw(64) << label << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(10) << (now_nsec() - start) / 1e6 << " ms  " << result_to_string(result) << std::endl;
+    };
+    measure("execute(wait_usec=10ms, retry_count=15)", [&]()
+            { return protocol.execute(10 * 1000, 15); });
+    measure("execute(deadline_after(50ms))", [&]()
+            { return protocol.execute(deadline_after(50 * 1000)); });
+    measure("execute(deadline_after(1s), {5 attempts, 10ms, backoff 5ms x2})", [&]()
+            { return protocol.execute(deadline_after(1000 * 1000), retry_policy_t(5, 10 * 1000, 5 * 1000, 2)); });
+}
+
+/*******************************************************************
+ *
+ * Pipeline bench
+ *
+ * In-memory device answering each request after latency_usec, measured from the write
+ * which carried the request (a USB round trip). One control cycle is
+ * SEND_DATA(in0) + EXECUTE + RECEIVE_DATA(out0), stop-and-wait vs run_pipeline().
+ *
+ *******************************************************************/
+class answering_device_t : public ssr::SerialDevice
+{
+public:
+    uint32_t latency_usec = 1000;
+    bool noisy = false; // Surround each reply with HEART_BEAT, unsolicited RECEIVE_LOG and a duplicated reply.
+    std::vector<packet_t> profile; // Replies to GET_PROFILE, sent before the terminating GET_PROFILE.
+    int writes = 0;
+
+private:
+    // write() and read() may come from different threads once the receive thread runs.
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    frame_decoder_t requests_;
+    std::vector<std::pair<int64_t, std::vector<uint8_t>>> replies_; // (ready_at, frame)
+    std::vector<uint8_t> rx_;
+
+public:
+    void flushRxBuffer()
+    {
+        device_scope_t scope;
+        std::lock_guard<std::mutex> lock(mutex_);
+        rx_.clear();
+        replies_.clear();
+    }
+    void flushTxBuffer() {}
+    ssr::RETVAL getSizeInRxBuffer()
+    {
+        device_scope_t scope;
+        std::lock_guard<std::mutex> lock(mutex_);
+        deliver();
+        return rx_.size();
+    }
+    ssr::RETVAL write(const uint8_t *src, const uint8_t size)
+    {
+        device_scope_t scope;
+        std::lock_guard<std::mutex> lock(mutex_);
+        writes++;
+        const int64_t ready_at = now_nsec() + latency_usec * 1000LL;
+        size_t writable;
+        memcpy(requests_.prepare(writable), src, size);
+        requests_.commit(size);
+        while (true)
+        {
+            auto request = requests_.decode();
+            if (request.error() != RESULT::OK)
+            {
+                break;
+            }
+            if (request->get_command() == COMMAND::GET_PROFILE)
+            {
+                for (auto &packet : profile)
+                {
+                    replies_.emplace_back(ready_at, serialize_frame(packet));
+                }
+            }
+            auto reply = serialize_frame(answer(*request));
+            if (noisy)
+            {
+                const uint8_t log[] = {'l', 'o', 'g'};
+                replies_.emplace_back(ready_at, serialize_frame(packet_t(COMMAND::HEART_BEAT, RESULT::OK)));
+                replies_.emplace_back(ready_at, serialize_frame(packet_t(COMMAND::RECEIVE_LOG, RESULT::OK, log, sizeof(log))));
+                replies_.emplace_back(ready_at, reply);
+            }
+            replies_.emplace_back(ready_at, reply);
+        }
+        cond_.notify_all();
+        return size;
+    }
+    ssr::RETVAL read(uint8_t *dst, const uint8_t size)
+    {
+        device_scope_t scope;
+        std::lock_guard<std::mutex> lock(mutex_);
+        deliver();
+        size_t n = std::min<size_t>(size, rx_.size());
+        memcpy(dst, rx_.data(), n);
+        rx_.erase(rx_.begin(), rx_.begin() + n);
+        return n;
+    }
+    ssr::RETVAL getSenderInfo(uint8_t *) { return 0; }
+    ssr::RETVAL waitRxReady(const uint32_t timeout_usec)
+    {
+        device_scope_t scope;
+        std::unique_lock<std::mutex> lock(mutex_);
+        const int64_t timeout_at = now_nsec() + timeout_usec * 1000LL;
+        while (true)
+        {
+            deliver();
+            if (!rx_.empty())
+            {
+                return 1;
+            }
+            int64_t wake_at = replies_.empty() ? timeout_at : std::min(timeout_at, replies_.front().first);
+            if (now_nsec() >= timeout_at)
+            {
+                return 0;
+            }
+            cond_.wait_for(lock, std::chrono::nanoseconds(std::max<int64_t>(0, wake_at - now_nsec())));
+        }
+    }
+
+private:
+    void deliver()
+    {
+        const int64_t now = now_nsec();
+        size_t i = 0;
+        for (; i < replies_.size() && replies_[i].first <= now; i++)
+        {
+            rx_.insert(rx_.end(), replies_[i].second.begin(), replies_[i].second.end());
+        }
+        replies_.erase(replies_.begin(), replies_.begin() + i);
+    }
+
+    static packet_t answer(const packet_t &request)
+    {
+        if (request.get_command() == COMMAND::RECEIVE_DATA)
+        {
+            const uint8_t name_len = request.getData()[0];
+            std::vector<uint8_t> reply = {name_len, 4};
+            reply.insert(reply.end(), request.getData() + 2, request.getData() + 2 + name_len);
+            reply.insert(reply.end(), {1, 2, 3, 4});
+            return packet_t(COMMAND::RECEIVE_DATA, RESULT::OK, reply.data(), reply.size());
+        }
+        return packet_t(request.get_command(), RESULT::OK);
+    }
+};
+
+static void bench_pipeline()
+{
+    const int cycles = 200;
+    const uint8_t in[4] = {1, 2, 3, 4};
+    uint8_t out[4];
+    uint8_t size_read;
+
+    auto measure = [&](const std::string &label, const std::function<bool(protocol_t &)> &cycle)
+    {
+        answering_device_t device;
+        protocol_t protocol(&device, LOGLEVEL::CRITICAL, LOGLEVEL::CRITICAL);
+        int ok = 0;
+        auto start = now_nsec();
+        for (int i = 0; i < cycles; i++)
+        {
+            ok += cycle(protocol) ? 1 : 0;
+        }
+        auto elapsed_usec = (now_nsec() - start) / 1000.0;
+        std::cout << "[pipeline] " << std::left << std::setw(16) << label << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(6) << ok << "/" << cycles << " cycles, "
+                  << std::setw(8) << elapsed_usec / cycles << " us/cycle, "
+                  << std::setprecision(2) << (double)device.writes / cycles << " writes/cycle" << std::endl;
+    };
+
+    measure("stop-and-wait", [&](protocol_t &protocol)
+            { return protocol.send_inport_data("in0", in, sizeof(in), 20 * 1000) == RESULT::OK &&
+                     protocol.execute(20 * 1000) == RESULT::OK &&
+                     protocol.receive_outport_data("out0", out, sizeof(out), &size_read, 20 * 1000) == RESULT::OK; });
+    measure("run_pipeline", [&](protocol_t &protocol)
+            {
+        pipeline_t pipeline;
+        pipeline.send_inport_data("in0", in, sizeof(in)).execute().receive_outport_data("out0", out, sizeof(out), &size_read);
+        return protocol.run_pipeline(pipeline, 20 * 1000) == RESULT::OK; });
+}
+
+/*******************************************************************
+ *
+ * Demux bench
+ *
+ * Same control cycle as the pipeline bench, but every reply is surrounded by a HEART_BEAT,
+ * an unsolicited RECEIVE_LOG and a duplicated reply. Retries show up as extra writes.
+ *
+ *******************************************************************/
+static void bench_demux()
+{
+    const int cycles = 200;
+    const uint8_t in[4] = {1, 2, 3, 4};
+    uint8_t out[4];
+    uint8_t size_read;
+
+    for (bool threaded : {false, true})
+    {
+        answering_device_t device;
+        device.noisy = true;
+        protocol_t protocol(&device, LOGLEVEL::CRITICAL, LOGLEVEL::CRITICAL);
+        if (threaded)
+        {
+            protocol.start_receiver();
+        }
+        int ok = 0;
+        auto start = now_nsec();
+        for (int i = 0; i < cycles; i++)
+        {
+            ok += (protocol.send_inport_data("in0", in, sizeof(in), 20 * 1000) == RESULT::OK &&
+                   protocol.execute(20 * 1000) == RESULT::OK &&
+                   protocol.receive_outport_data("out0", out, sizeof(out), &size_read, 20 * 1000) == RESULT::OK)
+                      ? 1
+                      : 0;
+        }
+        auto elapsed_usec = (now_nsec() - start) / 1000.0;
+        protocol.stop_receiver();
+        std::cout << "[demux] " << std::left << std::setw(16) << (threaded ? "receive thread" : "caller thread") << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(6) << ok << "/" << cycles << " cycles, "
+                  << std::setw(8) << elapsed_usec / cycles << " us/cycle, "
+                  << std::setprecision(2) << (double)device.writes / cycles << " writes/cycle, "
+                  << protocol.heartbeat_count() << " heartbeats" << std::endl;
+    }
+}
+
+/*******************************************************************
+ *
+ * Allocation bench
+ *
+ * Heap allocations per control cycle (in0 + execute + out0) once the first cycles have warmed up buffers.
+ *
+ *******************************************************************/
+static void bench_alloc()
+{
+    const int warmup = 10;
+    const int cycles = 1000;
+    const std::string in_name = "in0";
+    const std::string out_name = "out0";
+    const uint8_t in[4] = {1, 2, 3, 4};
+    uint8_t out[4];
+    uint8_t size_read;
+
+    answering_device_t device;
+    device.latency_usec = 0;
+    protocol_t protocol(&device, LOGLEVEL::WARN, LOGLEVEL::WARN);
+    pipeline_t pipeline;
+
+    auto measure = [&](const std::string &label, const std::function<bool()> &cycle)
+    {
+        for (int i = 0; i < warmup; i++)
+        {
+            cycle();
+        }
+        int ok = 0;
+        auto before = g_allocations.load();
+        for (int i = 0; i < cycles; i++)
+        {
+            ok += cycle() ? 1 : 0;
+        }
+        auto allocations = g_allocations.load() - before;
+        std::cout << "[alloc] " << std::left << std::setw(16) << label << std::right << std::fixed << std::setprecision(2)
+                  << std::setw(6) << ok << "/" << cycles << " cycles, "
+                  << (double)allocations / cycles << " allocations/cycle" << std::endl;
+    };
+
+    measure("stop-and-wait", [&]()
+            { return protocol.send_inport_data(in_name, in, sizeof(in), 20 * 1000) == RESULT::OK &&
+                     protocol.execute(20 * 1000) == RESULT::OK &&
+                     protocol.receive_outport_data(out_name, out, sizeof(out), &size_read, 20 * 1000) == RESULT::OK; });
+    measure("run_pipeline", [&]()
+            {
+        pipeline.clear();
+        pipeline.send_inport_data(in_name, in, sizeof(in)).execute().receive_outport_data(out_name, out, sizeof(out), &size_read);
+        return protocol.run_pipeline(pipeline, 20 * 1000) == RESULT::OK; });
+
+    // FloatSeq in / out through the vector and the span APIs.
+    const std::vector<float> seq(60, 1.0f);
+    float received[60];
+    measure("seq_as (vector)", [&]()
+            { return protocol.send_seq_as<float>(in_name, seq, seq.size(), 20 * 1000) == RESULT::OK &&
+                     (bool)protocol.receive_seq_as<float>(out_name, 20 * 1000); });
+    measure("seq (span)", [&]()
+            { return protocol.send_seq<float>(in_name, seq, 20 * 1000) == RESULT::OK &&
+                     (bool)protocol.receive_seq_into<float>(out_name, received, 20 * 1000); });
+}
+
+/*******************************************************************
+ *
+ * Result bench
+ *
+ * refresh_profile() of a firmware with 8 inports and 8 outports. The profile is built once and moved
+ * into the cache, so any allocation beyond building it (one string per port) is a deep copy on the way.
+ * Then the lookup which print / inject in rtno2 do before each access, with and without the profile cache.
+ *
+ *******************************************************************/
+static void bench_result()
+{
+    const int calls = 200;
+    const int ports = 8;
+    answering_device_t device;
+    device.latency_usec = 0;
+    const uint8_t arch = (uint8_t)Architecture::ARM;
+    device.profile.emplace_back(COMMAND::PLATFORM_PROFILE, RESULT::OK, &arch, 1);
+    for (int i = 0; i < ports * 2; i++)
+    {
+        // Names longer than the small string buffer, so each copy of a name allocates.
+        std::string name = std::string(i < ports ? "long_inport_name_" : "long_outport_name_") + std::to_string(i);
+        std::vector<uint8_t> data = {(uint8_t)TYPECODE::TIMED_LONG};
+        data.insert(data.end(), name.begin(), name.end());
+        device.profile.emplace_back(i < ports ? COMMAND::INPORT_PROFILE : COMMAND::OUTPORT_PROFILE, RESULT::OK, data.data(), data.size());
+    }
+    protocol_t protocol(&device, LOGLEVEL::WARN, LOGLEVEL::WARN);
+    protocol.refresh_profile(20 * 1000);
+
+    int ok = 0;
+    auto before = g_allocations.load();
+    auto start = now_nsec();
+    for (int i = 0; i < calls; i++)
+    {
+        ok += (protocol.refresh_profile(20 * 1000) == RESULT::OK && protocol.cached_profile()->inports_.size() == ports) ? 1 : 0;
+    }
+    auto elapsed_usec = (now_nsec() - start) / 1000.0;
+    std::cout << "[result] refresh_profile() with " << ports << " inports + " << ports << " outports: " << ok << "/" << calls << " ok, "
+              << std::fixed << std::setprecision(1) << (double)(g_allocations.load() - before) / calls << " allocations/call, "
+              << elapsed_usec / calls << " us/call" << std::endl;
+
+    auto measure = [&](const std::string &label, const std::function<bool()> &lookup)
+    {
+        int ok = 0;
+        int writes = device.writes;
+        auto start = now_nsec();
+        for (int i = 0; i < calls; i++)
+        {
+            ok += lookup() ? 1 : 0;
+        }
+        std::cout << "[result] " << std::left << std::setw(24) << label << std::right << std::fixed << std::setprecision(2)
+                  << std::setw(6) << ok << "/" << calls << " lookups, "
+                  << std::setw(8) << (now_nsec() - start) / 1000.0 / calls << " us/lookup, "
+                  << (double)(device.writes - writes) / calls << " writes/lookup" << std::endl;
+    };
+    measure("refresh + outport()", [&]()
+            { return protocol.refresh_profile(20 * 1000) == RESULT::OK && protocol.cached_profile()->outport("long_outport_name_12"); });
+    measure("outport_profile() cached", [&]()
+            { return (bool)protocol.outport_profile("long_outport_name_12", 20 * 1000); });
+}
+
+/*******************************************************************
+ *
+ * Port lookup bench
+ *
+ * Profile with 32 inports. Looks up the 25th one by name (copying the port_profile_t out),
+ * by name to id, and by id.
+ *
+ *******************************************************************/
+static void bench_ports()
+{
+    const int ports = 32;
+    const int count = 1000000;
+    profile_t profile;
+    for (int i = 0; i < ports; i++)
+    {
+        std::string name = "long_inport_name_" + std::to_string(i);
+        profile.append_in_port(port_profile_t(TYPECODE::TIMED_LONG, name.c_str()));
+    }
+    const std::string name = "long_inport_name_24";
+    const port_id_t id = profile.inport_id(name);
+
+    auto measure = [&](const std::string &label, const std::function<bool()> &lookup)
+    {
+        int ok = 0;
+        auto before = g_allocations.load();
+        auto start = now_nsec();
+        for (int i = 0; i < count; i++)
+        {
+            ok += lookup() ? 1 : 0;
+        }
+        auto elapsed = now_nsec() - start;
+        std::cout << "[ports] " << std::left << std::setw(24) << label << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(8) << (double)elapsed / count << " ns/lookup, "
+                  << std::setprecision(2) << (double)(g_allocations.load() - before) / count << " allocations/lookup"
+                  << (ok == count ? "" : "  (lookup failed)") << std::endl;
+    };
+    measure("inport(name)", [&]()
+            { return (bool)profile.inport(name); });
+    measure("inport_id(name)", [&]()
+            { return profile.inport_id(name) == id; });
+    measure("inports_[id]", [&]()
+            { return profile.inports_[id.index].typecode() == TYPECODE::TIMED_LONG; });
+}
+
+/*******************************************************************
+ *
+ * Port handle bench
+ *
+ * Per-tick write / read of a TimedLong port through the name-based calls (send_as / receive_as)
+ * and through handles from inport<T>() / outport<T>(), against a device answering immediately.
+ *
+ *******************************************************************/
+static void bench_handle()
+{
+    const int warmup = 10;
+    const int calls = 5000;
+    answering_device_t device;
+    device.latency_usec = 0;
+    const uint8_t arch = (uint8_t)Architecture::ARM;
+    device.profile.emplace_back(COMMAND::PLATFORM_PROFILE, RESULT::OK, &arch, 1);
+    const std::string in_name = "long_inport_name_0";
+    const std::string out_name = "long_outport_name_0";
+    for (auto port : {std::make_pair(COMMAND::INPORT_PROFILE, in_name), std::make_pair(COMMAND::OUTPORT_PROFILE, out_name)})
+    {
+        std::vector<uint8_t> data = {(uint8_t)TYPECODE::TIMED_LONG};
+        data.insert(data.end(), port.second.begin(), port.second.end());
+        device.profile.emplace_back(port.first, RESULT::OK, data.data(), data.size());
+    }
+    protocol_t protocol(&device, LOGLEVEL::WARN, LOGLEVEL::WARN);
+
+    auto in = protocol.inport<int32_t>(in_name, 20 * 1000);
+    auto out = protocol.outport<int32_t>(out_name, 20 * 1000);
+    auto mismatch = protocol.inport<float>(in_name, 20 * 1000);
+    if (!in || !out || mismatch.error() != RESULT::ERR)
+    {
+        std::cout << "[handle] resolve failed (inport=" << result_to_string(in.error()) << ", outport=" << result_to_string(out.error())
+                  << ", mismatch=" << result_to_string(mismatch.error()) << ")" << std::endl;
+        return;
+    }
+
+    auto measure = [&](const std::string &label, const std::function<bool(int32_t)> &call)
+    {
+        for (int i = 0; i < warmup; i++)
+        {
+            call(i);
+        }
+        int ok = 0;
+        auto before = g_allocations.load();
+        auto start = now_nsec();
+        for (int i = 0; i < calls; i++)
+        {
+            ok += call(i) ? 1 : 0;
+        }
+        auto elapsed = now_nsec() - start;
+        std::cout << "[handle] " << std::left << std::setw(24) << label << std::right << std::fixed << std::setprecision(2)
+                  << std::setw(6) << ok << "/" << calls << " calls, "
+                  << std::setw(8) << elapsed / 1000.0 / calls << " us/call, "
+                  << (double)(g_allocations.load() - before) / calls << " allocations/call" << std::endl;
+    };
+    measure("send_as<int32_t>", [&](int32_t v)
+            { return protocol.send_as<int32_t>(in_name, v, 20 * 1000) == RESULT::OK; });
+    measure("inport_t::write", [&](int32_t v)
+            { return in->write(v, 20 * 1000) == RESULT::OK; });
+    measure("receive_as<int32_t>", [&](int32_t)
+            {
+        auto value = protocol.receive_as<int32_t>(out_name, 20 * 1000);
+        return value && *value == 0x04030201; });
+    measure("outport_t::read", [&](int32_t)
+            {
+        auto value = out->read(20 * 1000);
+        return value && *value == 0x04030201; });
+}
+
+/*******************************************************************
+ *
+ * Codec bench
+ *
+ * 60-element sequences, the largest FloatSeq (240 bytes) and AVR DoubleSeq that fit in one packet.
+ * Element-by-element conversion (what send_seq_as / into_vec did) vs the codec kernels,
+ * and vector decoding vs decoding into caller storage.
+ *
+ *******************************************************************/
+template <typename T>
+static std::vector<T> legacy_into_vec(const uint8_t *buf, const uint8_t size)
+{
+    int length = size / sizeof(T);
+    std::vector<T> val;
+    for (int i = 0; i < length; i++)
+    {
+        val.push_back(*(T *)(buf + i * sizeof(T)));
+    }
+    return val;
+}
+
+static void bench_codec()
+{
+    const size_t elements = 60;
+    const int count = 200000;
+    std::vector<double> doubles(elements);
+    std::vector<float> floats(elements);
+    for (size_t i = 0; i < elements; i++)
+    {
+        doubles[i] = i * 0.25;
+        floats[i] = static_cast<float>(i * 0.25);
+    }
+    uint8_t wire[PACKET_MAX_DATA_SIZE + 1];
+    uint8_t *unaligned = wire + 1; // payload follows name_len | data_len | name, so it is rarely aligned.
+    element_codec<float>::encode(unaligned, floats.data(), elements, sizeof(float));
+    double decoded[elements];
+    volatile double sink = 0;
+
+    auto measure = [&](const std::string &label, const std::function<void()> &convert)
+    {
+        auto before = g_allocations.load();
+        auto start = now_nsec();
+        for (int i = 0; i < count; i++)
+        {
+            convert();
+        }
+        auto elapsed = now_nsec() - start;
+        std::cout << "[codec] " << std::left << std::setw(32) << label << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(8) << (double)elapsed / count << " ns/sequence, "
+                  << std::setprecision(2) << (double)(g_allocations.load() - before) / count << " allocations/sequence" << std::endl;
+    };
+
+    measure("DoubleSeq->AVR scalar loop", [&]()
+            {
+        for (size_t i = 0; i < elements; i++)
+        {
+            const float f = static_cast<float>(doubles[i]);
+            memcpy(unaligned + i * sizeof(float), &f, sizeof(float));
+        }
+        sink = unaligned[5]; });
+    measure("DoubleSeq->AVR codec", [&]()
+            {
+        element_codec<double>::encode(unaligned, doubles.data(), elements, sizeof(float));
+        sink = unaligned[5]; });
+    measure("AVR->DoubleSeq scalar loop", [&]()
+            {
+        for (size_t i = 0; i < elements; i++)
+        {
+            float f;
+            memcpy(&f, unaligned + i * sizeof(float), sizeof(float));
+            decoded[i] = f;
+        }
+        sink = decoded[5]; });
+    measure("AVR->DoubleSeq codec", [&]()
+            {
+        element_codec<double>::decode(decoded, unaligned, elements, sizeof(float));
+        sink = decoded[5]; });
+    measure("FloatSeq legacy into_vec", [&]()
+            { sink = legacy_into_vec<float>(unaligned, elements * sizeof(float))[5]; });
+    measure("FloatSeq value_codec (vector)", [&]()
+            { sink = (*value_codec<std::vector<float>>::decode(unaligned, elements * sizeof(float), wire_format_t{sizeof(float), false}))[5]; });
+    measure("FloatSeq codec into storage", [&]()
+            {
+        element_codec<float>::decode(floats.data(), unaligned, elements, sizeof(float));
+        sink = floats[5]; });
+}
+
+/*******************************************************************
+ *
+ * Packed BooleanSeq bench
+ *
+ * 64-element TimedBooleanSeq sent to the simulator and read back from a connected outport,
+ * with the packed encoding offered and not. Checks the round trip through each API and counts
+ * the bytes on the link (57600 baud, 10 bits per byte). Then the host pack / unpack kernels.
+ *
+ *******************************************************************/
+static void bench_packed()
+{
+    const size_t elements = 64;
+    bool pattern[elements];
+    std::vector<bool> pattern_vec(elements);
+    for (size_t i = 0; i < elements; i++)
+    {
+        pattern[i] = pattern_vec[i] = (i * 7 + i / 3) % 3 == 0;
+    }
+
+    for (auto offered : {(uint8_t)0, CAPABILITY_PACKED_BOOLEAN_SEQ})
+    {
+        simulator_t device;
+        device.add_inport(TYPECODE::TIMED_BOOLEAN_SEQ, "bools_in");
+        device.add_outport(TYPECODE::TIMED_BOOLEAN_SEQ, "bools_out");
+        device.connect("bools_in", "bools_out");
+        protocol_t protocol(&device, LOGLEVEL::WARN, LOGLEVEL::WARN);
+        protocol.set_offered_capabilities(offered);
+        protocol.refresh_profile(20 * 1000);
+        protocol.activate(20 * 1000);
+
+        bool ok = true;
+        // span API
+        auto sent = device.bytes_received();
+        ok &= protocol.send_seq<bool>("bools_in", pattern, 20 * 1000) == RESULT::OK;
+        sent = device.bytes_received() - sent;
+        ok &= protocol.execute(20 * 1000) == RESULT::OK;
+        bool received[elements] = {};
+        auto replied = device.bytes_sent();
+        auto count = protocol.receive_seq_into<bool>("bools_out", received, 20 * 1000);
+        replied = device.bytes_sent() - replied;
+        ok &= count && *count == elements && memcmp(received, pattern, elements) == 0;
+        // vector API
+        ok &= protocol.send_seq_as<bool>("bools_in", pattern_vec, elements, 20 * 1000) == RESULT::OK && protocol.execute(20 * 1000) == RESULT::OK;
+        auto vec = protocol.receive_seq_as<bool>("bools_out", 20 * 1000);
+        ok &= vec && *vec == pattern_vec;
+        // port handles
+        auto in = protocol.inport<std::vector<bool>>("bools_in", 20 * 1000);
+        auto out = protocol.outport<std::vector<bool>>("bools_out", 20 * 1000);
+        ok &= in && out && in->write(pattern_vec, 20 * 1000) == RESULT::OK && protocol.execute(20 * 1000) == RESULT::OK;
+        auto handle_vec = out ? out->read(20 * 1000) : result_t<std::vector<bool>>(RESULT::ERR);
+        ok &= handle_vec && *handle_vec == pattern_vec;
+
+        std::cout << "[packed] " << (offered ? "packed  " : "unpacked") << " capabilities=" << (int)protocol.capabilities()
+                  << " round trip " << (ok ? "OK" : "FAILED") << ", SEND_DATA " << sent << " bytes ("
+                  << std::fixed << std::setprecision(2) << sent * 10 * 1000.0 / 57600 << " ms), RECEIVE_DATA reply "
+                  << replied << " bytes (" << replied * 10 * 1000.0 / 57600 << " ms)" << std::endl;
+    }
+
+    const int count = 1000000;
+    uint8_t bits[(elements + 7) / 8];
+    bool unpacked[elements];
+    volatile uint8_t sink = 0;
+    auto measure = [&](const std::string &label, const std::function<void()> &convert)
+    {
+        auto start = now_nsec();
+        for (int i = 0; i < count; i++)
+        {
+            convert();
+        }
+        std::cout << "[packed] " << std::left << std::setw(20) << label << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(8) << (double)(now_nsec() - start) / count << " ns/sequence" << std::endl;
+    };
+    measure("pack scalar", [&]()
+            {
+        memset(bits, 0, sizeof(bits));
+        for (size_t i = 0; i < elements; i++)
+        {
+            bits[i / 8] |= (pattern[i] ? 1 : 0) << (i % 8);
+        }
+        sink = bits[3]; });
+    measure("pack kernel", [&]()
+            {
+        codec_pack_bool(bits, pattern, elements);
+        sink = bits[3]; });
+    measure("unpack scalar", [&]()
+            {
+        for (size_t i = 0; i < elements; i++)
+        {
+            unpacked[i] = ((bits[i / 8] >> (i % 8)) & 1) != 0;
+        }
+        sink = unpacked[5]; });
+    measure("unpack kernel", [&]()
+            {
+        codec_unpack_bool(unpacked, bits, elements);
+        sink = unpacked[5]; });
+}
+
+/**
+ * Sequences larger than one packet (1-4 KB of TimedDoubleSeq) sent, looped back by EXECUTE and received again
+ * through the simulator, with CAPABILITY_FRAGMENTED_DATA. Without the capability the same send_seq fails.
+ */
+static void bench_fragment()
+{
+    for (auto offered : {(uint8_t)0, CAPABILITY_FRAGMENTED_DATA})
+    {
+        simulator_t device;
+        device.add_inport(TYPECODE::TIMED_DOUBLE_SEQ, "seq_in");
+        device.add_outport(TYPECODE::TIMED_DOUBLE_SEQ, "seq_out");
+        device.connect("seq_in", "seq_out");
+        protocol_t protocol(&device, LOGLEVEL::NONE, LOGLEVEL::NONE);
+        protocol.set_offered_capabilities(offered);
+        protocol.refresh_profile(20 * 1000);
+        protocol.activate(20 * 1000);
+
+        for (size_t kbytes : {1, 2, 4})
+        {
+            const size_t elements = kbytes * 1024 / sizeof(double);
+            std::vector<double> value(elements), received(elements);
+            for (size_t i = 0; i < elements; i++)
+            {
+                value[i] = i * 0.25 - 3.0;
+            }
+            auto cycle = [&]()
+            {
+                bool ok = protocol.send_seq<double>("seq_in", value, 20 * 1000) == RESULT::OK;
+                ok = ok && protocol.execute(20 * 1000) == RESULT::OK;
+                auto count = protocol.receive_seq_into<double>("seq_out", received, 20 * 1000);
+                return ok && count && *count == elements;
+            };
+            if (!cycle())
+            {
+                std::cout << "[fragment] " << (offered ? "fragmented  " : "unfragmented") << " " << kbytes << " KB: "
+                          << (offered ? "FAILED" : "rejected (does not fit in a packet)") << std::endl;
+                continue;
+            }
+
+            const int count = 5000;
+            bool ok = true;
+            const auto sent = device.bytes_received();
+            const auto replied = device.bytes_sent();
+            const auto allocations = g_allocations.load();
+            const auto start = now_nsec();
+            for (int i = 0; i < count; i++)
+            {
+                ok &= cycle();
+            }
+            const double usec = (double)(now_nsec() - start) / count / 1000;
+            ok &= received == value;
+            const double wire = (double)(device.bytes_received() - sent + device.bytes_sent() - replied) / count;
+            std::cout << "[fragment] " << (offered ? "fragmented  " : "unfragmented") << " " << kbytes << " KB round trip " << (ok ? "OK" : "FAILED")
+                      << std::fixed << std::setprecision(1) << ": " << std::setw(7) << usec << " us/cycle, "
+                      << std::setw(7) << 2 * kbytes * 1024 / usec << " MB/s, "
+                      << std::setw(6) << wire << " wire bytes/cycle (" << std::setprecision(0) << wire * 10 * 1000.0 / 115200 << " ms at 115200), "
+                      << std::setprecision(2) << (double)(g_allocations.load() - allocations) / count << " allocs/cycle" << std::endl;
+        }
+    }
+}
+
+/**
+ * Framing V1 (8-bit sum) against V2 (frame id, CRC-16).
+ *  - corruption: random bit flips inside frames, counting corrupted packets the decoder delivers as valid
+ *  - round trip: control cycle through the simulator with each framing negotiated
+ *  - cost: encode + decode of a full (255-byte) packet
+ */
+static void bench_framing()
+{
+    std::mt19937 rng(20261016);
+    const int trials = 200000;
+    for (auto framing : {FRAMING::V1, FRAMING::V2})
+    {
+        for (int flips : {1, 2, 3, 4, 8})
+        {
+            uint64_t delivered_corrupt = 0;
+            for (int trial = 0; trial < trials; trial++)
+            {
+                uint8_t payload[32];
+                for (auto &b : payload)
+                {
+                    b = static_cast<uint8_t>(rng());
+                }
+                const packet_t packet(COMMAND::SEND_DATA, RESULT::OK, payload, sizeof(payload));
+                uint8_t frame[FRAME_MAX_SIZE * 2];
+                const size_t size = encode_frame(frame, packet, packet.getSum(), framing, static_cast<uint8_t>(trial));
+                for (int i = 0; i < flips; i++)
+                {
+                    // Start bytes excluded: a broken start only delays synchronization.
+                    const size_t bit = 16 + rng() % ((size - 2) * 8);
+                    frame[bit / 8] ^= static_cast<uint8_t>(1 << (bit % 8));
+                }
+                // A valid frame behind flushes a corrupted length.
+                const size_t total = size + encode_frame(frame + size, packet, packet.getSum(), framing, static_cast<uint8_t>(trial));
+                frame_decoder_t decoder;
+                decoder.set_negotiated(framing);
+                size_t writable;
+                memcpy(decoder.prepare(writable), frame, total);
+                decoder.commit(total);
+                while (true)
+                {
+                    auto decoded = decoder.decode();
+                    if (decoded.error() == RESULT::NOT_AVAILABLE)
+                    {
+                        break;
+                    }
+                    if (decoded && (decoded->getPacketLength() != packet.getPacketLength() || memcmp(decoded->serialize(), packet.serialize(), packet.getPacketLength()) != 0))
+                    {
+                        delivered_corrupt++;
+                    }
+                }
+            }
+            std::cout << "[framing] " << (framing == FRAMING::V1 ? "V1 sum8 " : "V2 crc16") << " " << flips << " bit flips: "
+                      << std::setw(6) << delivered_corrupt << " / " << trials << " corrupted frames delivered" << std::endl;
+        }
+    }
+
+    for (auto offered : {(uint8_t)0, CAPABILITY_FRAMING_V2})
+    {
+        simulator_t device;
+        device.add_inport(TYPECODE::TIMED_LONG, "in0");
+        device.add_outport(TYPECODE::TIMED_LONG, "out0");
+        device.connect("in0", "out0");
+        protocol_t protocol(&device, LOGLEVEL::WARN, LOGLEVEL::WARN);
+        protocol.set_offered_capabilities(offered);
+        protocol.refresh_profile(20 * 1000);
+        protocol.activate(20 * 1000);
+
+        const int count = 5000;
+        bool ok = true;
+        const auto bytes = device.bytes_received() + device.bytes_sent();
+        const auto start = now_nsec();
+        for (int32_t i = 0; i < count; i++)
+        {
+            ok &= protocol.send_as<int32_t>("in0", i, 20 * 1000) == RESULT::OK && protocol.execute(20 * 1000) == RESULT::OK;
+            auto value = protocol.receive_as<int32_t>("out0", 20 * 1000);
+            ok &= value && *value == i;
+        }
+        const double usec = (double)(now_nsec() - start) / count / 1000;
+        const double wire = (double)(device.bytes_received() + device.bytes_sent() - bytes) / count;
+
+        int32_t in = 7, out = 0;
+        uint8_t size_read = 0;
+        pipeline_t pipeline;
+        pipeline.send_inport_data("in0", (const uint8_t *)&in, sizeof(in)).execute().receive_outport_data("out0", (uint8_t *)&out, sizeof(out), &size_read);
+        ok &= protocol.run_pipeline(pipeline, 20 * 1000) == RESULT::OK && out == in;
+
+        std::cout << "[framing] " << (protocol.framing() == FRAMING::V1 ? "V1" : "V2") << " control cycle " << (ok ? "OK" : "FAILED")
+                  << std::fixed << std::setprecision(2) << ": " << usec << " us/cycle, " << std::setprecision(1) << wire << " wire bytes/cycle" << std::endl;
+    }
+
+    uint8_t payload[PACKET_MAX_DATA_SIZE];
+    for (size_t i = 0; i < sizeof(payload); i++)
+    {
+        payload[i] = static_cast<uint8_t>(i * 31);
+    }
+    const packet_t packet(COMMAND::SEND_DATA, RESULT::OK, payload, sizeof(payload));
+    for (auto framing : {FRAMING::V1, FRAMING::V2})
+    {
+        const int count = 200000;
+        frame_decoder_t decoder;
+        bool ok = true;
+        const auto start = now_nsec();
+        for (int i = 0; i < count; i++)
+        {
+            size_t writable;
+            uint8_t *dst = decoder.prepare(writable);
+            decoder.commit(encode_frame(dst, packet, packet.getSum(), framing, static_cast<uint8_t>(i)));
+            ok &= decoder.decode().has_value();
+        }
+        std::cout << "[framing] " << (framing == FRAMING::V1 ? "V1" : "V2") << " encode+decode 255-byte packet " << (ok ? "OK" : "FAILED") << ": "
+                  << std::fixed << std::setprecision(1) << (double)(now_nsec() - start) / count << " ns/frame" << std::endl;
+    }
+}
+
+/**
+ * One control cycle over three inports and three outports (TimedLong, TimedDoubleSeq of 4, TimedBoolean) through the simulator:
+ * stop-and-wait requests, run_pipeline, and run_cycle with and without CAPABILITY_BATCH_CYCLE.
+ * Wire time is bytes * 10 / baud; the latency of each round trip (and per-frame firmware work) adds to it at a real link.
+ */
+static void bench_cycle()
+{
+    for (auto offered : {(uint8_t)0, CAPABILITY_BATCH_CYCLE})
+    {
+        simulator_t device;
+        const char *ports[3][2] = {{"in0", "out0"}, {"in1", "out1"}, {"in2", "out2"}};
+        const TYPECODE typecodes[3] = {TYPECODE::TIMED_LONG, TYPECODE::TIMED_DOUBLE_SEQ, TYPECODE::TIMED_BOOLEAN};
+        for (int i = 0; i < 3; i++)
+        {
+            device.add_inport(typecodes[i], ports[i][0]);
+            device.add_outport(typecodes[i], ports[i][1]);
+            device.connect(ports[i][0], ports[i][1]);
+        }
+        protocol_t protocol(&device, LOGLEVEL::NONE, LOGLEVEL::NONE);
+        protocol.set_offered_capabilities(offered);
+        protocol.refresh_profile(20 * 1000);
+        protocol.activate(20 * 1000);
+        auto profile = protocol.get_profile(20 * 1000);
+        if (!profile)
+        {
+            std::cout << "[cycle] FAILED to get profile" << std::endl;
+            return;
+        }
+
+        const port_id_t in_ids[3] = {profile->inport_id("in0"), profile->inport_id("in1"), profile->inport_id("in2")};
+        int32_t in0 = 0;
+        const float in1[4] = {0.5f, 1.5f, 2.5f, 3.5f};
+        const uint8_t in2 = 1;
+        uint8_t out[3][PACKET_MAX_DATA_SIZE];
+        uint8_t sizes[3];
+        pipeline_t pipeline;
+        cycle_t cycle;
+        auto check = [&](const uint8_t *out0, const uint8_t size0, const uint8_t size1)
+        {
+            return size0 == sizeof(in0) && memcmp(out0, &in0, sizeof(in0)) == 0 && size1 == sizeof(in1);
+        };
+
+        std::vector<std::pair<std::string, std::function<bool()>>> modes = {
+            {"stop-and-wait ", [&]()
+             {
+                 bool ok = protocol.send_inport_data("in0", (const uint8_t *)&in0, sizeof(in0), 20 * 1000) == RESULT::OK;
+                 ok &= protocol.send_inport_data("in1", (const uint8_t *)in1, sizeof(in1), 20 * 1000) == RESULT::OK;
+                 ok &= protocol.send_inport_data("in2", &in2, sizeof(in2), 20 * 1000) == RESULT::OK;
+                 ok &= protocol.execute(20 * 1000) == RESULT::OK;
+                 for (int i = 0; i < 3; i++)
+                 {
+                     ok &= protocol.receive_outport_data(ports[i][1], out[i], sizeof(out[i]), &sizes[i], 20 * 1000) == RESULT::OK;
+                 }
+                 return ok && check(out[0], sizes[0], sizes[1]);
+             }},
+            {"run_pipeline  ", [&]()
+             {
+                 pipeline.clear();
+                 pipeline.send_inport_data("in0", (const uint8_t *)&in0, sizeof(in0)).send_inport_data("in1", (const uint8_t *)in1, sizeof(in1)).send_inport_data("in2", &in2, sizeof(in2));
+                 pipeline.execute();
+                 for (int i = 0; i < 3; i++)
+                 {
+                     pipeline.receive_outport_data(ports[i][1], out[i], sizeof(out[i]), &sizes[i]);
+                 }
+                 return protocol.run_pipeline(pipeline, 20 * 1000) == RESULT::OK && check(out[0], sizes[0], sizes[1]);
+             }},
+            {"run_cycle     ", [&]()
+             {
+                 cycle.clear();
+                 cycle.send_inport_data(in_ids[0], (const uint8_t *)&in0, sizeof(in0)).send_inport_data(in_ids[1], (const uint8_t *)in1, sizeof(in1)).send_inport_data(in_ids[2], &in2, sizeof(in2));
+                 cycle.execute().receive_all_outports(*profile);
+                 return protocol.run_cycle(cycle, 20 * 1000) == RESULT::OK && check(cycle.value(0).data(), (uint8_t)cycle.value(0).size(), (uint8_t)cycle.value(1).size());
+             }},
+        };
+        // Round trips a cycle waits for, and frames on the wire in both directions.
+        const int round_trips[3] = {7, 1, 1};
+        const int frames[3] = {14, 14, offered ? 2 : 14};
+        for (size_t m = 0; m < modes.size(); m++)
+        {
+            if (offered && m < 2)
+            {
+                continue; // same as without the capability
+            }
+            const int count = 5000;
+            bool ok = true;
+            const auto bytes = device.bytes_received() + device.bytes_sent();
+            const auto start = now_nsec();
+            for (int i = 0; i < count; i++)
+            {
+                in0 = i;
+                ok &= modes[m].second();
+            }
+            const double usec = (double)(now_nsec() - start) / count / 1000;
+            const double wire = (double)(device.bytes_received() + device.bytes_sent() - bytes) / count;
+            std::cout << "[cycle] " << modes[m].first << (offered ? "batch   " : "no batch") << " " << (ok ? "OK" : "FAILED")
+                      << std::fixed << std::setprecision(1) << ": " << std::setw(6) << usec << " us/cycle, "
+                      << round_trips[m] << " round trip(s), " << std::setw(2) << frames[m] << " frames, " << std::setw(5) << wire << " wire bytes/cycle ("
+                      << std::setprecision(2) << wire * 10 * 1000.0 / 57600 << " ms at 57600, "
+                      << wire * 10 * 1000.0 / 115200 << " ms at 115200)" << std::endl;
+        }
+    }
+}
+
+/**
+ * Control cycles (SEND_DATA + EXECUTE + RECEIVE_DATA of a TimedLong) through the simulator behind an emulated
+ * 115200 baud link, clean and with latency, jitter, drops, bit flips and burst losses. Every attempt times out
+ * after 30 ms; a cycle fails when its 500 ms deadline passes. Wrong counts cycles which returned OK with a value
+ * other than the one sent (corruption the frame check let through).
+ */
+static void bench_link()
+{
+    struct condition_t
+    {
+        const char *label;
+        link_config_t config;
+    };
+    auto make = [](const uint32_t latency_usec, const uint32_t jitter_usec, const double drop_rate, const double bit_error_rate, const double burst_rate)
+    {
+        link_config_t config;
+        config.baudrate = 115200;
+        config.latency_usec = latency_usec;
+        config.jitter_usec = jitter_usec;
+        config.drop_rate = drop_rate;
+        config.bit_error_rate = bit_error_rate;
+        config.burst_rate = burst_rate;
+        config.seed = 20261017;
+        return config;
+    };
+    const condition_t conditions[] = {
+        {"clean", make(0, 0, 0, 0, 0)},
+        {"latency 1ms jitter 1ms", make(1000, 1000, 0, 0, 0)},
+        {"drop 1e-3", make(0, 0, 1e-3, 0, 0)},
+        {"bit errors 1e-4", make(0, 0, 0, 1e-4, 0)},
+        {"bit errors 1e-3", make(0, 0, 0, 1e-3, 0)},
+        {"bursts 1e-3 x 16 bytes", make(0, 0, 0, 0, 1e-3)},
+    };
+    const retry_policy_t policy(15, 30 * 1000);
+    for (auto offered : {(uint8_t)0, CAPABILITY_FRAMING_V2})
+    {
+        for (auto &condition : conditions)
+        {
+            loopback_t link(condition.config);
+            simulator_t device;
+            device.add_inport(TYPECODE::TIMED_LONG, "in0");
+            device.add_outport(TYPECODE::TIMED_LONG, "out0");
+            device.connect("in0", "out0");
+            bridge_t bridge(link.b(), device);
+            protocol_t protocol(&link.a(), LOGLEVEL::NONE, LOGLEVEL::NONE);
+            protocol.set_offered_capabilities(offered);
+            bool ready = false;
+            for (int i = 0; i < 10 && !ready; i++)
+            {
+                ready = protocol.refresh_profile(deadline_after(500 * 1000), policy) == RESULT::OK && protocol.activate(deadline_after(500 * 1000), policy) == RESULT::OK;
+            }
+            if (!ready)
+            {
+                std::cout << "[link] " << condition.label << ": FAILED to activate" << std::endl;
+                continue;
+            }
+
+            const int count = 200;
+            int failed = 0, wrong = 0;
+            std::vector<double> latencies;
+            const auto start = now_nsec();
+            for (int32_t i = 0; i < count; i++)
+            {
+                const auto begin = now_nsec();
+                const auto deadline = deadline_after(500 * 1000);
+                auto result = protocol.send_as<int32_t>("in0", i, deadline, policy);
+                if (result == RESULT::OK)
+                {
+                    result = protocol.execute(deadline, policy);
+                }
+                result_t<int32_t> value = result;
+                if (result == RESULT::OK)
+                {
+                    value = protocol.receive_as<int32_t>("out0", deadline, policy);
+                }
+                latencies.push_back((now_nsec() - begin) / 1e6);
+                if (!value)
+                {
+                    failed++;
+                }
+                else if (*value != i)
+                {
+                    wrong++;
+                }
+            }
+            const double seconds = (now_nsec() - start) / 1e9;
+            const auto down = link.a_to_b_statistics();
+            const auto up = link.b_to_a_statistics();
+            std::cout << "[link] " << (protocol.framing() == FRAMING::V1 ? "V1 " : "V2 ") << std::left << std::setw(24) << condition.label << std::right
+                      << std::fixed << std::setprecision(1) << std::setw(6) << count / seconds << " cycles/s, p50 " << std::setprecision(2)
+                      << std::setw(6) << percentile(latencies, 0.5) << " ms, p99 " << std::setw(7) << percentile(latencies, 0.99) << " ms, max "
+                      << std::setw(7) << percentile(latencies, 1.0) << " ms, failed " << std::setw(3) << failed << ", wrong " << std::setw(2) << wrong
+                      << " (" << down.dropped + up.dropped << " bytes dropped, " << down.flipped + up.flipped << " bits flipped)" << std::endl;
+        }
+    }
+}
+
+/**
+ * Listening TCP socket on 127.0.0.1 with an ephemeral port, standing in for a TCP-attached RTno.
+ */
+class tcp_listener_t
+{
+public:
+    int listen_fd;
+    uint16_t port;
+
+public:
+    tcp_listener_t() : listen_fd(socket(AF_INET, SOCK_STREAM, 0)), port(0)
+    {
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t length = sizeof(addr);
+        if (listen_fd < 0 || bind(listen_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(listen_fd, 4) < 0 ||
+            getsockname(listen_fd, (struct sockaddr *)&addr, &length) < 0)
+        {
+            throw std::runtime_error("listen failed");
+        }
+        port = ntohs(addr.sin_port);
+    }
+
+    ~tcp_listener_t()
+    {
+        close(listen_fd);
+    }
+
+    int accept_one()
+    {
+        return accept(listen_fd, NULL, NULL);
+    }
+};
+
+/**
+ * Several EtherTcp instances in one process, each receiving its own byte pattern from a local server.
+ * Corrupt counts bytes that differ from what the instance's own server sent (one stream leaking into another).
+ * Then, per receive mode, the round trip of a 16-byte frame echoed by the server and the CPU that
+ * 4 idle instances burn in one second.
+ */
+static void bench_ethertcp()
+{
+    const size_t total = 4 * 1024 * 1024;
+    const ssr::EtherTcp::ReceiveMode modes[] = {ssr::EtherTcp::RECEIVE_THREAD, ssr::EtherTcp::RECEIVE_ON_READ};
+    const char *mode_names[] = {"RECEIVE_THREAD ", "RECEIVE_ON_READ"};
+    for (int m = 0; m < 2; m++)
+    {
+        for (int instances : {1, 4})
+        {
+            std::vector<std::unique_ptr<tcp_listener_t>> listeners;
+            std::vector<std::unique_ptr<ssr::EtherTcp>> devices;
+            std::vector<int> peers;
+            for (int k = 0; k < instances; k++)
+            {
+                listeners.emplace_back(new tcp_listener_t());
+                devices.emplace_back(new ssr::EtherTcp("127.0.0.1", listeners[k]->port, modes[m]));
+                peers.push_back(listeners[k]->accept_one());
+            }
+
+            std::atomic<uint64_t> corrupt(0);
+            std::vector<std::thread> threads;
+            const auto start = now_nsec();
+            for (int k = 0; k < instances; k++)
+            {
+                threads.emplace_back([&, k]()
+                                     {
+                    uint8_t chunk[4096];
+                    for (size_t sent = 0; sent < total;)
+                    {
+                        const size_t n = std::min(sizeof(chunk), total - sent);
+                        for (size_t i = 0; i < n; i++)
+                        {
+                            chunk[i] = static_cast<uint8_t>((sent + i) * 7 + k);
+                        }
+                        const ssize_t written = send(peers[k], chunk, n, 0);
+                        if (written <= 0)
+                        {
+                            return;
+                        }
+                        sent += written;
+                    } });
+                threads.emplace_back([&, k]()
+                                     {
+                    uint8_t chunk[255];
+                    size_t received = 0;
+                    uint64_t errors = 0;
+                    while (received < total && devices[k]->waitRxReady(1000 * 1000) > 0)
+                    {
+                        const ssr::RETVAL n = devices[k]->read(chunk, sizeof(chunk));
+                        for (ssr::RETVAL i = 0; i < n; i++)
+                        {
+                            errors += chunk[i] != static_cast<uint8_t>((received + i) * 7 + k);
+                        }
+                        received += n;
+                    }
+                    corrupt += errors + (total - received); });
+            }
+            for (auto &thread : threads)
+            {
+                thread.join();
+            }
+            const double seconds = (now_nsec() - start) / 1e9;
+            for (int fd : peers)
+            {
+                close(fd);
+            }
+            std::cout << "[ethertcp] " << mode_names[m] << " " << instances << " instance(s): " << std::fixed << std::setprecision(1) << std::setw(7)
+                      << instances * total / seconds / 1e6 << " MB/s total, corrupt or missing " << corrupt << " / " << instances * total << " bytes" << std::endl;
+            devices.clear();
+        }
+    }
+
+    for (int m = 0; m < 2; m++)
+    {
+        std::vector<std::unique_ptr<tcp_listener_t>> listeners;
+        std::vector<std::unique_ptr<ssr::EtherTcp>> devices;
+        std::vector<int> peers;
+        for (int k = 0; k < 4; k++)
+        {
+            listeners.emplace_back(new tcp_listener_t());
+            devices.emplace_back(new ssr::EtherTcp("127.0.0.1", listeners[k]->port, modes[m]));
+            peers.push_back(listeners[k]->accept_one());
+        }
+
+        std::thread echo([&]()
+                         {
+            uint8_t buffer[256];
+            ssize_t n;
+            while ((n = recv(peers[0], buffer, sizeof(buffer), 0)) > 0)
+            {
+                send(peers[0], buffer, n, 0);
+            } });
+        const int count = 5000;
+        std::vector<double> latencies;
+        bool ok = true;
+        for (int i = 0; i < count; i++)
+        {
+            uint8_t frame[16], reply[16];
+            memset(frame, i, sizeof(frame));
+            const auto begin = now_nsec();
+            devices[0]->write(frame, sizeof(frame));
+            size_t received = 0;
+            while (received < sizeof(reply) && devices[0]->waitRxReady(1000 * 1000) > 0)
+            {
+                received += devices[0]->read(reply + received, static_cast<uint8_t>(sizeof(reply) - received));
+            }
+            latencies.push_back((now_nsec() - begin) / 1e3);
+            ok &= received == sizeof(reply) && memcmp(frame, reply, sizeof(frame)) == 0;
+        }
+        shutdown(peers[0], SHUT_RDWR);
+        echo.join();
+
+        // Idle: a reader per device waiting for data that never comes.
+        struct timespec ts;
+        clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+        const double cpu_start = ts.tv_sec + ts.tv_nsec * 1e-9;
+        std::vector<std::thread> readers;
+        for (int k = 1; k < 4; k++)
+        {
+            readers.emplace_back([&, k]()
+                                 {
+                const auto until = now_nsec() + 1000000000LL;
+                while (now_nsec() < until)
+                {
+                    devices[k]->waitRxReady(100 * 1000);
+                } });
+        }
+        for (auto &reader : readers)
+        {
+            reader.join();
+        }
+        clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+        const double cpu = ts.tv_sec + ts.tv_nsec * 1e-9 - cpu_start;
+        for (int fd : peers)
+        {
+            close(fd);
+        }
+        std::cout << "[ethertcp] " << mode_names[m] << " round trip " << (ok ? "OK" : "FAILED") << std::fixed << std::setprecision(1)
+                  << ": p50 " << percentile(latencies, 0.5) << " us, p99 " << percentile(latencies, 0.99) << " us; 4 devices idle for 1 s: "
+                  << std::setprecision(1) << cpu * 100 << " % CPU" << std::endl;
+        devices.clear();
+    }
+}
+
+/**
+ * Server end of a TCP connection as a SerialDevice, to put a simulator_t behind it with bridge_t.
+ */
+class socket_device_t : public ssr::SerialDevice
+{
+private:
+    int fd_;
+
+public:
+    socket_device_t(const int fd) : fd_(fd) {}
+
+public:
+    void flushRxBuffer() {}
+    void flushTxBuffer() {}
+    ssr::RETVAL getSizeInRxBuffer()
+    {
+        int count = 0;
+        return ioctl(fd_, FIONREAD, &count) == 0 ? count : -1;
+    }
+    ssr::RETVAL write(const uint8_t *src, const uint8_t size) { return static_cast<ssr::RETVAL>(send(fd_, src, size, 0)); }
+    ssr::RETVAL writeMore(const uint8_t *src, const uint8_t size) { return static_cast<ssr::RETVAL>(send(fd_, src, size, MSG_MORE)); }
+    ssr::RETVAL read(uint8_t *dst, const uint8_t size)
+    {
+        const ssize_t n = recv(fd_, dst, size, MSG_DONTWAIT);
+        return n > 0 ? static_cast<ssr::RETVAL>(n) : 0;
+    }
+    ssr::RETVAL getSenderInfo(uint8_t *) { return 0; }
+    int getFileDescriptor() { return fd_; }
+};
+
+/**
+ * Device passing writeMore() on as write(), as transport_t wrote before frames were corked.
+ */
+class uncorked_device_t : public ssr::SerialDevice
+{
+private:
+    ssr::SerialDevice &device_;
+
+public:
+    uncorked_device_t(ssr::SerialDevice &device) : device_(device) {}
+
+public:
+    void flushRxBuffer() { device_.flushRxBuffer(); }
+    void flushTxBuffer() { device_.flushTxBuffer(); }
+    ssr::RETVAL getSizeInRxBuffer() { return device_.getSizeInRxBuffer(); }
+    ssr::RETVAL write(const uint8_t *src, const uint8_t size) { return device_.write(src, size); }
+    ssr::RETVAL read(uint8_t *dst, const uint8_t size) { return device_.read(dst, size); }
+    ssr::RETVAL getSenderInfo(uint8_t *buffer) { return device_.getSenderInfo(buffer); }
+    ssr::RETVAL waitRxReady(const uint32_t timeout_usec) { return device_.waitRxReady(timeout_usec); }
+};
+
+/**
+ * Round trips to the simulator behind a loopback TCP connection: as before (Nagle, delayed ACK, a frame longer
+ * than one device write sent in two writes) and tuned (TCP_NODELAY, quick-ack, frames corked with MSG_MORE).
+ * A 248-byte value makes the SEND_DATA frame longer than 255 bytes, the most one device write takes.
+ */
+static void bench_tcp()
+{
+    for (bool tuned : {false, true})
+    {
+        tcp_listener_t listener;
+        ssr::EtherTcp client("127.0.0.1", listener.port, ssr::EtherTcp::RECEIVE_ON_READ);
+        const int server_fd = listener.accept_one();
+        const int value = tuned ? 1 : 0;
+        setsockopt(server_fd, IPPROTO_TCP, TCP_NODELAY, &value, sizeof(value));
+        client.getSocket().setNoDelay(tuned);
+        client.getSocket().setQuickAck(tuned);
+
+        socket_device_t server(server_fd);
+        simulator_t device;
+        device.add_inport(TYPECODE::TIMED_OCTET_SEQ, "in0");
+        device.add_outport(TYPECODE::TIMED_OCTET_SEQ, "out0");
+        device.connect("in0", "out0");
+        bridge_t bridge(server, device);
+        uncorked_device_t uncorked(client);
+        protocol_t protocol(tuned ? (ssr::SerialDevice *)&client : &uncorked, LOGLEVEL::NONE, LOGLEVEL::NONE);
+        protocol.set_offered_capabilities(0);
+        protocol.refresh_profile(1000 * 1000);
+        protocol.activate(1000 * 1000);
+
+        std::vector<uint8_t> data(248);
+        for (size_t i = 0; i < data.size(); i++)
+        {
+            data[i] = static_cast<uint8_t>(i);
+        }
+        uint8_t out[PACKET_MAX_DATA_SIZE];
+        uint8_t size_read = 0;
+        std::vector<std::pair<std::string, std::function<bool()>>> calls = {
+            {"send 248-byte value    ", [&]()
+             { return protocol.send_inport_data("in0", data.data(), static_cast<uint8_t>(data.size()), 1000 * 1000) == RESULT::OK; }},
+            {"execute                ", [&]()
+             { return protocol.execute(1000 * 1000) == RESULT::OK; }},
+            {"receive 248-byte value ", [&]()
+             { return protocol.receive_outport_data("out0", out, sizeof(out), &size_read, 1000 * 1000) == RESULT::OK && size_read == data.size(); }},
+        };
+        for (auto &call : calls)
+        {
+            const int count = 200;
+            bool ok = true;
+            std::vector<double> latencies;
+            for (int i = 0; i < count; i++)
+            {
+                if (&call == &calls.back())
+                {
+                    // An outport value is read once; write the next one untimed.
+                    ok &= calls[0].second() && calls[1].second();
+                }
+                const auto begin = now_nsec();
+                ok &= call.second();
+                latencies.push_back((now_nsec() - begin) / 1e3);
+            }
+            std::cout << "[tcp] " << (tuned ? "tuned  " : "before ") << call.first << (ok ? "OK" : "FAILED")
+                      << std::fixed << std::setprecision(1) << ": p50 " << std::setw(8) << percentile(latencies, 0.5) << " us, p99 "
+                      << std::setw(8) << percentile(latencies, 0.99) << " us" << std::endl;
+        }
+        close(server_fd);
+    }
+}
+
+/**
+ * com2tcp's relay_t, with a pty per serial device whose master end echoes what it receives (each request frame
+ * comes back as its own reply). "direct" is the echo without TCP and the relay. Pairs each have one client; a shared
+ * port has several clients, each sending SEND_DATA with its own value, and "wrong" counts replies carrying another
+ * client's value. Monitoring clients all poll GET_STATE, which the relay coalesces: "on serial" is the number of
+ * transactions written per client request. Then the CPU that the whole process burns in one second with every client
+ * connected but silent.
+ */
+static void bench_relay()
+{
+    const int count = 2000;
+    auto send_data_frame = [](const int k)
+    {
+        const uint8_t value[16] = {(uint8_t)k, (uint8_t)(k >> 8)};
+        return serialize_frame(packet_t(COMMAND::SEND_DATA, RESULT::OK, value, sizeof(value)));
+    };
+    auto get_state_frame = [](const int)
+    {
+        return serialize_frame(packet_t(COMMAND::GET_STATE, RESULT::OK));
+    };
+
+    // Write one frame to fd and read as many bytes back. false if nothing came back.
+    auto round_trip = [](const int fd, const std::vector<uint8_t> &frame, std::vector<uint8_t> &reply)
+    {
+        if (::write(fd, frame.data(), frame.size()) != (ssize_t)frame.size())
+        {
+            return false;
+        }
+        reply.resize(frame.size());
+        size_t received = 0;
+        struct pollfd pfd = {fd, POLLIN, 0};
+        while (received < reply.size() && poll(&pfd, 1, 1000) > 0)
+        {
+            const ssize_t n = ::read(fd, reply.data() + received, reply.size() - received);
+            if (n <= 0)
+            {
+                return false;
+            }
+            received += n;
+        }
+        return received == reply.size();
+    };
+
+    struct firmware_t
+    {
+        std::vector<std::unique_ptr<pty_pair_t>> ptys;
+        std::atomic<bool> running;
+        std::thread thread;
+
+        firmware_t(const int count) : running(true)
+        {
+            for (int k = 0; k < count; k++)
+            {
+                ptys.emplace_back(new pty_pair_t());
+            }
+            thread = std::thread([this]()
+                                 {
+                std::vector<struct pollfd> pfds;
+                for (auto &pty : ptys)
+                {
+                    pfds.push_back({pty->master_fd, POLLIN, 0});
+                }
+                uint8_t buffer[4096];
+                while (running)
+                {
+                    if (poll(pfds.data(), pfds.size(), 100) <= 0)
+                    {
+                        continue;
+                    }
+                    for (auto &pfd : pfds)
+                    {
+                        const ssize_t n = (pfd.revents & POLLIN) ? ::read(pfd.fd, buffer, sizeof(buffer)) : 0;
+                        if (n > 0 && ::write(pfd.fd, buffer, n) != n)
+                        {
+                            return;
+                        }
+                    }
+                } });
+        }
+
+        ~firmware_t()
+        {
+            running = false;
+            thread.join();
+        }
+    };
+
+    {
+        firmware_t firmware(1);
+        const auto frame = send_data_frame(0);
+        std::vector<uint8_t> reply;
+        std::vector<double> latencies;
+        bool ok = true;
+        for (int i = 0; i < count; i++)
+        {
+            const auto begin = now_nsec();
+            ok &= round_trip(firmware.ptys[0]->slave_fd, frame, reply) && reply == frame;
+            latencies.push_back((now_nsec() - begin) / 1e3);
+        }
+        std::cout << "[relay] direct pty              " << (ok ? "OK" : "FAILED") << std::fixed << std::setprecision(1) << ": p50 " << std::setw(6)
+                  << percentile(latencies, 0.5) << " us, p99 " << std::setw(6) << percentile(latencies, 0.99) << " us" << std::endl;
+    }
+
+    struct scenario_t
+    {
+        std::string name;
+        int pairs;
+        int clients; // per pair
+        std::function<std::vector<uint8_t>(int)> frame_of;
+    };
+    const std::vector<scenario_t> scenarios = {
+        {"1 pair                 ", 1, 1, send_data_frame},
+        {"4 pairs                ", 4, 1, send_data_frame},
+        {"4 clients on 1 port    ", 1, 4, send_data_frame},
+        {"1 monitoring client    ", 1, 1, get_state_frame},
+        {"8 monitoring clients   ", 1, 8, get_state_frame},
+    };
+    for (auto &scenario : scenarios)
+    {
+        firmware_t firmware(scenario.pairs);
+        relay_t relay(LOGLEVEL::WARN);
+        std::vector<uint16_t> ports;
+        for (int k = 0; k < scenario.pairs; k++)
+        {
+            {
+                tcp_listener_t probe; // borrow a free port number
+                ports.push_back(probe.port);
+            }
+            relay.add(firmware.ptys[k]->slave_fd, ports[k]);
+        }
+        std::thread relay_thread([&relay]()
+                                 { relay.run(); });
+
+        std::vector<int> clients;
+        for (int k = 0; k < scenario.pairs * scenario.clients; k++)
+        {
+            struct sockaddr_in addr;
+            memset(&addr, 0, sizeof(addr));
+            addr.sin_family = AF_INET;
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            addr.sin_port = htons(ports[k % scenario.pairs]);
+            const int fd = socket(AF_INET, SOCK_STREAM, 0);
+            const int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+            {
+                throw std::runtime_error("connect failed");
+            }
+            clients.push_back(fd);
+        }
+
+        std::vector<std::vector<double>> latencies(clients.size());
+        std::atomic<int> failed(0), wrong(0);
+        std::vector<std::thread> threads;
+        for (size_t k = 0; k < clients.size(); k++)
+        {
+            threads.emplace_back([&, k]()
+                                 {
+                const auto frame = scenario.frame_of((int)k);
+                std::vector<uint8_t> reply;
+                for (int i = 0; i < count; i++)
+                {
+                    const auto begin = now_nsec();
+                    if (!round_trip(clients[k], frame, reply))
+                    {
+                        failed++;
+                        continue;
+                    }
+                    latencies[k].push_back((now_nsec() - begin) / 1e3);
+                    wrong += reply != frame;
+                } });
+        }
+        for (auto &thread : threads)
+        {
+            thread.join();
+        }
+        std::vector<double> all;
+        for (auto &l : latencies)
+        {
+            all.insert(all.end(), l.begin(), l.end());
+        }
+
+        struct timespec ts;
+        clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+        const double cpu_start = ts.tv_sec + ts.tv_nsec * 1e-9;
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+        clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+        const double cpu = ts.tv_sec + ts.tv_nsec * 1e-9 - cpu_start;
+
+        for (int fd : clients)
+        {
+            close(fd);
+        }
+        relay.stop();
+        relay_thread.join();
+
+        const auto &statistics = relay.statistics();
+        const double requests = (double)clients.size() * count;
+        std::cout << "[relay] " << scenario.name << " " << (failed == 0 ? "OK" : "FAILED") << std::fixed << std::setprecision(1) << ": p50 "
+                  << std::setw(6) << percentile(all, 0.5) << " us, p99 " << std::setw(6) << percentile(all, 0.99) << " us, wrong " << wrong
+                  << ", on serial " << std::setprecision(2) << statistics.transactions / requests << ", " << std::setprecision(1)
+                  << statistics.wakeups / requests << " wakeups per request; idle for 1 s: " << cpu * 100 << " % CPU" << std::endl;
+    }
+}
+
+/*******************************************************************
+ *
+ * main
+ *
+ *******************************************************************/
+int main(const int argc, const char *argv[])
+{
+    std::vector<std::pair<std::string, std::function<void()>>> benches = {
+        {"wait", bench_wait_policy},
+        {"decode", bench_decode},
+        {"send", bench_send},
+        {"retry", bench_retry},
+        {"pipeline", bench_pipeline},
+        {"demux", bench_demux},
+        {"alloc", bench_alloc},
+        {"result", bench_result},
+        {"ports", bench_ports},
+        {"handle", bench_handle},
+        {"codec", bench_codec},
+        {"packed", bench_packed},
+        {"fragment", bench_fragment},
+        {"framing", bench_framing},
+        {"cycle", bench_cycle},
+        {"link", bench_link},
+        {"ethertcp", bench_ethertcp},
+        {"tcp", bench_tcp},
+        {"relay", bench_relay},
+    };
+
+    std::string name = argc >= 2 ? argv[1] : "all";
+    bool found = false;
+    for (auto &bench : benches)
+    {
+        if (name == "all" || name == bench.first)
+        {
+            bench.second();
+            found = true;
+        }
+    }
+    if (!found)
+    {
+        std::cout << "Usage: rtno_bench [all";
+        for (auto &bench : benches)
+        {
+            std::cout << "|" << bench.first;
+        }
+        std::cout << "]" << std::endl;
+        return -1;
+    }
+    return 0;
+}
@@ -57,164 +57,137 @@ std::vector<T> atois(const std::string &str, const char delim, const std::functi
 }
 
 template <typename T>
-struct is_vector : std::false_type
+inline std::string value_to_string(const T &value)
 {
-};
+    std::stringstream ss;
+    ss << value;
+    return ss.str();
+}
 
-template <typename T, typename Alloc>
-struct is_vector<std::vector<T, Alloc>> : std::true_type
+template <>
+inline std::string value_to_string<bool>(const bool &value)
 {
-};
+    return value ? "true" : "false";
+}
 
-template <typename T, typename = std::enable_if_t<std::is_same_v<T, int> || std::is_same_v<T, float> || std::is_same_v<T, double>>>
-std::string result_t_to_string(const result_t<T> &result)
+template <>
+inline std::string value_to_string<uint8_t>(const uint8_t &value)
+{
+    return std::to_string(value);
+}
+
+template <typename T>
+inline std::string value_to_string(const std::vector<T> &value)
 {
-    if (result.result == ::RESULT::OK)
+    std::stringstream ss;
+    ss << "[";
+    for (size_t i = 0; i < value.size(); i++)
     {
-        std::stringstream ss;
-        ss << "RESULT::OK(" << result.value.value() << ")";
-        return ss.str();
+        ss << (i == 0 ? "" : ",") << value_to_string<T>(value[i]);
     }
-    return result_to_string(result.result);
+    ss << "]";
+    return ss.str();
 }
 
 template <typename T>
-std::string result_t_to_string(const ::result_t<std::vector<T>> &result)
+std::string result_t_to_string(const result_t<T> &result)
 {
-    if (result.result == RESULT::OK)
+    if (result.error() == RESULT::OK)
     {
-        std::stringstream ss;
-        ss << "RESULT::OK([" << strjoin(result.value.value()) << "])";
-        return ss.str();
+        return "RESULT::OK(" + value_to_string(*result) + ")";
     }
-    return result_to_string(result.result);
+    return result_to_string(result.error());
+}
+
+template <typename T>
+inline T parse_value(const std::string &str)
+{
+    return static_cast<T>(atof(str.c_str()));
 }
 
+template <>
+inline bool parse_value<bool>(const std::string &str)
+{
+    return str == "true" || str == "1";
+}
+
+template <>
+inline char parse_value<char>(const std::string &str)
+{
+    return str.empty() ? 0 : str[0];
+}
+
+template <>
+inline uint8_t parse_value<uint8_t>(const std::string &str)
+{
+    return static_cast<uint8_t>(atoi(str.c_str()));
+}
+
+template <>
+inline int32_t parse_value<int32_t>(const std::string &str)
+{
+    return atoi(str.c_str());
+}
+
+/**
+ * Scalars are given as one value, sequences as comma separated values.
+ * TimedCharSeq takes the string as is.
+ */
+template <typename T>
+struct value_parser
+{
+    static T parse(const std::string &str) { return parse_value<T>(str); }
+};
+
+template <typename T>
+struct value_parser<std::vector<T>>
+{
+    static std::vector<T> parse(const std::string &str)
+    {
+        return atois<T>(str, ',', [](const std::string &s)
+                        { return parse_value<T>(s); });
+    }
+};
+
+template <>
+struct value_parser<std::vector<char>>
+{
+    static std::vector<char> parse(const std::string &str) { return std::vector<char>(str.begin(), str.end()); }
+};
+
 std::string print(logger_t &logger, protocol_t &rtno, const std::string &name_str)
 {
     RTNO_TRACE(logger, "print({})", name_str);
-    auto result = rtno.get_profile(1000 * 1000);
-    if (result.result != RESULT::OK)
+    auto port = rtno.outport_profile(name_str, 1000 * 1000);
+    if (port.error() != RESULT::OK)
     {
-        return result_to_string(result.result);
+        return result_to_string(port.error());
     }
-    auto prof = result.value.value();
-    RTNO_DEBUG(logger, " - getProfile -> {}", prof.to_string());
-    for (auto port : prof.outports_)
-    {
-        if (port.name() == name_str)
-        {
-            auto type_code = port.typecode();
-            if (type_code == TYPECODE::TIMED_BOOLEAN)
-            {
-            }
-            else if (type_code == TYPECODE::TIMED_CHAR)
-            {
-            }
-            else if (type_code == TYPECODE::TIMED_LONG)
-            {
-                auto val = rtno.receive_as<int32_t>(name_str);
-                return result_t_to_string(val);
-            }
-            else if (type_code == TYPECODE::TIMED_FLOAT)
-            {
-                auto val = rtno.receive_as<float>(name_str);
-                return result_t_to_string(val);
-            }
-            else if (type_code == TYPECODE::TIMED_DOUBLE)
-            {
-                auto val = rtno.receive_as<double>(name_str);
-                return result_t_to_string(val);
-            }
-            else if (type_code == TYPECODE::TIMED_LONG_SEQ)
-            {
-                auto v = rtno.receive_seq_as<int32_t>(name_str);
-                return result_t_to_string(v);
-            }
-            else if (type_code == TYPECODE::TIMED_FLOAT_SEQ)
-            {
-                auto v = rtno.receive_seq_as<float>(name_str);
-                return result_t_to_string(v);
-            }
-            else if (type_code == TYPECODE::TIMED_DOUBLE_SEQ)
-            {
-                auto v = rtno.receive_seq_as<double>(name_str);
-                return result_t_to_string(v);
-            }
-            else
-            {
-                return result_to_string(RESULT::ERR);
-            }
-        }
-    }
-    return result_to_string(RESULT::OUTPORT_NOT_FOUND);
+    RTNO_DEBUG(logger, " - outport_profile -> {}", port->to_string());
+    std::string str = result_to_string(RESULT::ERR);
+    visit_port(port->typecode(), [&](auto traits)
+               {
+        auto outport = rtno.outport<typename decltype(traits)::value_type>(name_str);
+        str = outport ? result_t_to_string(outport->read()) : result_to_string(outport.error()); });
+    return str;
 }
 
 RESULT inject(logger_t &logger, protocol_t &rtno, const std::string &name_str, const std::string &data_str)
 {
     RTNO_DEBUG(logger, "inject({}, {})", name_str, data_str);
-    auto result = rtno.get_profile(1000 * 1000);
-    if (result.result != RESULT::OK)
-    {
-        return result.result;
-    }
-    auto prof = result.value.value();
-    RTNO_DEBUG(logger, " - getProfile -> {}", prof.to_string());
-    for (auto port : prof.inports_)
+    auto port = rtno.inport_profile(name_str, 1000 * 1000);
+    if (port.error() != RESULT::OK)
     {
-        if (port.name() == name_str)
-        {
-            auto type_code = port.typecode();
-            if (type_code == TYPECODE::TIMED_BOOLEAN)
-            {
-                uint8_t data = data_str == "true" ? 1 : 0;
-                return rtno.send_inport_data(name_str, (uint8_t *)(&data), sizeof(uint8_t));
-            }
-            else if (type_code == TYPECODE::TIMED_CHAR)
-            {
-                char data = data_str.c_str()[0];
-                return rtno.send_inport_data(name_str, (uint8_t *)(&data), sizeof(char));
-            }
-            else if (type_code == TYPECODE::TIMED_LONG)
-            {
-                int32_t data = atoi(data_str.c_str());
-                return rtno.send_inport_data(name_str, (uint8_t *)(&data), sizeof(int32_t));
-            }
-            else if (type_code == TYPECODE::TIMED_FLOAT)
-            {
-                float data = atof(data_str.c_str());
-                return rtno.send_inport_data(name_str, (uint8_t *)(&data), sizeof(float));
-            }
-            else if (type_code == TYPECODE::TIMED_DOUBLE)
-            {
-                double data = atof(data_str.c_str());
-                return rtno.send_inport_data(name_str, (uint8_t *)(&data), sizeof(double));
-            }
-            else if (type_code == TYPECODE::TIMED_LONG_SEQ)
-            {
-                auto data = atois<int32_t>(data_str, ',', [](const std::string &s)
-                                           { return atoi(s.c_str()); });
-                return rtno.send_inport_data(name_str, (uint8_t *)(&data), data.size() * sizeof(int32_t));
-            }
-            else if (type_code == TYPECODE::TIMED_FLOAT_SEQ)
-            {
-                auto data = atois<float>(data_str, ',', [](const std::string &s)
-                                         { return (float)atof(s.c_str()); });
-                return rtno.send_inport_data(name_str, (uint8_t *)(&data), data.size() * sizeof(float));
-            }
-            else if (type_code == TYPECODE::TIMED_DOUBLE_SEQ)
-            {
-                auto data = atois<double>(data_str, ',', [](const std::string &s)
-                                          { return atof(s.c_str()); });
-                return rtno.send_inport_data(name_str, (uint8_t *)(&data), data.size() * sizeof(double));
-            }
-            else
-            {
-                return RESULT::OK;
-            }
-        }
+        return port.error();
     }
-    return RESULT::INPORT_NOT_FOUND;
+    RTNO_DEBUG(logger, " - inport_profile -> {}", port->to_string());
+    RESULT result = RESULT::ERR;
+    visit_port(port->typecode(), [&](auto traits)
+               {
+        using value_type = typename decltype(traits)::value_type;
+        auto inport = rtno.inport<value_type>(name_str);
+        result = inport ? inport->write(value_parser<value_type>::parse(data_str)) : inport.error(); });
+    return result;
 }
 
 ssr::SerialDevice *create_serial(const std::string &filename, const int int_arg)
@@ -223,7 +196,7 @@ ssr::SerialDevice *create_serial(const std::string &filename, const int int_arg)
     {
         try
         {
-            return new ssr::EtherTcp(filename.substr(6).c_str(), int_arg);
+            return new ssr::EtherTcp(filename.substr(6).c_str(), int_arg, ssr::EtherTcp::RECEIVE_ON_READ);
         }
         catch (ssr::SocketException &se)
         {
@@ -249,50 +222,50 @@ int do_main(logger_t &logger, protocol_t &rtno, const std::string &command, cons
 {
     if (command == "getprofile")
     {
-        auto prof = rtno.get_profile(wait_usec);
-        if (prof.result != RESULT::OK)
+        auto result = rtno.refresh_profile(wait_usec);
+        if (result != RESULT::OK)
         {
-            std::cout << result_to_string(prof.result) << std::endl;
+            std::cout << result_to_string(result) << std::endl;
         }
         else
         {
-            std::cout << prof.value.value().to_string() << std::endl;
+            std::cout << rtno.cached_profile()->to_string() << std::endl;
         }
     }
     else if (command == "getlog")
     {
         auto logresult = rtno.get_log(wait_usec);
-        if (logresult.result != RESULT::OK)
+        if (logresult.error() != RESULT::OK)
         {
-            std::cout << result_to_string(logresult.result) << std::endl;
+            std::cout << result_to_string(logresult.error()) << std::endl;
         }
         else
         {
-            std::cout << logresult.value.value() << std::endl;
+            std::cout << *logresult << std::endl;
         }
     }
     else if (command == "getstate")
     {
         auto state = rtno.get_state(wait_usec);
-        if (state.result != RESULT::OK)
+        if (state.error() != RESULT::OK)
         {
-            std::cout << result_to_string(state.result) << std::endl;
+            std::cout << result_to_string(state.error()) << std::endl;
         }
         else
         {
-            std::cout << state_to_string(state.value.value()) << std::endl;
+            std::cout << state_to_string(*state) << std::endl;
         }
     }
     else if (command == "getectype")
     {
         auto ectype = rtno.get_ec_type(wait_usec);
-        if (ectype.result != RESULT::OK)
+        if (ectype.error() != RESULT::OK)
         {
-            std::cout << result_to_string(ectype.result) << std::endl;
+            std::cout << result_to_string(ectype.error()) << std::endl;
         }
         else
         {
-            std::cout << ec_type_to_string(ectype.value.value()) << std::endl;
+            std::cout << ec_type_to_string(*ectype) << std::endl;
         }
     }
     else if (command == "activate")
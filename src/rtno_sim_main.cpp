@@ -0,0 +1,206 @@
+#include "rtno2/simulator.h"
+
+#include <iostream>
+#include <csignal>
+#include <cstring>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <vector>
+#include <string>
+#include <type_traits>
+
+using namespace ssr::rtno2;
+
+static std::atomic<bool> stop_requested(false);
+
+static void on_signal(int)
+{
+    stop_requested = true;
+}
+
+static void print_usage()
+{
+    std::cout << "Usage: rtno_sim [options]" << std::endl;
+    std::cout << "  Serve a simulated RTno on a pseudo terminal and print its name (e.g. /dev/pts/3)." << std::endl;
+    std::cout << "  Open it with rtno2, rtno_test or com2tcp like a serial port. Ctrl+C to stop." << std::endl;
+    std::cout << "Options:" << std::endl;
+    std::cout << "  -a AVR|ARM|ESP32           architecture (default ARM)" << std::endl;
+    std::cout << "  -e MAINLOOP|PROXY_SYNCHRONOUS|FSP_TIMER|TIMER_ONE  execution context type (default PROXY_SYNCHRONOUS)" << std::endl;
+    std::cout << "  -d usec                    processing delay of each request (default 0)" << std::endl;
+    std::cout << "  -b usec                    heartbeat interval (default 0, no heartbeat)" << std::endl;
+    std::cout << "  -c capabilities            supported CAPABILITY_* flags (default all)" << std::endl;
+    std::cout << "  -i TYPE:name               add inport, TYPE as TimedLong, TimedDoubleSeq, ..." << std::endl;
+    std::cout << "  -o TYPE:name               add outport" << std::endl;
+    std::cout << "  -l inport:outport          copy inport to outport on EXECUTE" << std::endl;
+    std::cout << "  Without -i / -o, the ports rtno_test expects (bool_in / bool_out ... double_seq_in / double_seq_out)." << std::endl;
+}
+
+static bool parse_typecode(const std::string &name, TYPECODE *typecode)
+{
+    for (const char code : std::string("bocldfBOCLFD"))
+    {
+        if (typecode_to_str((TYPECODE)code) == name)
+        {
+            *typecode = (TYPECODE)code;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool split(const std::string &arg, std::string *first, std::string *second)
+{
+    const auto colon = arg.find(':');
+    if (colon == std::string::npos)
+    {
+        return false;
+    }
+    *first = arg.substr(0, colon);
+    *second = arg.substr(colon + 1);
+    return true;
+}
+
+/**
+ * Ports of the rtno_test sketch. Outports start from the value rtno_test expects before each test
+ * ('a' for chars, false for bools, 1 otherwise), and each inport is copied to its outport on EXECUTE.
+ */
+static void add_test_ports(simulator_t &simulator, const Architecture architecture)
+{
+    const std::pair<TYPECODE, const char *> ports[] = {
+        {TYPECODE::TIMED_BOOLEAN, "bool"},
+        {TYPECODE::TIMED_CHAR, "char"},
+        {TYPECODE::TIMED_OCTET, "octet"},
+        {TYPECODE::TIMED_LONG, "long"},
+        {TYPECODE::TIMED_FLOAT, "float"},
+        {TYPECODE::TIMED_DOUBLE, "double"},
+        {TYPECODE::TIMED_BOOLEAN_SEQ, "bool_seq"},
+        {TYPECODE::TIMED_CHAR_SEQ, "char_seq"},
+        {TYPECODE::TIMED_OCTET_SEQ, "octet_seq"},
+        {TYPECODE::TIMED_LONG_SEQ, "long_seq"},
+        {TYPECODE::TIMED_FLOAT_SEQ, "float_seq"},
+        {TYPECODE::TIMED_DOUBLE_SEQ, "double_seq"},
+    };
+    for (const auto &port : ports)
+    {
+        std::vector<uint8_t> initial;
+        visit_port(port.first, [&](auto traits)
+                   {
+            using element_type = typename decltype(traits)::element_type;
+            if constexpr (std::is_same_v<element_type, double>)
+            {
+                // AVR's double is a float.
+                if (architecture == Architecture::AVR)
+                {
+                    const float value = 1.0f;
+                    initial.assign((const uint8_t *)&value, (const uint8_t *)&value + sizeof(value));
+                    return;
+                }
+            }
+            const element_type value = std::is_same_v<element_type, bool> ? (element_type)0 : std::is_same_v<element_type, char> ? (element_type)'a' : (element_type)1;
+            initial.assign((const uint8_t *)&value, (const uint8_t *)&value + sizeof(value)); });
+        const std::string name = port.second;
+        simulator.add_inport(port.first, name + "_in");
+        simulator.add_outport(port.first, name + "_out", initial);
+        simulator.connect(name + "_in", name + "_out");
+    }
+}
+
+int main(const int argc, const char *argv[])
+{
+    Architecture architecture = Architecture::ARM;
+    EC_TYPE ec_type = EC_TYPE::PROXY_SYNCHRONOUS;
+    uint32_t delay_usec = 0;
+    uint32_t heartbeat_usec = 0;
+    uint8_t capabilities = CAPABILITY_PACKED_BOOLEAN_SEQ | CAPABILITY_FRAGMENTED_DATA | CAPABILITY_FRAMING_V2 | CAPABILITY_BATCH_CYCLE;
+    std::vector<std::pair<TYPECODE, std::string>> inports, outports;
+    std::vector<std::pair<std::string, std::string>> connections;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string option = argv[i];
+        if (option == "-h" || option == "--help" || i + 1 >= argc)
+        {
+            print_usage();
+            return option == "-h" || option == "--help" ? 0 : -1;
+        }
+        const std::string value = argv[++i];
+        std::string first, second;
+        TYPECODE typecode;
+        if (option == "-a")
+        {
+            architecture = value == "AVR" ? Architecture::AVR : value == "ESP32" ? Architecture::ESP32 : Architecture::ARM;
+        }
+        else if (option == "-e")
+        {
+            ec_type = value == "MAINLOOP" ? EC_TYPE::MAINLOOP : value == "FSP_TIMER" ? EC_TYPE::FSP_TIMER : value == "TIMER_ONE" ? EC_TYPE::TIMER_ONE : EC_TYPE::PROXY_SYNCHRONOUS;
+        }
+        else if (option == "-d")
+        {
+            delay_usec = atoi(value.c_str());
+        }
+        else if (option == "-b")
+        {
+            heartbeat_usec = atoi(value.c_str());
+        }
+        else if (option == "-c")
+        {
+            capabilities = static_cast<uint8_t>(strtol(value.c_str(), NULL, 0));
+        }
+        else if ((option == "-i" || option == "-o") && split(value, &first, &second) && parse_typecode(first, &typecode))
+        {
+            (option == "-i" ? inports : outports).emplace_back(typecode, second);
+        }
+        else if (option == "-l" && split(value, &first, &second))
+        {
+            connections.emplace_back(first, second);
+        }
+        else
+        {
+            std::cout << "ERROR: invalid option " << option << " " << value << std::endl;
+            print_usage();
+            return -1;
+        }
+    }
+
+    simulator_t simulator(architecture, capabilities);
+    simulator.set_ec_type(ec_type);
+    simulator.set_processing_delay(delay_usec);
+    simulator.set_heartbeat_interval(heartbeat_usec);
+    if (inports.empty() && outports.empty())
+    {
+        add_test_ports(simulator, architecture);
+    }
+    for (auto &port : inports)
+    {
+        simulator.add_inport(port.first, port.second);
+    }
+    for (auto &port : outports)
+    {
+        simulator.add_outport(port.first, port.second);
+    }
+    for (auto &connection : connections)
+    {
+        if (!simulator.connect(connection.first, connection.second))
+        {
+            std::cout << "ERROR: can not connect " << connection.first << " to " << connection.second << std::endl;
+            return -1;
+        }
+    }
+
+    simulator_pty_t pty(simulator);
+    if (pty.open() != RESULT::OK)
+    {
+        std::cout << "ERROR: can not open pty (" << strerror(errno) << ")" << std::endl;
+        return -1;
+    }
+    std::signal(SIGINT, on_signal);
+    std::signal(SIGTERM, on_signal);
+    std::cout << pty.name() << std::endl;
+    while (!stop_requested)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    pty.close();
+    return 0;
+}
@@ -19,156 +19,156 @@ void do_test(ssr::rtno2::logger_t &logger, ssr::rtno2::protocol_t &protocol)
 {
     const int retry_count = 100;
     auto prof_result = protocol.get_profile(100 * 1000, retry_count);
-    if (prof_result.result != ssr::rtno2::RESULT::OK)
+    if (prof_result.error() != ssr::rtno2::RESULT::OK)
     {
-        RTNO_ERROR(logger, "[TEST][FAILED] Getting profile failed. {}", ssr::rtno2::result_to_string(prof_result.result));
+        RTNO_ERROR(logger, "[TEST][FAILED] Getting profile failed. {}", ssr::rtno2::result_to_string(prof_result.error()));
         return;
     }
-    RTNO_DEBUG(logger, "[TEST] Profile: {}", prof_result.value.value().to_string());
-    auto profile = prof_result.value.value();
+    RTNO_DEBUG(logger, "[TEST] Profile: {}", prof_result->to_string());
+    const auto &profile = *prof_result;
     // 以降はポートが存在する場合にのみテストを実行する
 
     // std::this_thread::sleep_for(std::chrono::milliseconds(1000));
     // Bool test
     auto bool_in_result = profile.inport("bool_in");
     auto bool_out_result = profile.outport("bool_out");
-    if (bool_in_result.result == ssr::rtno2::RESULT::OK && bool_out_result.result == ssr::rtno2::RESULT::OK)
+    if (bool_in_result.error() == ssr::rtno2::RESULT::OK && bool_out_result.error() == ssr::rtno2::RESULT::OK)
     {
         conduct_send_and_recv_test<bool>("Bool data test. Send true then recv it", logger, protocol, "bool_in", "bool_out", false, true);
         conduct_send_and_recv_test<bool>("Bool negative data test. Send false then recv it", logger, protocol, "bool_in", "bool_out", false, false);
     }
     else
     {
-        RTNO_WARN(logger, "[TEST] Skipping Bool data test. bool_in or bool_out port not found. in({}), out({})", ssr::rtno2::result_to_string(bool_in_result.result), ssr::rtno2::result_to_string(bool_out_result.result));
+        RTNO_WARN(logger, "[TEST] Skipping Bool data test. bool_in or bool_out port not found. in({}), out({})", ssr::rtno2::result_to_string(bool_in_result.error()), ssr::rtno2::result_to_string(bool_out_result.error()));
     }
 
     // Char test
     auto char_in_result = profile.inport("char_in");
     auto char_out_result = profile.outport("char_out");
-    if (char_in_result.result == ssr::rtno2::RESULT::OK && char_out_result.result == ssr::rtno2::RESULT::OK)
+    if (char_in_result.error() == ssr::rtno2::RESULT::OK && char_out_result.error() == ssr::rtno2::RESULT::OK)
     {
         conduct_send_and_recv_test<char>("Character data test. Send 'c' then recv it", logger, protocol, "char_in", "char_out", 'a', 'c');
     }
     else
     {
-        RTNO_WARN(logger, "[TEST] Skipping Character data test. char_in or char_out port not found. in({}), out({})", ssr::rtno2::result_to_string(char_in_result.result), ssr::rtno2::result_to_string(char_out_result.result));
+        RTNO_WARN(logger, "[TEST] Skipping Character data test. char_in or char_out port not found. in({}), out({})", ssr::rtno2::result_to_string(char_in_result.error()), ssr::rtno2::result_to_string(char_out_result.error()));
     }
 
     // Octet test
     auto octet_in_result = profile.inport("octet_in");
     auto octet_out_result = profile.outport("octet_out");
-    if (octet_in_result.result == ssr::rtno2::RESULT::OK && octet_out_result.result == ssr::rtno2::RESULT::OK)
+    if (octet_in_result.error() == ssr::rtno2::RESULT::OK && octet_out_result.error() == ssr::rtno2::RESULT::OK)
     {
         conduct_send_and_recv_test<uint8_t>("Octet data test. Send 0x32 then recv it", logger, protocol, "octet_in", "octet_out", 0x01, 0x32);
     }
     else
     {
-        RTNO_WARN(logger, "[TEST] Skipping Octet data test. octet_in or octet_out port not found. in({}), out({})", ssr::rtno2::result_to_string(octet_in_result.result), ssr::rtno2::result_to_string(octet_out_result.result));
+        RTNO_WARN(logger, "[TEST] Skipping Octet data test. octet_in or octet_out port not found. in({}), out({})", ssr::rtno2::result_to_string(octet_in_result.error()), ssr::rtno2::result_to_string(octet_out_result.error()));
     }
 
     // Long test
     auto long_in_result = profile.inport("long_in");
     auto long_out_result = profile.outport("long_out");
-    if (long_in_result.result == ssr::rtno2::RESULT::OK && long_out_result.result == ssr::rtno2::RESULT::OK)
+    if (long_in_result.error() == ssr::rtno2::RESULT::OK && long_out_result.error() == ssr::rtno2::RESULT::OK)
     {
         conduct_send_and_recv_test<int32_t>("Long positive data test. Send 3 then recv it", logger, protocol, "long_in", "long_out", 1, 3);
         conduct_send_and_recv_test<int32_t>("Long negative data test. Send -3 then recv it", logger, protocol, "long_in", "long_out", 1, -3);
     }
     else
     {
-        RTNO_WARN(logger, "[TEST] Skipping Long data test. long_in or long_out port not found. in({}), out({})", ssr::rtno2::result_to_string(long_in_result.result), ssr::rtno2::result_to_string(long_out_result.result));
+        RTNO_WARN(logger, "[TEST] Skipping Long data test. long_in or long_out port not found. in({}), out({})", ssr::rtno2::result_to_string(long_in_result.error()), ssr::rtno2::result_to_string(long_out_result.error()));
     }
     // Float test
     auto float_in_result = profile.inport("float_in");
     auto float_out_result = profile.outport("float_out");
-    if (float_in_result.result == ssr::rtno2::RESULT::OK && float_out_result.result == ssr::rtno2::RESULT::OK)
+    if (float_in_result.error() == ssr::rtno2::RESULT::OK && float_out_result.error() == ssr::rtno2::RESULT::OK)
     {
         conduct_send_and_recv_test<float>("Float positive data test. Send 3.0f then recv it", logger, protocol, "float_in", "float_out", 1.0f, 3.0f);
     }
     else
     {
-        RTNO_WARN(logger, "[TEST] Skipping Float data test. float_in or float_out port not found. in({}), out({})", ssr::rtno2::result_to_string(float_in_result.result), ssr::rtno2::result_to_string(float_out_result.result));
+        RTNO_WARN(logger, "[TEST] Skipping Float data test. float_in or float_out port not found. in({}), out({})", ssr::rtno2::result_to_string(float_in_result.error()), ssr::rtno2::result_to_string(float_out_result.error()));
     }
     // Double test
     auto double_in_result = profile.inport("double_in");
     auto double_out_result = profile.outport("double_out");
-    if (double_in_result.result == ssr::rtno2::RESULT::OK && double_out_result.result == ssr::rtno2::RESULT::OK)
+    if (double_in_result.error() == ssr::rtno2::RESULT::OK && double_out_result.error() == ssr::rtno2::RESULT::OK)
     {
         conduct_send_and_recv_test<double>("Double positive data test. Send 3.0 then recv it", logger, protocol, "double_in", "double_out", 1.0, 3.0);
     }
     else
     {
-        RTNO_WARN(logger, "[TEST] Skipping Double data test. double_in or double_out port not found. in({}), out({})", ssr::rtno2::result_to_string(double_in_result.result), ssr::rtno2::result_to_string(double_out_result.result));
+        RTNO_WARN(logger, "[TEST] Skipping Double data test. double_in or double_out port not found. in({}), out({})", ssr::rtno2::result_to_string(double_in_result.error()), ssr::rtno2::result_to_string(double_out_result.error()));
     }
     // BoolSeq test
     auto boolseq_in_result = profile.inport("bool_seq_in");
     auto boolseq_out_result = profile.outport("bool_seq_out");
-    if (boolseq_in_result.result == ssr::rtno2::RESULT::OK && boolseq_out_result.result == ssr::rtno2::RESULT::OK)
+    if (boolseq_in_result.error() == ssr::rtno2::RESULT::OK && boolseq_out_result.error() == ssr::rtno2::RESULT::OK)
     {
         conduct_seq_send_and_recv_test<bool>("BoolSeq data test. Send true then recv it", logger, protocol, "bool_seq_in", "bool_seq_out", {false}, {true, true});
         conduct_seq_send_and_recv_test<bool>("BoolSeq negative data test. Send false then recv it", logger, protocol, "bool_seq_in", "bool_seq_out", {false}, {false, false});
     }
     else
     {
-        RTNO_WARN(logger, "[TEST] Skipping BoolSeq data test. bool_seq_in or bool_seq_out port not found. in({}), out({})", ssr::rtno2::result_to_string(boolseq_in_result.result), ssr::rtno2::result_to_string(boolseq_out_result.result));
+        RTNO_WARN(logger, "[TEST] Skipping BoolSeq data test. bool_seq_in or bool_seq_out port not found. in({}), out({})", ssr::rtno2::result_to_string(boolseq_in_result.error()), ssr::rtno2::result_to_string(boolseq_out_result.error()));
     }
     // CharSeq test
     auto charseq_in_result = profile.inport("char_seq_in");
     auto charseq_out_result = profile.outport("char_seq_out");
-    if (charseq_in_result.result == ssr::rtno2::RESULT::OK && charseq_out_result.result == ssr::rtno2::RESULT::OK)
+    if (charseq_in_result.error() == ssr::rtno2::RESULT::OK && charseq_out_result.error() == ssr::rtno2::RESULT::OK)
     {
         conduct_seq_send_and_recv_test<char>("CharacterSeq data test. Send 'abc' then recv it", logger, protocol, "char_seq_in", "char_seq_out", {'a'}, {'a', 'b', 'c'});
     }
     else
     {
-        RTNO_WARN(logger, "[TEST] Skipping CharacterSeq data test. char_seq_in or char_seq_out port not found. in({}), out({})", ssr::rtno2::result_to_string(charseq_in_result.result), ssr::rtno2::result_to_string(charseq_out_result.result));
+        RTNO_WARN(logger, "[TEST] Skipping CharacterSeq data test. char_seq_in or char_seq_out port not found. in({}), out({})", ssr::rtno2::result_to_string(charseq_in_result.error()), ssr::rtno2::result_to_string(charseq_out_result.error()));
     }
     // OctetSeq test
     auto octetseq_in_result = profile.inport("octet_seq_in");
     auto octetseq_out_result = profile.outport("octet_seq_out");
-    if (octetseq_in_result.result == ssr::rtno2::RESULT::OK && octetseq_out_result.result == ssr::rtno2::RESULT::OK)
+    if (octetseq_in_result.error() == ssr::rtno2::RESULT::OK && octetseq_out_result.error() == ssr::rtno2::RESULT::OK)
     {
         conduct_seq_send_and_recv_test<uint8_t>("OctetSeq data test. Send 0x32,0x33,0x34 then recv it", logger, protocol, "octet_seq_in", "octet_seq_out", {0x01}, {0x12, 0x13});
     }
     else
     {
-        RTNO_WARN(logger, "[TEST] Skipping OctetSeq data test. octet_seq_in or octet_seq_out port not found. in({}), out({})", ssr::rtno2::result_to_string(octetseq_in_result.result), ssr::rtno2::result_to_string(octetseq_out_result.result));
+        RTNO_WARN(logger, "[TEST] Skipping OctetSeq data test. octet_seq_in or octet_seq_out port not found. in({}), out({})", ssr::rtno2::result_to_string(octetseq_in_result.error()), ssr::rtno2::result_to_string(octetseq_out_result.error()));
     }
     // LongSeq test
     auto longseq_in_result = profile.inport("long_seq_in");
     auto longseq_out_result = profile.outport("long_seq_out");
-    if (longseq_in_result.result == ssr::rtno2::RESULT::OK && longseq_out_result.result == ssr::rtno2::RESULT::OK)
+    if (longseq_in_result.error() == ssr::rtno2::RESULT::OK && longseq_out_result.error() == ssr::rtno2::RESULT::OK)
     {
         conduct_seq_send_and_recv_test<int32_t>("LongSeq positive single element vector test. Send {3} then recv it", logger, protocol, "long_seq_in", "long_seq_out", {1}, {3});
         conduct_seq_send_and_recv_test<int32_t>("LongSeq positive vector test. Send {3, 2, 1} then recv it", logger, protocol, "long_seq_in", "long_seq_out", {1}, {3, 2, 1});
     }
     else
     {
-        RTNO_WARN(logger, "[TEST] Skipping LongSeq data test. long_seq_in or long_seq_out port not found. in({}), out({})", ssr::rtno2::result_to_string(longseq_in_result.result), ssr::rtno2::result_to_string(longseq_out_result.result));
+        RTNO_WARN(logger, "[TEST] Skipping LongSeq data test. long_seq_in or long_seq_out port not found. in({}), out({})", ssr::rtno2::result_to_string(longseq_in_result.error()), ssr::rtno2::result_to_string(longseq_out_result.error()));
     }
     // FloatSeq test
     auto floatseq_in_result = profile.inport("float_seq_in");
     auto floatseq_out_result = profile.outport("float_seq_out");
-    if (floatseq_in_result.result == ssr::rtno2::RESULT::OK && floatseq_out_result.result == ssr::rtno2::RESULT::OK)
+    if (floatseq_in_result.error() == ssr::rtno2::RESULT::OK && floatseq_out_result.error() == ssr::rtno2::RESULT::OK)
     {
         conduct_seq_send_and_recv_test<float>("FloatSeq positive single element vector test. Send {3.0f} then recv it", logger, protocol, "float_seq_in", "float_seq_out", {1.0f}, {3.0f});
         conduct_seq_send_and_recv_test<float>("FloatSeq positive vector test. Send {3.0f, 2.0f, 1.0f} then recv it", logger, protocol, "float_seq_in", "float_seq_out", {1.0f}, {3.0f, 2.0f, 1.0f});
     }
     else
     {
-        RTNO_WARN(logger, "[TEST] Skipping FloatSeq data test. float_seq_in or float_seq_out port not found. in({}), out({})", ssr::rtno2::result_to_string(floatseq_in_result.result), ssr::rtno2::result_to_string(floatseq_out_result.result));
+        RTNO_WARN(logger, "[TEST] Skipping FloatSeq data test. float_seq_in or float_seq_out port not found. in({}), out({})", ssr::rtno2::result_to_string(floatseq_in_result.error()), ssr::rtno2::result_to_string(floatseq_out_result.error()));
     }
     // DoubleSeq test
     auto doubleseq_in_result = profile.inport("double_seq_in");
     auto doubleseq_out_result = profile.outport("double_seq_out");
-    if (doubleseq_in_result.result == ssr::rtno2::RESULT::OK && doubleseq_out_result.result == ssr::rtno2::RESULT::OK)
+    if (doubleseq_in_result.error() == ssr::rtno2::RESULT::OK && doubleseq_out_result.error() == ssr::rtno2::RESULT::OK)
     {
         conduct_seq_send_and_recv_test<double>("DoubleSeq positive single element vector test. Send {3.0} then recv it", logger, protocol, "double_seq_in", "double_seq_out", {1.0}, {3.0});
         conduct_seq_send_and_recv_test<double>("DoubleSeq positive vector test. Send {3.0, 2.0, 1.0} then recv it", logger, protocol, "double_seq_in", "double_seq_out", {1.0}, {3.0, 2.0, 1.0});
     }
     else
     {
-        RTNO_WARN(logger, "[TEST] Skipping DoubleSeq data test. double_seq_in or double_seq_out port not found. in({}), out({})", ssr::rtno2::result_to_string(doubleseq_in_result.result), ssr::rtno2::result_to_string(doubleseq_out_result.result));
+        RTNO_WARN(logger, "[TEST] Skipping DoubleSeq data test. double_seq_in or double_seq_out port not found. in({}), out({})", ssr::rtno2::result_to_string(doubleseq_in_result.error()), ssr::rtno2::result_to_string(doubleseq_out_result.error()));
     }
     std::this_thread::sleep_for(std::chrono::milliseconds(100));
     RTNO_INFO(logger, "[TEST] All tests done.");
@@ -33,14 +33,14 @@ ssr::rtno2::RESULT do_send_and_recv_test(ssr::rtno2::logger_t &logger, ssr::rtno
         ssr::rtno2::RESULT result;
         {
             auto v = protocol.receive_as<T>(outport_name, wait_usec, try_count);
-            if (v.result != ssr::rtno2::RESULT::OK)
+            if (v.error() != ssr::rtno2::RESULT::OK)
             {
-                RTNO_ERROR(logger, "receive_as('{}') failed({})", outport_name, ssr::rtno2::result_to_string(v.result));
-                return v.result;
+                RTNO_ERROR(logger, "receive_as('{}') failed({})", outport_name, ssr::rtno2::result_to_string(v.error()));
+                return v.error();
             }
-            if (v.value.value() != initial_data)
+            if (*v != initial_data)
             {
-                RTNO_ERROR(logger, "received value is invalid ({} != {})", initial_data, v.value.value());
+                RTNO_ERROR(logger, "received value is invalid ({} != {})", initial_data, *v);
                 return ssr::rtno2::RESULT::ERR;
             }
         }
@@ -57,14 +57,14 @@ ssr::rtno2::RESULT do_send_and_recv_test(ssr::rtno2::logger_t &logger, ssr::rtno
         }
         {
             auto v = protocol.receive_as<T>(outport_name, wait_usec, try_count);
-            if (v.result != ssr::rtno2::RESULT::OK)
+            if (v.error() != ssr::rtno2::RESULT::OK)
             {
-                RTNO_ERROR(logger, "receive_as('{}') failed({})", outport_name, ssr::rtno2::result_to_string(v.result));
-                return v.result;
+                RTNO_ERROR(logger, "receive_as('{}') failed({})", outport_name, ssr::rtno2::result_to_string(v.error()));
+                return v.error();
             }
-            if (v.value.value() != send_data)
+            if (*v != send_data)
             {
-                RTNO_ERROR(logger, "received value is invalid ({} != {})", send_data, v.value.value());
+                RTNO_ERROR(logger, "received value is invalid ({} != {})", send_data, *v);
                 return ssr::rtno2::RESULT::ERR;
             }
         }
@@ -145,14 +145,14 @@ ssr::rtno2::RESULT do_seq_send_and_recv_test(ssr::rtno2::logger_t &logger, ssr::
     ssr::rtno2::RESULT result;
     {
         auto v = protocol.receive_seq_as<T>(outport_name, wait_usec, try_count);
-        if (v.result != ssr::rtno2::RESULT::OK)
+        if (v.error() != ssr::rtno2::RESULT::OK)
         {
-            RTNO_ERROR(logger, "  [FAILED] receive_seq_as('{}') failed({})", outport_name, ssr::rtno2::result_to_string(v.result));
-            return v.result;
+            RTNO_ERROR(logger, "  [FAILED] receive_seq_as('{}') failed({})", outport_name, ssr::rtno2::result_to_string(v.error()));
+            return v.error();
         }
-        if (!seq_equal(v.value.value(), initial_data))
+        if (!seq_equal(*v, initial_data))
         {
-            RTNO_ERROR(logger, "  [FAILED] received value is invalid ({} != {})", vec_to_str(initial_data), vec_to_str(v.value.value()));
+            RTNO_ERROR(logger, "  [FAILED] received value is invalid ({} != {})", vec_to_str(initial_data), vec_to_str(*v));
             return ssr::rtno2::RESULT::ERR;
         }
     }
@@ -169,14 +169,14 @@ ssr::rtno2::RESULT do_seq_send_and_recv_test(ssr::rtno2::logger_t &logger, ssr::
     }
     {
         auto v = protocol.receive_seq_as<T>(outport_name, wait_usec, try_count);
-        if (v.result != ssr::rtno2::RESULT::OK)
+        if (v.error() != ssr::rtno2::RESULT::OK)
         {
-            RTNO_ERROR(logger, "  [FAILED] receive_seq_as('{}') failed({})", outport_name, ssr::rtno2::result_to_string(v.result));
-            return v.result;
+            RTNO_ERROR(logger, "  [FAILED] receive_seq_as('{}') failed({})", outport_name, ssr::rtno2::result_to_string(v.error()));
+            return v.error();
         }
-        if (!seq_equal(v.value.value(), send_data))
+        if (!seq_equal(*v, send_data))
         {
-            RTNO_ERROR(logger, "  [FAILED] received value is invalid ({} != {})", vec_to_str(send_data), vec_to_str(v.value.value()));
+            RTNO_ERROR(logger, "  [FAILED] received value is invalid ({} != {})", vec_to_str(send_data), vec_to_str(*v));
             return ssr::rtno2::RESULT::ERR;
         }
     }